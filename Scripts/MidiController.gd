@@ -9,7 +9,11 @@ extends Node
 signal beat(beat_number: int)
 signal note_triggered(note: int, velocity: float)
 signal cc_changed(control: int, value: float)
+## NRPN (registered = false) or RPN change, value normalized to 0..1
+signal parameter_changed(parameter: int, value: float, registered: bool)
 signal clock_tick()
+## The list of MIDI input ports changed (device plugged in or removed)
+signal ports_changed()
 signal transport_start()
 signal transport_stop()
 
@@ -27,10 +31,37 @@ const TICK_AVERAGE_COUNT = 24  # Average over one beat for stable BPM
 
 @export var midi_port: int = -1  # -1 = no port selected
 @export var auto_connect: bool = false
+## Emit cc_changed once per frame with each controller's latest value
+## (read from the extension's state table) instead of once per message
+@export var coalesce_cc_per_frame: bool = true
+## MSB controllers (0-31) whose LSB (controller + 32) should be merged into
+## a single 14-bit cc_changed instead of two 7-bit ones. Only for an input
+## of this controller's own (midi_file); the shared hub input takes them
+## from the rtmidi/hub/high_resolution_ccs project setting
+@export var high_resolution_ccs: Array[int] = []
+## Run the extension's MIDI thread with realtime (FIFO) scheduling at this
+## priority, 1-99; 0 keeps normal scheduling. Needs rtprio permission and
+## falls back to normal scheduling without it. Only for an input of this
+## controller's own; the hub uses rtmidi/hub/realtime_priority
+@export var realtime_priority: int = 0
+## Play this Standard MIDI File instead of listening to a device. It goes
+## through the extension's loopback into the same input, so it arrives
+## exactly like live MIDI, clock and transport included
+@export_file("*.mid", "*.midi") var midi_file: String = ""
 
 # RtMidi extension (if available)
 var midi_in = null
+# Where messages are read from: a subscriber of the shared RtMidiHub, or
+# midi_in itself when the controller owns its connection
+var midi_reader = null
 var using_rtmidi: bool = false
+var using_native_clock: bool = false  # BPM/beat phase tracked by the extension
+var using_native_cc: bool = false  # cc_changed driven by the extension's state table
+var cc_state_seq: int = 0
+# Plays midi_file into midi_in over the loopback API
+var midi_file_out = null
+# Maps message timestamps onto the engine clock (GodotRtMidiTimeMap)
+var time_map = null
 
 # Godot built-in MIDI fallback
 var using_godot_midi: bool = false
@@ -44,17 +75,29 @@ func _ready() -> void:
 
 
 func _try_init_rtmidi() -> void:
-	# Try to use RtMidi GDExtension if available
-	if not ClassDB.class_exists("GodotRtMidiIn"):
-		print("MidiController: RtMidi GDExtension not available")
-		return
+	# Prefer the process-wide hub, so every scene shares one device
+	# connection and input thread. A file player needs an input of its own.
+	if midi_file.is_empty() and Engine.has_singleton("RtMidiHub"):
+		var hub = Engine.get_singleton("RtMidiHub")
+		midi_in = hub.get_input()
+		if midi_in != null:
+			midi_reader = hub.subscribe()
 
-	# ClassDB may report the class exists even if the native library failed to load
-	# (e.g. release binary missing). Wrap instantiation to catch failures.
-	midi_in = ClassDB.instantiate("GodotRtMidiIn")
 	if midi_in == null:
-		print("MidiController: RtMidi class exists but instantiation failed (missing native library?)")
-		return
+		# Try to use RtMidi GDExtension if available
+		if not ClassDB.class_exists("GodotRtMidiIn"):
+			print("MidiController: RtMidi GDExtension not available")
+			return
+
+		# ClassDB may report the class exists even if the native library failed to load
+		# (e.g. release binary missing). Wrap instantiation to catch failures.
+		midi_in = ClassDB.instantiate("GodotRtMidiIn")
+		if midi_in == null:
+			print("MidiController: RtMidi class exists but instantiation failed (missing native library?)")
+			return
+		midi_reader = midi_in
+		if not midi_file.is_empty() and midi_in.has_method("set_api"):
+			midi_in.set_api("dummy")
 
 	# Verify the instance actually works by calling a method
 	var port_count: int = -1
@@ -63,18 +106,50 @@ func _try_init_rtmidi() -> void:
 	else:
 		print("MidiController: RtMidi instance missing expected methods, disabling")
 		midi_in = null
+		midi_reader = null
 		return
 
 	using_rtmidi = true
+	using_native_clock = midi_in.has_method("get_beat_position")
+	using_native_cc = coalesce_cc_per_frame and midi_in.has_method("get_changed_ccs")
+	if midi_reader == midi_in:
+		_configure_own_input()
+	elif not high_resolution_ccs.is_empty() or realtime_priority > 0:
+		# The hub input is shared by every scene; configure it once in
+		# the project settings instead
+		push_warning("MidiController: high_resolution_ccs and realtime_priority are ignored on the shared hub input; set rtmidi/hub/* in the project settings")
+	if midi_in.has_signal("ports_changed"):
+		midi_in.ports_changed.connect(_on_rtmidi_ports_changed)
+	if ClassDB.class_exists("GodotRtMidiTimeMap"):
+		time_map = ClassDB.instantiate("GodotRtMidiTimeMap")
+		time_map.set_input(midi_in)
 	print("MidiController: Using RtMidi GDExtension (%d ports)" % port_count)
 
-	if auto_connect and port_count > 0:
+	if not midi_file.is_empty():
+		play_midi_file(midi_file)
+		return
+
+	# A port opened by another scene through the hub is already shared
+	if auto_connect and port_count > 0 and not midi_in.is_port_open():
 		if midi_port >= 0:
 			open_port(midi_port)
 		else:
 			open_port(0)
 
 
+# Settings of an input only this controller reads
+func _configure_own_input() -> void:
+	if midi_in.has_method("set_cc14_pairing"):
+		for control in high_resolution_ccs:
+			midi_in.set_cc14_pairing(control, true)
+	# Only the final value of each controller per frame is needed
+	if coalesce_cc_per_frame and midi_in.has_method("set_cc_coalescing") and not midi_in.is_port_open():
+		midi_in.set_cc_coalescing(true)
+	if realtime_priority > 0 and midi_in.has_method("set_thread_priority"):
+		midi_in.set_thread_priority(1, realtime_priority)  # THREAD_FIFO
+		midi_in.set_memory_locked(true)
+
+
 func _init_godot_midi() -> void:
 	# Fall back to Godot's built-in MIDI
 	# Defer opening so the engine is fully initialized
@@ -85,19 +160,49 @@ func _init_godot_midi() -> void:
 
 
 func _process(_delta: float) -> void:
+	if time_map:
+		time_map.update()
 	if using_rtmidi and midi_in and midi_in.is_port_open():
 		_poll_rtmidi_messages()
+		if using_native_cc:
+			_emit_changed_ccs()
 	# Godot MIDI is handled via _input()
 
 
 func _poll_rtmidi_messages() -> void:
-	while midi_in.has_message():
-		var msg: Dictionary = midi_in.poll_message()
+	# Bulk drain: one native call per frame instead of one per message
+	if midi_reader.has_method("drain_messages"):
+		var drained: Dictionary = midi_reader.drain_messages()
+		var bytes: PackedByteArray = drained.bytes
+		var timestamps: PackedFloat64Array = drained.timestamps
+		var kinds: PackedByteArray = drained.get("kinds", PackedByteArray())
+		for i in drained.count:
+			if not kinds.is_empty() and kinds[i] != 0:
+				_handle_param_message(kinds[i], bytes[i * 3] & 0x0F, drained.params[i], drained.values[i])
+				continue
+			_handle_midi_message(bytes[i * 3], bytes[i * 3 + 1], bytes[i * 3 + 2], timestamps[i])
+		return
+
+	while midi_reader.has_message():
+		var msg: Dictionary = midi_reader.poll_message()
 		if msg.is_empty():
 			break
+		if msg.has("kind"):
+			_handle_param_message(msg.kind, msg.status & 0x0F, msg.param, msg.value)
+			continue
 		_handle_midi_message(msg.status, msg.data1, msg.data2, msg.timestamp)
 
 
+func _emit_changed_ccs() -> void:
+	var seq: int = midi_in.get_state_sequence()
+	if seq == cc_state_seq:
+		return
+	var changed: PackedInt32Array = midi_in.get_changed_ccs(cc_state_seq)
+	cc_state_seq = seq
+	for slot in changed:
+		cc_changed.emit(slot & 0x7F, midi_in.get_cc(slot >> 7, slot & 0x7F))
+
+
 func _input(event: InputEvent) -> void:
 	if not using_godot_midi:
 		return
@@ -106,7 +211,7 @@ func _input(event: InputEvent) -> void:
 		var midi_event := event as InputEventMIDI
 		var status := (midi_event.message << 4) | midi_event.channel
 		_handle_midi_message(status, midi_event.pitch, midi_event.velocity,
-			Time.get_ticks_msec() / 1000.0)
+			Time.get_ticks_usec() / 1000000.0)
 
 
 func _handle_midi_message(status: int, data1: int, data2: int, timestamp: float) -> void:
@@ -123,7 +228,8 @@ func _handle_midi_message(status: int, data1: int, data2: int, timestamp: float)
 		0x8:  # Note Off
 			note_triggered.emit(data1, 0.0)
 		0xB:  # Control Change
-			cc_changed.emit(data1, data2 / 127.0)
+			if not using_native_cc:
+				cc_changed.emit(data1, data2 / 127.0)
 		0xF:  # System messages
 			match status:
 				0xF8:  # Clock
@@ -142,14 +248,32 @@ func _handle_midi_message(status: int, data1: int, data2: int, timestamp: float)
 					transport_start.emit()
 
 
+## Hotplug from the extension: indices may have shifted, and the open port
+## may have been lost or reconnected
+func _on_rtmidi_ports_changed() -> void:
+	midi_port = -1
+	if midi_in.is_port_open():
+		midi_port = Array(midi_in.get_port_names()).find(midi_in.get_open_port_name())
+	ports_changed.emit()
+
+
+## Merged 14-bit events from the extension: kind 1 = CC pair, 2 = NRPN, 3 = RPN
+func _handle_param_message(kind: int, _channel: int, param: int, value: int) -> void:
+	if kind == 1:
+		if not using_native_cc:
+			cc_changed.emit(param, value / 16383.0)
+	else:
+		parameter_changed.emit(param, value / 16383.0, kind == 3)
+
+
 func _handle_clock(timestamp: float) -> void:
 	clock_tick.emit()
 
 	if not is_playing:
 		return
 
-	# Calculate tick interval for BPM
-	if last_tick_time > 0:
+	# Calculate tick interval for BPM (the extension does this natively)
+	if not using_native_clock and last_tick_time > 0:
 		var interval := timestamp - last_tick_time
 		tick_times.append(interval)
 		if tick_times.size() > TICK_AVERAGE_COUNT:
@@ -172,16 +296,37 @@ func _handle_clock(timestamp: float) -> void:
 
 ## Get the current BPM calculated from MIDI clock
 func get_bpm() -> float:
+	if using_native_clock:
+		return midi_in.get_bpm()
 	if tick_interval <= 0:
 		return 0.0
 	return 60.0 / (tick_interval * TICKS_PER_BEAT)
 
 
 ## Get the current beat position (beat + fractional position within beat)
+## With the extension this is interpolated between clock ticks at call time
 func get_beat_position() -> float:
+	if using_native_clock:
+		return midi_in.get_beat_position()
 	return beat_count + (clock_count / float(TICKS_PER_BEAT))
 
 
+## Convert a message timestamp to Time.get_ticks_usec() seconds, the clock
+## the built-in MIDI fallback stamps messages with, so events from either
+## source can be placed on the render timeline
+func to_engine_time(timestamp: float) -> float:
+	if time_map:
+		return time_map.to_engine_time(timestamp)
+	return timestamp
+
+
+## Get the latest value (0..1) of a controller
+func get_cc(control: int, channel: int = 0) -> float:
+	if using_rtmidi and midi_in and midi_in.has_method("get_cc"):
+		return midi_in.get_cc(channel, control)
+	return 0.0
+
+
 ## Get available MIDI input ports
 func get_available_ports() -> PackedStringArray:
 	if using_rtmidi and midi_in:
@@ -222,7 +367,18 @@ func open_port(port: int) -> Error:
 	return ERR_UNCONFIGURED
 
 
-## Close the current MIDI port
+## Listen to one more MIDI input port on the same connection, e.g. a fader
+## box next to the clock source. Returns the source id, or -1
+func add_port(port: int) -> int:
+	if using_rtmidi and midi_in and midi_in.has_method("add_source"):
+		var source: int = midi_in.add_source(port)
+		if source >= 0 and midi_port < 0:
+			midi_port = port
+		return source
+	return -1
+
+
+## Close the current MIDI port (for every scene, when shared through the hub)
 func close_port() -> void:
 	if using_rtmidi and midi_in:
 		midi_in.close_port()
@@ -234,6 +390,37 @@ func close_port() -> void:
 	tick_times.clear()
 
 
+## Play a Standard MIDI File into the input from the start. The input must
+## be on the loopback API, which setting midi_file before _ready() arranges
+func play_midi_file(path: String) -> Error:
+	if not using_rtmidi or not ClassDB.class_exists("GodotRtMidiOut"):
+		return ERR_UNAVAILABLE
+	if midi_file_out == null:
+		midi_file_out = ClassDB.instantiate("GodotRtMidiOut")
+		midi_file_out.set_api("dummy")
+		var opened: Error = midi_file_out.open_virtual_port("MIDI File")
+		if opened != OK:
+			midi_file_out = null
+			return opened
+
+	var result: Error = midi_file_out.open_file(path)
+	if result != OK:
+		return result
+	if not midi_in.is_port_open():
+		var port := Array(midi_in.get_port_names()).find("MIDI File")
+		result = open_port(port) if port >= 0 else ERR_CANT_OPEN
+		if result != OK:
+			return result
+	midi_file = path
+	return midi_file_out.play_file()
+
+
+## Stop MIDI file playback (pending notes are released)
+func stop_midi_file() -> void:
+	if midi_file_out:
+		midi_file_out.stop_file()
+
+
 ## Check if a MIDI port is currently open
 func is_port_open() -> bool:
 	if using_rtmidi and midi_in:
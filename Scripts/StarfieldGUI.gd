@@ -265,6 +265,7 @@ func _setup_midi_section(vbox: VBoxContainer) -> void:
 
 	if midi_controller:
 		midi_controller.clock_tick.connect(_on_midi_activity)
+		midi_controller.ports_changed.connect(_refresh_midi_ports)
 		midi_controller.note_triggered.connect(func(_n, _v): _on_midi_activity())
 		midi_controller.cc_changed.connect(func(_c, _v): _on_midi_activity())
 
@@ -33,8 +33,12 @@
 /**********************************************************************/
 
 #include "RtMidi.h"
+#include <algorithm>
+#include <atomic>
 #include <sstream>
 #include <cstring>
+#include <chrono>
+#include <mutex>
 
 #if defined(__MACOSX_CORE__)
   #include <CoreMIDI/CoreMIDI.h>
@@ -44,6 +48,13 @@
 
 #if defined(__LINUX_ALSA__)
   #include <alsa/asoundlib.h>
+  #include <cerrno>
+  #include <cstdio>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <unistd.h>
 #endif
 
 #if defined(__WINDOWS_MM__)
@@ -51,6 +62,52 @@
   #include <mmsystem.h>
 #endif
 
+// Length in bytes of a MIDI 1.0 message with the given status byte, or 0
+// for SysEx (variable length) and undefined statuses.
+static inline size_t expectedMessageSize(unsigned char status)
+{
+  switch (status >> 4) {
+    case 0x8: case 0x9: case 0xA: case 0xB: case 0xE:
+      return 3;
+    case 0xC: case 0xD:
+      return 2;
+    case 0xF:
+      switch (status) {
+        case 0xF1: case 0xF3: return 2;
+        case 0xF2: return 3;
+        case 0xF6: case 0xF8: case 0xF9: case 0xFA:
+        case 0xFB: case 0xFC: case 0xFE: case 0xFF:
+          return 1;
+        default:
+          return 0;
+      }
+    default:
+      return 0;
+  }
+}
+
+unsigned int RtMidiFilter::typeBit(unsigned char status)
+{
+  if (status < 0x80) return 0;
+  if (status < 0xF0) return 1u << ((status >> 4) - 0x8);
+
+  switch (status) {
+    case 0xF0: return SYSEX;
+    case 0xF1: return TIME_CODE;
+    case 0xF2: return SONG_POSITION;
+    case 0xF3: return SONG_SELECT;
+    case 0xF6: return TUNE_REQUEST;
+    case 0xF8: return CLOCK;
+    case 0xF9: return TICK;
+    case 0xFA: return START;
+    case 0xFB: return CONTINUE;
+    case 0xFC: return STOP;
+    case 0xFE: return ACTIVE_SENSING;
+    case 0xFF: return RESET;
+    default:   return 0;
+  }
+}
+
 // **************************************************************** //
 //
 // MidiApi class definitions.
@@ -71,6 +128,9 @@ public:
   virtual void setPortName(const std::string &portName) = 0;
   virtual unsigned int getPortCount() = 0;
   virtual std::string getPortName(unsigned int portNumber) = 0;
+  // Default implementations fall back to the indexed calls
+  virtual void getPorts(std::vector<RtMidiPortInfo> &ports);
+  virtual void openPortAddress(int client, int port, const std::string &portName);
 
   bool isPortOpen() const { return connected_; }
   void setErrorCallback(RtMidiErrorCallback errorCallback, void *userData);
@@ -99,6 +159,30 @@ void MidiApi::setErrorCallback(RtMidiErrorCallback errorCallback, void *userData
   errorCallbackUserData_ = userData;
 }
 
+void MidiApi::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  ports.clear();
+  unsigned int count = getPortCount();
+  for (unsigned int i = 0; i < count; i++) {
+    RtMidiPortInfo info;
+    info.name = getPortName(i);
+    info.client = -1;
+    info.port = (int)i;
+    info.capabilities = 0;
+    ports.push_back(info);
+  }
+}
+
+void MidiApi::openPortAddress(int client, int port, const std::string &portName)
+{
+  if (client >= 0 || port < 0) {
+    errorString_ = "MidiApi::openPortAddress: invalid port address for this API!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+  openPort((unsigned int)port, portName);
+}
+
 void MidiApi::error(RtMidiError::Type type, std::string errorString)
 {
   if (errorCallback_) {
@@ -133,12 +217,55 @@ public:
   MidiInApi(unsigned int queueSizeLimit);
   virtual ~MidiInApi();
   void setCallback(RtMidiCallback callback, void *userData);
+  void setTimestampCallback(RtMidiTimestampCallback callback, void *userData);
+  void setRawCallback(RtMidiRawCallback callback, void *userData);
+  void setBatchCallback(RtMidiBatchCallback callback, void *userData);
   void cancelCallback();
+  // Backends that can watch for port changes override this.
+  virtual bool setPortCallback(RtMidiPortCallback, void *) { return false; }
+  // Backends that run their own input thread override this; they call
+  // applyThreadOptions() on that thread as it starts.
+  virtual bool setThreadOptions(const RtMidiThreadOptions &) { return false; }
+  unsigned int getThreadStatus() const { return threadStatus_.load(std::memory_order_relaxed); }
+  void applyThreadOptions();
+  // Current time of the clock events are stamped with, on the timeNs
+  // scale.  Backends whose driver stamps events override this.
+  virtual unsigned long long driverTimeNs() { return monotonicNanos(); }
+  // The default supports a single source, opened with openPortAddress().
+  virtual int addSource(int client, int port, int sourceId, const std::string &portName);
+  virtual void removeSource(int sourceId);
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
   virtual void ignoreTypes(bool midiSysex, bool midiTime, bool midiSense);
+  virtual void setFilter(const RtMidiFilter &filter);
+  RtMidiFilter getFilter() const;
   double getMessage(std::vector<unsigned char> *message);
 
+  // Early reject against the current filter.  Also tracks transport
+  // state, so it must see every message (including rejected ones) in
+  // arrival order.  Input thread only.
+  bool acceptsMessage(const unsigned char *data, unsigned int size);
+
+  // Hand a decoded event to the user callback or the input queue.
+  // event.timeNs must be the absolute monotonic arrival time; the delta
+  // time is derived here from the previous event.  Does not allocate
+  // once the SysEx buffers have reached their steady-state size.
+  void deliverEvent(RtMidiEvent &event);
+
+  // Hand any batched events to the batch callback.  Backends call this
+  // once the driver has nothing more pending.
+  void flushBatch();
+
+  static void setEventBytes(RtMidiEvent &event, unsigned int size,
+                            unsigned char b0, unsigned char b1 = 0, unsigned char b2 = 0);
+  static unsigned long long monotonicNanos();
+
+  // Fixed-capacity storage that SysEx messages are reassembled into.
+  enum { SYSEX_POOL_SIZE = 8192 };
+
   struct MidiMessage {
-    std::vector<unsigned char> bytes;
+    unsigned char bytes[3];
+    unsigned int size;                // 0 when the message lives in sysex
+    std::vector<unsigned char> sysex;
     double timeStamp;
   };
 
@@ -153,20 +280,49 @@ public:
 
   MidiQueue inputQueue_;
   RtMidiCallback userCallback_;
+  RtMidiTimestampCallback userTimestampCallback_;
+  RtMidiRawCallback userRawCallback_;
+  RtMidiBatchCallback userBatchCallback_;
   void *userCallbackData_;
-  bool ignoreFlags_[3];
+  // Filter fields are written by the user thread and read by the input
+  // thread, so they are kept as individual atomics.
+  std::atomic<bool> ignoreFlags_[3];  // sysex, timing, sense
+  std::atomic<unsigned int> filterTypes_;
+  std::atomic<unsigned int> filterChannels_;
+  std::atomic<unsigned int> filterNotes_;   // noteLow | noteHigh << 8
+  std::atomic<bool> filterClockWhileStopped_;
+  std::atomic<bool> transportRunning_;
+  unsigned char eventSource_;         // source id stamped on delivered events
+  RtMidiThreadOptions threadOptions_;  // only changed while the input thread is stopped
+  std::atomic<unsigned int> threadStatus_;
+  bool firstMessage_;
+  unsigned long long lastTimeNs_;
+  std::vector<unsigned char> sysexPool_;
+  std::vector<unsigned char> callbackMessage_;
+  RtMidiEvent batch_[RtMidiIn::BATCH_SIZE];
+  unsigned int batchCount_;
+
+private:
+  bool hasCallback() const { return userCallback_ || userTimestampCallback_ || userRawCallback_ || userBatchCallback_; }
 };
 
 MidiInApi::MidiInApi(unsigned int queueSizeLimit)
-  : MidiApi(), userCallback_(nullptr), userCallbackData_(nullptr)
+  : MidiApi(), userCallback_(nullptr), userTimestampCallback_(nullptr), userRawCallback_(nullptr),
+    userBatchCallback_(nullptr), userCallbackData_(nullptr), filterTypes_(RtMidiFilter::ALL_TYPES), filterChannels_(0xFFFF),
+    filterNotes_(127 << 8), filterClockWhileStopped_(true), transportRunning_(false),
+    eventSource_(0), threadStatus_(0), firstMessage_(true), lastTimeNs_(0), batchCount_(0)
 {
   inputQueue_.ringSize = queueSizeLimit;
   if (inputQueue_.ringSize > 0)
     inputQueue_.ring = new MidiMessage[inputQueue_.ringSize];
 
-  ignoreFlags_[0] = true;  // sysex
-  ignoreFlags_[1] = true;  // timing
-  ignoreFlags_[2] = true;  // sense
+  // Preallocate so the input thread never grows these on the hot path.
+  sysexPool_.reserve(SYSEX_POOL_SIZE);
+  callbackMessage_.reserve(SYSEX_POOL_SIZE);
+
+  ignoreFlags_[0].store(true, std::memory_order_relaxed);  // sysex
+  ignoreFlags_[1].store(true, std::memory_order_relaxed);  // timing
+  ignoreFlags_[2].store(true, std::memory_order_relaxed);  // sense
 }
 
 MidiInApi::~MidiInApi()
@@ -176,7 +332,7 @@ MidiInApi::~MidiInApi()
 
 void MidiInApi::setCallback(RtMidiCallback callback, void *userData)
 {
-  if (userCallback_) {
+  if (hasCallback()) {
     errorString_ = "MidiInApi::setCallback: a callback function is already set!";
     error(RtMidiError::WARNING, errorString_);
     return;
@@ -185,22 +341,211 @@ void MidiInApi::setCallback(RtMidiCallback callback, void *userData)
   userCallbackData_ = userData;
 }
 
+void MidiInApi::setTimestampCallback(RtMidiTimestampCallback callback, void *userData)
+{
+  if (hasCallback()) {
+    errorString_ = "MidiInApi::setTimestampCallback: a callback function is already set!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  userTimestampCallback_ = callback;
+  userCallbackData_ = userData;
+}
+
+void MidiInApi::setRawCallback(RtMidiRawCallback callback, void *userData)
+{
+  if (hasCallback()) {
+    errorString_ = "MidiInApi::setRawCallback: a callback function is already set!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  userRawCallback_ = callback;
+  userCallbackData_ = userData;
+}
+
+void MidiInApi::setBatchCallback(RtMidiBatchCallback callback, void *userData)
+{
+  if (hasCallback()) {
+    errorString_ = "MidiInApi::setBatchCallback: a callback function is already set!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  batchCount_ = 0;
+  userBatchCallback_ = callback;
+  userCallbackData_ = userData;
+}
+
 void MidiInApi::cancelCallback()
 {
-  if (!userCallback_) {
+  if (!hasCallback()) {
     errorString_ = "MidiInApi::cancelCallback: no callback function was set!";
     error(RtMidiError::WARNING, errorString_);
     return;
   }
   userCallback_ = nullptr;
+  userTimestampCallback_ = nullptr;
+  userRawCallback_ = nullptr;
+  userBatchCallback_ = nullptr;
   userCallbackData_ = nullptr;
+  batchCount_ = 0;
+}
+
+void MidiInApi::deliverEvent(RtMidiEvent &event)
+{
+  if (!acceptsMessage(event.data(), event.size))
+    return;
+
+  event.source = eventSource_;
+  event.deltaTime = 0.0;
+  if (firstMessage_)
+    firstMessage_ = false;
+  else if (event.timeNs > lastTimeNs_)
+    event.deltaTime = (event.timeNs - lastTimeNs_) * 0.000000001;
+  lastTimeNs_ = event.timeNs;
+
+  if (userBatchCallback_) {
+    batch_[batchCount_++] = event;
+    // SysEx data is only valid until the backend reads its next event
+    if (event.sysex || batchCount_ == RtMidiIn::BATCH_SIZE)
+      flushBatch();
+    return;
+  }
+
+  if (userRawCallback_) {
+    userRawCallback_(&event, userCallbackData_);
+    return;
+  }
+
+  const unsigned char *data = event.data();
+  if (userTimestampCallback_ || userCallback_) {
+    // Reuses the reserved buffer, so this only allocates for oversized SysEx.
+    callbackMessage_.assign(data, data + event.size);
+    if (userTimestampCallback_)
+      userTimestampCallback_(event.deltaTime, event.timeNs, &callbackMessage_, userCallbackData_);
+    else
+      userCallback_(event.deltaTime, &callbackMessage_, userCallbackData_);
+  } else if (inputQueue_.ringSize > 0) {
+    MidiMessage &slot = inputQueue_.ring[inputQueue_.back];
+    if (event.sysex) {
+      slot.sysex.assign(data, data + event.size);
+      slot.size = 0;
+    } else {
+      std::memcpy(slot.bytes, event.bytes, sizeof(slot.bytes));
+      slot.size = event.size;
+    }
+    slot.timeStamp = event.deltaTime;
+    inputQueue_.back = (inputQueue_.back + 1) % inputQueue_.ringSize;
+    if (inputQueue_.back == inputQueue_.front) {
+      inputQueue_.front = (inputQueue_.front + 1) % inputQueue_.ringSize;
+    }
+  }
+}
+
+void MidiInApi::flushBatch()
+{
+  if (batchCount_ == 0) return;
+  unsigned int count = batchCount_;
+  batchCount_ = 0;
+  if (userBatchCallback_)
+    userBatchCallback_(batch_, count, userCallbackData_);
+}
+
+void MidiInApi::setEventBytes(RtMidiEvent &event, unsigned int size,
+                              unsigned char b0, unsigned char b1, unsigned char b2)
+{
+  event.bytes[0] = b0;
+  event.bytes[1] = b1;
+  event.bytes[2] = b2;
+  event.size = size;
+  event.sysex = nullptr;
+}
+
+unsigned long long MidiInApi::monotonicNanos()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 void MidiInApi::ignoreTypes(bool midiSysex, bool midiTime, bool midiSense)
 {
-  ignoreFlags_[0] = midiSysex;
-  ignoreFlags_[1] = midiTime;
-  ignoreFlags_[2] = midiSense;
+  ignoreFlags_[0].store(midiSysex, std::memory_order_relaxed);
+  ignoreFlags_[1].store(midiTime, std::memory_order_relaxed);
+  ignoreFlags_[2].store(midiSense, std::memory_order_relaxed);
+}
+
+int MidiInApi::addSource(int client, int port, int sourceId, const std::string &portName)
+{
+  if (connected_ || sourceId > 0) {
+    errorString_ = "MidiInApi::addSource: multiple sources are not supported by this API!";
+    error(RtMidiError::WARNING, errorString_);
+    return -1;
+  }
+  openPortAddress(client, port, portName);
+  return connected_ ? 0 : -1;
+}
+
+void MidiInApi::removeSource(int /*sourceId*/)
+{
+  errorString_ = "MidiInApi::removeSource: multiple sources are not supported by this API!";
+  error(RtMidiError::WARNING, errorString_);
+}
+
+void MidiInApi::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  MidiApi::getPorts(ports);
+  for (RtMidiPortInfo &info : ports)
+    info.capabilities |= RtMidiPortInfo::INPUT;
+}
+
+void MidiInApi::setFilter(const RtMidiFilter &filter)
+{
+  filterTypes_ = filter.types;
+  filterChannels_ = filter.channels;
+  filterNotes_ = filter.noteLow | (filter.noteHigh << 8);
+  filterClockWhileStopped_ = filter.clockWhileStopped;
+}
+
+RtMidiFilter MidiInApi::getFilter() const
+{
+  RtMidiFilter filter;
+  filter.types = filterTypes_;
+  filter.channels = (unsigned short)filterChannels_;
+  unsigned int notes = filterNotes_;
+  filter.noteLow = notes & 0xFF;
+  filter.noteHigh = (notes >> 8) & 0xFF;
+  filter.clockWhileStopped = filterClockWhileStopped_;
+  return filter;
+}
+
+bool MidiInApi::acceptsMessage(const unsigned char *data, unsigned int size)
+{
+  if (size == 0) return false;
+  unsigned char status = data[0];
+
+  if (status == 0xFA || status == 0xFB)
+    transportRunning_.store(true, std::memory_order_relaxed);
+  else if (status == 0xFC)
+    transportRunning_.store(false, std::memory_order_relaxed);
+
+  unsigned int bit = RtMidiFilter::typeBit(status);
+  if (!(filterTypes_.load(std::memory_order_relaxed) & bit))
+    return false;
+
+  if (status < 0xF0) {
+    if (!(filterChannels_.load(std::memory_order_relaxed) & (1u << (status & 0x0F))))
+      return false;
+    if ((bit & (RtMidiFilter::NOTE_OFF | RtMidiFilter::NOTE_ON | RtMidiFilter::POLY_PRESSURE)) && size > 1) {
+      unsigned int notes = filterNotes_.load(std::memory_order_relaxed);
+      if (data[1] < (notes & 0xFF) || data[1] > (notes >> 8))
+        return false;
+    }
+  } else if ((bit & (RtMidiFilter::CLOCK | RtMidiFilter::TICK))
+             && !filterClockWhileStopped_.load(std::memory_order_relaxed)
+             && !transportRunning_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  return true;
 }
 
 double MidiInApi::getMessage(std::vector<unsigned char> *message)
@@ -210,9 +555,12 @@ double MidiInApi::getMessage(std::vector<unsigned char> *message)
   if (inputQueue_.front == inputQueue_.back)
     return 0.0;
 
-  unsigned int idx = inputQueue_.front;
-  *message = inputQueue_.ring[idx].bytes;
-  double timeStamp = inputQueue_.ring[idx].timeStamp;
+  const MidiMessage &slot = inputQueue_.ring[inputQueue_.front];
+  if (slot.size > 0)
+    message->assign(slot.bytes, slot.bytes + slot.size);
+  else
+    *message = slot.sysex;
+  double timeStamp = slot.timeStamp;
   inputQueue_.front = (inputQueue_.front + 1) % inputQueue_.ringSize;
 
   return timeStamp;
@@ -223,7 +571,10 @@ class MidiOutApi : public MidiApi
 public:
   MidiOutApi();
   virtual ~MidiOutApi();
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
   virtual void sendMessage(const unsigned char *message, size_t size) = 0;
+  // The default sends each event immediately and ignores timeNs.
+  virtual void sendEvents(const RtMidiEvent *events, unsigned int count);
 };
 
 MidiOutApi::MidiOutApi() : MidiApi()
@@ -234,6 +585,19 @@ MidiOutApi::~MidiOutApi()
 {
 }
 
+void MidiOutApi::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  MidiApi::getPorts(ports);
+  for (RtMidiPortInfo &info : ports)
+    info.capabilities |= RtMidiPortInfo::OUTPUT;
+}
+
+void MidiOutApi::sendEvents(const RtMidiEvent *events, unsigned int count)
+{
+  for (unsigned int i = 0; i < count; i++)
+    sendMessage(events[i].data(), events[i].size);
+}
+
 // **************************************************************** //
 //
 // RtMidi definitions.
@@ -258,9 +622,14 @@ std::vector<RtMidi::Api> RtMidi::getCompiledApi() throw()
 #endif
 #if defined(__LINUX_ALSA__)
   apis.push_back(LINUX_ALSA);
+  apis.push_back(LINUX_RAWMIDI);
 #endif
 #if defined(__WINDOWS_MM__)
   apis.push_back(WINDOWS_MM);
+#endif
+#if defined(__RTMIDI_DUMMY__)
+  // Last, so UNSPECIFIED only picks it when no real API is compiled
+  apis.push_back(RTMIDI_DUMMY);
 #endif
   return apis;
 }
@@ -268,24 +637,26 @@ std::vector<RtMidi::Api> RtMidi::getCompiledApi() throw()
 std::string RtMidi::getApiName(RtMidi::Api api)
 {
   switch (api) {
-    case MACOSX_CORE:  return "core";
-    case LINUX_ALSA:   return "alsa";
-    case UNIX_JACK:    return "jack";
-    case WINDOWS_MM:   return "winmm";
-    case RTMIDI_DUMMY: return "dummy";
-    default:           return "";
+    case MACOSX_CORE:   return "core";
+    case LINUX_ALSA:    return "alsa";
+    case UNIX_JACK:     return "jack";
+    case WINDOWS_MM:    return "winmm";
+    case RTMIDI_DUMMY:  return "dummy";
+    case LINUX_RAWMIDI: return "rawmidi";
+    default:            return "";
   }
 }
 
 std::string RtMidi::getApiDisplayName(RtMidi::Api api)
 {
   switch (api) {
-    case MACOSX_CORE:  return "CoreMIDI";
-    case LINUX_ALSA:   return "ALSA";
-    case UNIX_JACK:    return "JACK";
-    case WINDOWS_MM:   return "Windows MultiMedia";
-    case RTMIDI_DUMMY: return "Dummy";
-    default:           return "Unknown";
+    case MACOSX_CORE:   return "CoreMIDI";
+    case LINUX_ALSA:    return "ALSA";
+    case UNIX_JACK:     return "JACK";
+    case WINDOWS_MM:    return "Windows MultiMedia";
+    case RTMIDI_DUMMY:  return "Loopback";
+    case LINUX_RAWMIDI: return "ALSA Raw MIDI";
+    default:            return "Unknown";
   }
 }
 
@@ -313,6 +684,20 @@ void RtMidi::setErrorCallback(RtMidiErrorCallback errorCallback, void *userData)
     rtapi_->setErrorCallback(errorCallback, userData);
 }
 
+std::vector<RtMidiPortInfo> RtMidi::getPorts()
+{
+  std::vector<RtMidiPortInfo> ports;
+  if (rtapi_)
+    rtapi_->getPorts(ports);
+  return ports;
+}
+
+void RtMidi::openPortAddress(int client, int port, const std::string &portName)
+{
+  if (rtapi_)
+    rtapi_->openPortAddress(client, port, portName);
+}
+
 void RtMidi::setClientName(const std::string &clientName)
 {
   if (rtapi_)
@@ -502,11 +887,9 @@ void MidiInCore::midiInputCallback(const MIDIPacketList *list, void *procRef, vo
   const MIDIPacket *packet = &list->packet[0];
 
   for (unsigned int i = 0; i < list->numPackets; ++i) {
-    // Get timestamp in seconds
-    double timeStamp = 0.0;
-    if (packet->timeStamp != 0) {
-      timeStamp = AudioConvertHostTimeToNanos(packet->timeStamp) / 1000000000.0;
-    }
+    // Host time is mach_absolute_time, which is monotonic
+    unsigned long long timeNs = AudioConvertHostTimeToNanos(
+      packet->timeStamp != 0 ? packet->timeStamp : AudioGetCurrentHostTime());
 
     unsigned int nBytes = packet->length;
     if (nBytes == 0) {
@@ -526,43 +909,40 @@ void MidiInCore::midiInputCallback(const MIDIPacketList *list, void *procRef, vo
     // System messages
     if (status >= 0xF0) {
       // Sysex
-      if (status == 0xF0 && data->ignoreFlags_[0]) {
+      if (status == 0xF0 && data->ignoreFlags_[0].load(std::memory_order_relaxed)) {
         packet = MIDIPacketNext(packet);
         continue;
       }
       // Timing
-      if (status == 0xF8 && data->ignoreFlags_[1]) {
+      if (status == 0xF8 && data->ignoreFlags_[1].load(std::memory_order_relaxed)) {
         packet = MIDIPacketNext(packet);
         continue;
       }
       // Sense
-      if (status == 0xFE && data->ignoreFlags_[2]) {
+      if (status == 0xFE && data->ignoreFlags_[2].load(std::memory_order_relaxed)) {
         packet = MIDIPacketNext(packet);
         continue;
       }
     }
 
-    // Create message
-    std::vector<unsigned char> message;
-    message.assign(packet->data, packet->data + nBytes);
-
-    if (data->userCallback_) {
-      data->userCallback_(timeStamp, &message, data->userCallbackData_);
+    // Short messages are copied inline; longer packets are passed by
+    // reference to the packet data, which outlives the callback.
+    RtMidiEvent event;
+    event.timeNs = timeNs;
+    if (nBytes <= 3) {
+      setEventBytes(event, nBytes, packet->data[0],
+                    nBytes > 1 ? packet->data[1] : 0, nBytes > 2 ? packet->data[2] : 0);
     } else {
-      // Queue message
-      if (data->inputQueue_.ringSize > 0) {
-        unsigned int idx = data->inputQueue_.back;
-        data->inputQueue_.ring[idx].bytes = message;
-        data->inputQueue_.ring[idx].timeStamp = timeStamp;
-        data->inputQueue_.back = (data->inputQueue_.back + 1) % data->inputQueue_.ringSize;
-        if (data->inputQueue_.back == data->inputQueue_.front) {
-          data->inputQueue_.front = (data->inputQueue_.front + 1) % data->inputQueue_.ringSize;
-        }
-      }
+      event.sysex = packet->data;
+      event.size = nBytes;
     }
+    data->deliverEvent(event);
 
     packet = MIDIPacketNext(packet);
   }
+
+  // One batch per packet list
+  data->flushBatch();
 }
 
 // CoreMIDI Output
@@ -746,6 +1126,101 @@ void MidiOutCore::sendMessage(const unsigned char *message, size_t size)
 
 // ALSA implementation
 
+// Fill `info` for one sequencer port, in the format used by getPortName().
+static void alsaDescribePort(const char *clientName, snd_seq_port_info_t *pinfo, RtMidiPortInfo &info)
+{
+  const unsigned int readable = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+  const unsigned int writable = SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE;
+  unsigned int portCaps = snd_seq_port_info_get_capability(pinfo);
+
+  info.name = std::string(clientName) + ":" + snd_seq_port_info_get_name(pinfo);
+  info.client = snd_seq_port_info_get_client(pinfo);
+  info.port = snd_seq_port_info_get_port(pinfo);
+  info.capabilities = 0;
+  if ((portCaps & readable) == readable) info.capabilities |= RtMidiPortInfo::INPUT;
+  if ((portCaps & writable) == writable) info.capabilities |= RtMidiPortInfo::OUTPUT;
+  info.capabilities |= (snd_seq_port_info_get_type(pinfo) & SND_SEQ_PORT_TYPE_HARDWARE)
+                         ? RtMidiPortInfo::HARDWARE : RtMidiPortInfo::SOFTWARE;
+}
+
+// Walk every sequencer client and port once, collecting the ports whose
+// capabilities include all of `caps` (READ|SUBS_READ for input sources,
+// WRITE|SUBS_WRITE for output destinations).
+static void alsaEnumeratePorts(snd_seq_t *seq, unsigned int caps, std::vector<RtMidiPortInfo> &ports)
+{
+  ports.clear();
+  if (!seq) return;
+
+  snd_seq_port_info_t *pinfo;
+  snd_seq_client_info_t *cinfo;
+  snd_seq_port_info_alloca(&pinfo);
+  snd_seq_client_info_alloca(&cinfo);
+
+  int self = snd_seq_client_id(seq);
+
+  snd_seq_client_info_set_client(cinfo, -1);
+  while (snd_seq_query_next_client(seq, cinfo) >= 0) {
+    int client = snd_seq_client_info_get_client(cinfo);
+    if (client == self) continue;
+    const char *clientName = snd_seq_client_info_get_name(cinfo);
+    snd_seq_port_info_set_client(pinfo, client);
+    snd_seq_port_info_set_port(pinfo, -1);
+    while (snd_seq_query_next_port(seq, pinfo) >= 0) {
+      if ((snd_seq_port_info_get_capability(pinfo) & caps) != caps) continue;
+
+      RtMidiPortInfo info;
+      alsaDescribePort(clientName, pinfo, info);
+      ports.push_back(info);
+    }
+  }
+}
+
+// Apply threadOptions_ to the calling thread and record the outcome in
+// threadStatus_.  A request that is refused leaves that setting as it was.
+void MidiInApi::applyThreadOptions()
+{
+  unsigned int status = 0;
+  pthread_t self = pthread_self();
+
+  int policy = SCHED_OTHER;
+  if (threadOptions_.policy == RtMidiThreadOptions::FIFO)
+    policy = SCHED_FIFO;
+  else if (threadOptions_.policy == RtMidiThreadOptions::ROUND_ROBIN)
+    policy = SCHED_RR;
+  sched_param param;
+  param.sched_priority = 0;
+  if (policy != SCHED_OTHER) {
+    param.sched_priority = std::max(sched_get_priority_min(policy),
+                                    std::min(threadOptions_.priority, sched_get_priority_max(policy)));
+  }
+  int result = pthread_setschedparam(self, policy, &param);
+  if (result == 0) {
+    if (policy != SCHED_OTHER) status |= RtMidiThreadOptions::PRIORITY_APPLIED;
+  } else if (policy != SCHED_OTHER) {
+    status |= RtMidiThreadOptions::PRIORITY_FAILED;
+    errorString_ = std::string("MidiInApi::applyThreadOptions: realtime priority refused (") + strerror(result)
+                   + "), running with normal scheduling.";
+    error(RtMidiError::WARNING, errorString_);
+  }
+
+  // No CPUs means any CPU, which also undoes an earlier pinning
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+    if (!threadOptions_.cpus || (threadOptions_.cpus >> cpu) & 1) CPU_SET(cpu, &cpus);
+  }
+  result = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+  if (result == 0) {
+    if (threadOptions_.cpus) status |= RtMidiThreadOptions::AFFINITY_APPLIED;
+  } else if (threadOptions_.cpus) {
+    status |= RtMidiThreadOptions::AFFINITY_FAILED;
+    errorString_ = std::string("MidiInApi::applyThreadOptions: CPU affinity refused (") + strerror(result) + ").";
+    error(RtMidiError::WARNING, errorString_);
+  }
+
+  threadStatus_.store(status, std::memory_order_relaxed);
+}
+
 class MidiInAlsa : public MidiInApi
 {
 public:
@@ -759,213 +1234,760 @@ public:
   void setPortName(const std::string &portName) override;
   unsigned int getPortCount() override;
   std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
+  void ignoreTypes(bool midiSysex, bool midiTime, bool midiSense) override;
+  void setFilter(const RtMidiFilter &filter) override;
+  bool setPortCallback(RtMidiPortCallback callback, void *userData) override;
+  bool setThreadOptions(const RtMidiThreadOptions &options) override;
+  int addSource(int client, int port, int sourceId, const std::string &portName) override;
+  void removeSource(int sourceId) override;
+  unsigned long long driverTimeNs() override;
 
 private:
   snd_seq_t *seq_;
   int portNum_;
+  // Sender address (client << 8 | port) per source id, -1 when free.
+  // Written by the user thread, read by the input thread to tag events.
+  std::atomic<int> sourceAddr_[RtMidiIn::MAX_SOURCES];
+  int announcePort_;                   // subscribed to System:Announce while watching
+  RtMidiPortCallback portCallback_;
+  void *portCallbackData_;
+  int queueId_;
+  unsigned long long queueStartNs_;
   pthread_t thread_;
-  bool threadRunning_;
+  std::atomic<bool> threadRunning_;
+  int triggerFds_[2];
+  bool sysexActive_;                   // a SysEx message is being reassembled
+  bool sysexOverflow_;                 // ... and it no longer fits the pool
+  unsigned long long sysexTimeNs_;     // arrival time of its first chunk
+  int createInputPort(const std::string &portName);
+  bool isInputSource(int client, int port);
+  bool subscribeSource(int sourceId, int client, int port);
+  unsigned char lookupSource(const snd_seq_addr_t &sender) const;
+  void startInput();
+  void startThread();
+  void stopThread();
+  void applyKernelFilter();
+  void handlePortEvent(const snd_seq_event_t *ev);
+  void decodeEvent(const snd_seq_event_t *ev, unsigned long long timeNs);
+  void deliverShort(unsigned long long timeNs, unsigned int size,
+                    unsigned char b0, unsigned char b1 = 0, unsigned char b2 = 0);
+  void deliverSysex(const unsigned char *chunk, unsigned int len, unsigned long long timeNs);
   static void *alsaMidiHandler(void *ptr);
 };
 
 MidiInAlsa::MidiInAlsa(const std::string &clientName, unsigned int queueSizeLimit)
-  : MidiInApi(queueSizeLimit), seq_(nullptr), portNum_(-1), threadRunning_(false)
+  : MidiInApi(queueSizeLimit), seq_(nullptr), portNum_(-1), announcePort_(-1), portCallback_(nullptr),
+    portCallbackData_(nullptr), queueId_(-1), queueStartNs_(0),
+    threadRunning_(false), sysexActive_(false), sysexOverflow_(false), sysexTimeNs_(0)
 {
+  triggerFds_[0] = triggerFds_[1] = -1;
+  for (auto &addr : sourceAddr_)
+    addr.store(-1, std::memory_order_relaxed);
+
   if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_DUPLEX, SND_SEQ_NONBLOCK) < 0) {
     errorString_ = "MidiInAlsa::MidiInAlsa: error creating ALSA sequencer client.";
     error(RtMidiError::DRIVER_ERROR, errorString_);
     return;
   }
   snd_seq_set_client_name(seq_, clientName.c_str());
+
+  // Real-time queue used to timestamp incoming events in the kernel.
+  queueId_ = snd_seq_alloc_named_queue(seq_, "RtMidi Queue");
+  if (queueId_ < 0) {
+    errorString_ = "MidiInAlsa::MidiInAlsa: error allocating timestamp queue.";
+    error(RtMidiError::WARNING, errorString_);
+  }
+
+  // Self-pipe used by closePort() to wake the input thread out of poll().
+  if (pipe2(triggerFds_, O_NONBLOCK | O_CLOEXEC) < 0) {
+    triggerFds_[0] = triggerFds_[1] = -1;
+    errorString_ = "MidiInAlsa::MidiInAlsa: error creating wakeup pipe.";
+    error(RtMidiError::SYSTEM_ERROR, errorString_);
+  }
+
+  applyKernelFilter();
 }
 
 MidiInAlsa::~MidiInAlsa()
 {
+  // Stop watching first so closePort() doesn't restart the thread
+  portCallback_ = nullptr;
   closePort();
+  if (announcePort_ >= 0) snd_seq_delete_port(seq_, announcePort_);
+  if (triggerFds_[0] >= 0) close(triggerFds_[0]);
+  if (triggerFds_[1] >= 0) close(triggerFds_[1]);
+  if (queueId_ >= 0) snd_seq_free_queue(seq_, queueId_);
   if (seq_) snd_seq_close(seq_);
 }
 
 unsigned int MidiInAlsa::getPortCount()
 {
-  snd_seq_port_info_t *pinfo;
-  snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
-  snd_seq_client_info_alloca(&cinfo);
-
-  unsigned int count = 0;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_READ) && (caps & SND_SEQ_PORT_CAP_SUBS_READ))
-        count++;
-    }
-  }
-  return count;
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, ports);
+  return (unsigned int)ports.size();
 }
 
 std::string MidiInAlsa::getPortName(unsigned int portNumber)
 {
-  snd_seq_port_info_t *pinfo;
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, ports);
+  if (portNumber >= ports.size()) return "";
+  return ports[portNumber].name;
+}
+
+void MidiInAlsa::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, ports);
+}
+
+void MidiInAlsa::ignoreTypes(bool midiSysex, bool midiTime, bool midiSense)
+{
+  MidiInApi::ignoreTypes(midiSysex, midiTime, midiSense);
+  applyKernelFilter();
+}
+
+void MidiInAlsa::setFilter(const RtMidiFilter &filter)
+{
+  MidiInApi::setFilter(filter);
+  applyKernelFilter();
+}
+
+// Port changes are announced by the kernel on System:Announce (0:1).  A
+// hidden port subscribed to it lets the input thread keep the caller's
+// port table current from individual start/exit/change events instead of
+// re-enumerating every client.
+bool MidiInAlsa::setPortCallback(RtMidiPortCallback callback, void *userData)
+{
+  if (!seq_) return false;
+
+  // The callback pointer is read by the input thread
+  stopThread();
+  portCallback_ = nullptr;
+
+  if (callback && announcePort_ < 0) {
+    announcePort_ = snd_seq_create_simple_port(seq_, "RtMidi Announce",
+                                               SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_NO_EXPORT,
+                                               SND_SEQ_PORT_TYPE_APPLICATION);
+    if (announcePort_ < 0
+        || snd_seq_connect_from(seq_, announcePort_, SND_SEQ_CLIENT_SYSTEM, SND_SEQ_PORT_SYSTEM_ANNOUNCE) < 0) {
+      if (announcePort_ >= 0) snd_seq_delete_port(seq_, announcePort_);
+      announcePort_ = -1;
+      if (connected_) startThread();
+      errorString_ = "MidiInAlsa::setPortCallback: error subscribing to the system announce port.";
+      error(RtMidiError::DRIVER_ERROR, errorString_);
+      return false;
+    }
+  }
+  else if (!callback && announcePort_ >= 0) {
+    snd_seq_delete_port(seq_, announcePort_);
+    announcePort_ = -1;
+  }
+
+  portCallback_ = callback;
+  portCallbackData_ = userData;
+  applyKernelFilter();
+  if (connected_ || portCallback_) startThread();
+  return true;
+}
+
+bool MidiInAlsa::setThreadOptions(const RtMidiThreadOptions &options)
+{
+  // Events wait in the sequencer while the thread restarts
+  bool running = threadRunning_;
+  stopThread();
+  threadOptions_ = options;
+  if (running) startThread();
+  return true;
+}
+
+// The timestamp queue's real time, mapped like event timestamps.  The
+// queue runs on the sequencer's timer, which can drift from the
+// monotonic clock; sampling both measures that drift.
+unsigned long long MidiInAlsa::driverTimeNs()
+{
+  if (!connected_ || queueId_ < 0) return monotonicNanos();
+
+  snd_seq_queue_status_t *status;
+  snd_seq_queue_status_alloca(&status);
+  if (snd_seq_get_queue_status(seq_, queueId_, status) < 0) return monotonicNanos();
+  const snd_seq_real_time_t *time = snd_seq_queue_status_get_real_time(status);
+  return queueStartNs_ + time->tv_sec * 1000000000ULL + time->tv_nsec;
+}
+
+// Translate ignoreTypes() and the type part of the filter into an ALSA
+// client event filter, so unwanted events are dropped by the kernel and
+// never wake the input thread.  Channel and note ranges have no kernel
+// equivalent and are checked in acceptsMessage().  The filter depends only
+// on the settings, never on transport state, so it is rewritten on the
+// user thread alone and the input thread never blocks on the sequencer.
+void MidiInAlsa::applyKernelFilter()
+{
+  if (!seq_) return;
+
+  unsigned int types = filterTypes_;
+  if (ignoreFlags_[0].load(std::memory_order_relaxed)) types &= ~RtMidiFilter::SYSEX;
+  if (ignoreFlags_[1].load(std::memory_order_relaxed)) types &= ~(RtMidiFilter::TIME_CODE | RtMidiFilter::CLOCK | RtMidiFilter::TICK);
+  if (ignoreFlags_[2].load(std::memory_order_relaxed)) types &= ~RtMidiFilter::ACTIVE_SENSING;
+  // Clock while stopped is gated in acceptsMessage(), which has to see
+  // transport to know when it runs. Clock itself stays open here: lifting
+  // the filter only once Start was decoded would lose the first ticks.
+  if (!filterClockWhileStopped_)
+    types |= RtMidiFilter::START | RtMidiFilter::CONTINUE | RtMidiFilter::STOP;
+
+  static const struct { unsigned int bit; int type; } eventTypes[] = {
+    { RtMidiFilter::NOTE_OFF, SND_SEQ_EVENT_NOTEOFF },
+    { RtMidiFilter::NOTE_ON, SND_SEQ_EVENT_NOTEON },
+    { RtMidiFilter::POLY_PRESSURE, SND_SEQ_EVENT_KEYPRESS },
+    { RtMidiFilter::CONTROL_CHANGE, SND_SEQ_EVENT_CONTROLLER },
+    { RtMidiFilter::CONTROL_CHANGE, SND_SEQ_EVENT_CONTROL14 },
+    { RtMidiFilter::CONTROL_CHANGE, SND_SEQ_EVENT_NONREGPARAM },
+    { RtMidiFilter::CONTROL_CHANGE, SND_SEQ_EVENT_REGPARAM },
+    { RtMidiFilter::PROGRAM_CHANGE, SND_SEQ_EVENT_PGMCHANGE },
+    { RtMidiFilter::CHANNEL_PRESSURE, SND_SEQ_EVENT_CHANPRESS },
+    { RtMidiFilter::PITCH_BEND, SND_SEQ_EVENT_PITCHBEND },
+    { RtMidiFilter::SYSEX, SND_SEQ_EVENT_SYSEX },
+    { RtMidiFilter::TIME_CODE, SND_SEQ_EVENT_QFRAME },
+    { RtMidiFilter::SONG_POSITION, SND_SEQ_EVENT_SONGPOS },
+    { RtMidiFilter::SONG_SELECT, SND_SEQ_EVENT_SONGSEL },
+    { RtMidiFilter::TUNE_REQUEST, SND_SEQ_EVENT_TUNE_REQUEST },
+    { RtMidiFilter::CLOCK, SND_SEQ_EVENT_CLOCK },
+    { RtMidiFilter::TICK, SND_SEQ_EVENT_TICK },
+    { RtMidiFilter::START, SND_SEQ_EVENT_START },
+    { RtMidiFilter::CONTINUE, SND_SEQ_EVENT_CONTINUE },
+    { RtMidiFilter::STOP, SND_SEQ_EVENT_STOP },
+    { RtMidiFilter::ACTIVE_SENSING, SND_SEQ_EVENT_SENSING },
+    { RtMidiFilter::RESET, SND_SEQ_EVENT_RESET },
+  };
+
   snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
   snd_seq_client_info_alloca(&cinfo);
-
-  unsigned int count = 0;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_READ) && (caps & SND_SEQ_PORT_CAP_SUBS_READ)) {
-        if (count == portNumber) {
-          std::ostringstream os;
-          os << snd_seq_client_info_get_name(cinfo) << ":" << snd_seq_port_info_get_name(pinfo);
-          return os.str();
-        }
-        count++;
+  if (snd_seq_get_client_info(seq_, cinfo) < 0) return;
+
+  // An empty filter means "accept everything", so only install one when
+  // something is actually excluded
+  snd_seq_client_info_event_filter_clear(cinfo);
+  if (types != RtMidiFilter::ALL_TYPES) {
+    bool any = false;
+    for (const auto &entry : eventTypes) {
+      if (types & entry.bit) {
+        snd_seq_client_info_event_filter_add(cinfo, entry.type);
+        any = true;
       }
     }
+    if (portCallback_) {
+      snd_seq_client_info_event_filter_add(cinfo, SND_SEQ_EVENT_PORT_START);
+      snd_seq_client_info_event_filter_add(cinfo, SND_SEQ_EVENT_PORT_EXIT);
+      snd_seq_client_info_event_filter_add(cinfo, SND_SEQ_EVENT_PORT_CHANGE);
+      any = true;
+    }
+    // Nothing wanted at all: admit only a type that never carries MIDI
+    if (!any)
+      snd_seq_client_info_event_filter_add(cinfo, SND_SEQ_EVENT_SYSTEM);
+  }
+
+  if (snd_seq_set_client_info(seq_, cinfo) < 0) {
+    errorString_ = "MidiInAlsa::applyKernelFilter: error setting the client event filter.";
+    error(RtMidiError::WARNING, errorString_);
   }
-  return "";
 }
 
 void *MidiInAlsa::alsaMidiHandler(void *ptr)
 {
   MidiInAlsa *data = static_cast<MidiInAlsa *>(ptr);
   snd_seq_event_t *ev;
-  double time;
+  unsigned long long timeNs;
+
+  data->applyThreadOptions();
+
+  // Sleep in poll() on the sequencer descriptors plus the wakeup pipe
+  // (slot 0) instead of spinning on the non-blocking input call.
+  int seqFdCount = snd_seq_poll_descriptors_count(data->seq_, POLLIN);
+  std::vector<struct pollfd> pollFds(seqFdCount + 1);
+  pollFds[0].fd = data->triggerFds_[0];
+  pollFds[0].events = POLLIN;
+  snd_seq_poll_descriptors(data->seq_, &pollFds[1], seqFdCount, POLLIN);
 
+  // Without a wakeup pipe, fall back to a short timeout so closePort() can't hang.
+  int timeoutMs = data->triggerFds_[0] >= 0 ? -1 : 10;
+
+  // Drain everything pending per wakeup; the batch is handed over once
+  // the sequencer has nothing left (or the batch is full).
   while (data->threadRunning_) {
-    if (snd_seq_event_input(data->seq_, &ev) >= 0) {
-      std::vector<unsigned char> message;
-      time = 0.0;
-
-      switch (ev->type) {
-        case SND_SEQ_EVENT_NOTEON:
-          message.push_back(0x90 | ev->data.note.channel);
-          message.push_back(ev->data.note.note);
-          message.push_back(ev->data.note.velocity);
-          break;
-        case SND_SEQ_EVENT_NOTEOFF:
-          message.push_back(0x80 | ev->data.note.channel);
-          message.push_back(ev->data.note.note);
-          message.push_back(ev->data.note.velocity);
-          break;
-        case SND_SEQ_EVENT_CONTROLLER:
-          message.push_back(0xB0 | ev->data.control.channel);
-          message.push_back(ev->data.control.param);
-          message.push_back(ev->data.control.value);
-          break;
-        case SND_SEQ_EVENT_CLOCK:
-          message.push_back(0xF8);
-          break;
-        case SND_SEQ_EVENT_START:
-          message.push_back(0xFA);
-          break;
-        case SND_SEQ_EVENT_CONTINUE:
-          message.push_back(0xFB);
-          break;
-        case SND_SEQ_EVENT_STOP:
-          message.push_back(0xFC);
-          break;
-        default:
-          break;
+    if (snd_seq_event_input_pending(data->seq_, 1) == 0) {
+      data->flushBatch();
+      if (poll(pollFds.data(), pollFds.size(), timeoutMs) > 0 && (pollFds[0].revents & POLLIN)) {
+        char drain[16];
+        while (read(data->triggerFds_[0], drain, sizeof(drain)) > 0) {}
       }
+      continue;
+    }
 
-      if (!message.empty()) {
-        if (data->userCallback_) {
-          data->userCallback_(time, &message, data->userCallbackData_);
-        } else if (data->inputQueue_.ringSize > 0) {
-          unsigned int idx = data->inputQueue_.back;
-          data->inputQueue_.ring[idx].bytes = message;
-          data->inputQueue_.ring[idx].timeStamp = time;
-          data->inputQueue_.back = (data->inputQueue_.back + 1) % data->inputQueue_.ringSize;
-          if (data->inputQueue_.back == data->inputQueue_.front) {
-            data->inputQueue_.front = (data->inputQueue_.front + 1) % data->inputQueue_.ringSize;
-          }
-        }
+    if (snd_seq_event_input(data->seq_, &ev) >= 0) {
+      // Events are stamped with the queue's real time on arrival; map it
+      // onto the monotonic clock via the time the queue was started.
+      if (data->queueId_ >= 0 && (ev->flags & SND_SEQ_TIME_STAMP_MASK) == SND_SEQ_TIME_STAMP_REAL) {
+        timeNs = data->queueStartNs_ + ev->time.time.tv_sec * 1000000000ULL + ev->time.time.tv_nsec;
+      } else {
+        timeNs = monotonicNanos();
       }
+
+      data->decodeEvent(ev, timeNs);
       snd_seq_free_event(ev);
     }
   }
+  data->flushBatch();
   return nullptr;
 }
 
-void MidiInAlsa::openPort(unsigned int portNumber, const std::string &portName)
+// Report one System:Announce port event.  Start and change events are
+// resolved to a full RtMidiPortInfo with two targeted queries; a port
+// that is already gone again by then is reported as removed.
+void MidiInAlsa::handlePortEvent(const snd_seq_event_t *ev)
 {
-  if (connected_) {
-    errorString_ = "MidiInAlsa::openPort: a valid connection already exists!";
-    error(RtMidiError::WARNING, errorString_);
-    return;
-  }
-
-  unsigned int nSrc = getPortCount();
-  if (nSrc < 1) {
-    errorString_ = "MidiInAlsa::openPort: no MIDI input sources found!";
-    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
-    return;
-  }
+  if (!portCallback_) return;
+  const snd_seq_addr_t &addr = ev->data.addr;
+  if (addr.client == snd_seq_client_id(seq_)) return;
 
-  snd_seq_port_info_t *pinfo;
-  snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
-  snd_seq_client_info_alloca(&cinfo);
+  RtMidiPortInfo info;
+  info.client = addr.client;
+  info.port = addr.port;
+  info.capabilities = 0;
+  int change = RtMidiPortInfo::REMOVED;
 
-  unsigned int count = 0;
-  int srcClient = -1, srcPort = -1;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_READ) && (caps & SND_SEQ_PORT_CAP_SUBS_READ)) {
-        if (count == portNumber) {
-          srcClient = snd_seq_port_info_get_client(pinfo);
-          srcPort = snd_seq_port_info_get_port(pinfo);
-          break;
-        }
-        count++;
-      }
+  if (ev->type != SND_SEQ_EVENT_PORT_EXIT) {
+    snd_seq_client_info_t *cinfo;
+    snd_seq_port_info_t *pinfo;
+    snd_seq_client_info_alloca(&cinfo);
+    snd_seq_port_info_alloca(&pinfo);
+    if (snd_seq_get_any_client_info(seq_, addr.client, cinfo) >= 0
+        && snd_seq_get_any_port_info(seq_, addr.client, addr.port, pinfo) >= 0) {
+      alsaDescribePort(snd_seq_client_info_get_name(cinfo), pinfo, info);
+      change = ev->type == SND_SEQ_EVENT_PORT_START ? RtMidiPortInfo::ADDED : RtMidiPortInfo::CHANGED;
     }
-    if (srcClient >= 0) break;
-  }
-
-  if (srcClient < 0) {
-    errorString_ = "MidiInAlsa::openPort: invalid port number!";
-    error(RtMidiError::INVALID_PARAMETER, errorString_);
-    return;
   }
 
-  portNum_ = snd_seq_create_simple_port(seq_, portName.c_str(),
-    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
-    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  portCallback_(change, info, portCallbackData_);
+}
 
-  if (portNum_ < 0) {
-    errorString_ = "MidiInAlsa::openPort: error creating port.";
-    error(RtMidiError::DRIVER_ERROR, errorString_);
+// Translate a sequencer event back into MIDI 1.0 bytes.  Short messages are
+// built in place; SysEx is handed over straight from the event when it
+// arrives in one piece and reassembled into sysexPool_ otherwise.
+void MidiInAlsa::decodeEvent(const snd_seq_event_t *ev, unsigned long long timeNs)
+{
+  if (ev->type == SND_SEQ_EVENT_PORT_START || ev->type == SND_SEQ_EVENT_PORT_EXIT
+      || ev->type == SND_SEQ_EVENT_PORT_CHANGE) {
+    handlePortEvent(ev);
     return;
   }
+  // The thread keeps running for port events after closePort(); anything
+  // still queued from the closed port is stale
+  if (!connected_) return;
+  eventSource_ = lookupSource(ev->source);
 
-  snd_seq_connect_from(seq_, portNum_, srcClient, srcPort);
-
-  threadRunning_ = true;
-  pthread_create(&thread_, nullptr, alsaMidiHandler, this);
-
-  connected_ = true;
-}
+  const snd_seq_ev_note_t &note = ev->data.note;
+  const snd_seq_ev_ctrl_t &ctrl = ev->data.control;
+  unsigned char channel = ctrl.channel & 0x0F;
 
-void MidiInAlsa::openVirtualPort(const std::string &portName)
+  switch (ev->type) {
+    case SND_SEQ_EVENT_NOTEON:
+      deliverShort(timeNs, 3, 0x90 | (note.channel & 0x0F), note.note, note.velocity);
+      break;
+    case SND_SEQ_EVENT_NOTEOFF:
+      deliverShort(timeNs, 3, 0x80 | (note.channel & 0x0F), note.note, note.velocity);
+      break;
+    case SND_SEQ_EVENT_KEYPRESS:
+      deliverShort(timeNs, 3, 0xA0 | (note.channel & 0x0F), note.note, note.velocity);
+      break;
+    case SND_SEQ_EVENT_CONTROLLER:
+      deliverShort(timeNs, 3, 0xB0 | channel, ctrl.param, ctrl.value);
+      break;
+    case SND_SEQ_EVENT_PGMCHANGE:
+      deliverShort(timeNs, 2, 0xC0 | channel, ctrl.value);
+      break;
+    case SND_SEQ_EVENT_CHANPRESS:
+      deliverShort(timeNs, 2, 0xD0 | channel, ctrl.value);
+      break;
+    case SND_SEQ_EVENT_PITCHBEND: {
+      // ALSA reports -8192..8191 around the centre
+      unsigned int value = (unsigned int)(ctrl.value + 8192) & 0x3FFF;
+      deliverShort(timeNs, 3, 0xE0 | channel, value & 0x7F, value >> 7);
+      break;
+    }
+    case SND_SEQ_EVENT_CONTROL14:
+      // Only produced by clients that merge pairs themselves; split it again
+      if (ctrl.param < 32) {
+        deliverShort(timeNs, 3, 0xB0 | channel, ctrl.param, (ctrl.value >> 7) & 0x7F);
+        deliverShort(timeNs, 3, 0xB0 | channel, ctrl.param + 32, ctrl.value & 0x7F);
+      } else {
+        deliverShort(timeNs, 3, 0xB0 | channel, ctrl.param & 0x7F, ctrl.value & 0x7F);
+      }
+      break;
+    case SND_SEQ_EVENT_NONREGPARAM:
+    case SND_SEQ_EVENT_REGPARAM: {
+      bool registered = ev->type == SND_SEQ_EVENT_REGPARAM;
+      deliverShort(timeNs, 3, 0xB0 | channel, registered ? 101 : 99, (ctrl.param >> 7) & 0x7F);
+      deliverShort(timeNs, 3, 0xB0 | channel, registered ? 100 : 98, ctrl.param & 0x7F);
+      deliverShort(timeNs, 3, 0xB0 | channel, 6, (ctrl.value >> 7) & 0x7F);
+      deliverShort(timeNs, 3, 0xB0 | channel, 38, ctrl.value & 0x7F);
+      break;
+    }
+    case SND_SEQ_EVENT_SONGPOS:
+      deliverShort(timeNs, 3, 0xF2, ctrl.value & 0x7F, (ctrl.value >> 7) & 0x7F);
+      break;
+    case SND_SEQ_EVENT_SONGSEL:
+      deliverShort(timeNs, 2, 0xF3, ctrl.value & 0x7F);
+      break;
+    case SND_SEQ_EVENT_QFRAME:
+      if (!ignoreFlags_[1].load(std::memory_order_relaxed))
+        deliverShort(timeNs, 2, 0xF1, ctrl.value & 0x7F);
+      break;
+    case SND_SEQ_EVENT_TUNE_REQUEST:
+      deliverShort(timeNs, 1, 0xF6);
+      break;
+    case SND_SEQ_EVENT_CLOCK:
+      if (!ignoreFlags_[1].load(std::memory_order_relaxed))
+        deliverShort(timeNs, 1, 0xF8);
+      break;
+    case SND_SEQ_EVENT_TICK:
+      if (!ignoreFlags_[1].load(std::memory_order_relaxed))
+        deliverShort(timeNs, 1, 0xF9);
+      break;
+    case SND_SEQ_EVENT_START:
+    case SND_SEQ_EVENT_CONTINUE:
+    case SND_SEQ_EVENT_STOP:
+      deliverShort(timeNs, 1, ev->type == SND_SEQ_EVENT_START ? 0xFA
+                            : ev->type == SND_SEQ_EVENT_CONTINUE ? 0xFB : 0xFC);
+      break;
+    case SND_SEQ_EVENT_SENSING:
+      if (!ignoreFlags_[2].load(std::memory_order_relaxed))
+        deliverShort(timeNs, 1, 0xFE);
+      break;
+    case SND_SEQ_EVENT_RESET:
+      deliverShort(timeNs, 1, 0xFF);
+      break;
+    case SND_SEQ_EVENT_SYSEX:
+      if (!ignoreFlags_[0].load(std::memory_order_relaxed) && (filterTypes_ & RtMidiFilter::SYSEX))
+        deliverSysex(static_cast<const unsigned char *>(ev->data.ext.ptr), ev->data.ext.len, timeNs);
+      break;
+    default:
+      break;
+  }
+}
+
+void MidiInAlsa::deliverShort(unsigned long long timeNs, unsigned int size,
+                              unsigned char b0, unsigned char b1, unsigned char b2)
+{
+  // Any status byte other than real-time ends an unterminated SysEx
+  if (sysexActive_ && b0 < 0xF8) {
+    sysexActive_ = false;
+    sysexPool_.clear();
+  }
+
+  RtMidiEvent event;
+  setEventBytes(event, size, b0, b1 & 0x7F, b2 & 0x7F);
+  event.timeNs = timeNs;
+  deliverEvent(event);
+}
+
+void MidiInAlsa::deliverSysex(const unsigned char *chunk, unsigned int len, unsigned long long timeNs)
+{
+  if (!chunk || len == 0) return;
+
+  bool starts = chunk[0] == 0xF0;
+  bool ends = chunk[len - 1] == 0xF7;
+
+  RtMidiEvent event;
+  event.size = 0;
+
+  if (starts && ends) {
+    // Complete in one event: point straight at the sequencer's buffer
+    sysexActive_ = false;
+    sysexPool_.clear();
+    event.sysex = chunk;
+    event.size = len;
+    event.timeNs = timeNs;
+    deliverEvent(event);
+    return;
+  }
+
+  if (starts) {
+    // A new start abandons any message that never saw its F7
+    sysexPool_.clear();
+    sysexActive_ = true;
+    sysexOverflow_ = false;
+    sysexTimeNs_ = timeNs;
+  } else if (!sysexActive_) {
+    return;  // continuation of a message whose start we missed
+  }
+
+  // Stay within the preallocated pool so the input thread never allocates
+  if (!sysexOverflow_ && sysexPool_.size() + len <= sysexPool_.capacity()) {
+    sysexPool_.insert(sysexPool_.end(), chunk, chunk + len);
+  } else {
+    sysexOverflow_ = true;
+  }
+
+  if (!ends) return;
+
+  sysexActive_ = false;
+  if (sysexOverflow_) {
+    sysexPool_.clear();
+    errorString_ = "MidiInAlsa::alsaMidiHandler: SysEx message larger than the reassembly buffer, dropped.";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  event.sysex = sysexPool_.data();
+  event.size = (unsigned int)sysexPool_.size();
+  event.timeNs = sysexTimeNs_;
+  deliverEvent(event);
+  sysexPool_.clear();
+}
+
+int MidiInAlsa::createInputPort(const std::string &portName)
+{
+  snd_seq_port_info_t *pinfo;
+  snd_seq_port_info_alloca(&pinfo);
+  snd_seq_port_info_set_name(pinfo, portName.c_str());
+  snd_seq_port_info_set_capability(pinfo, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE);
+  snd_seq_port_info_set_type(pinfo, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  snd_seq_port_info_set_midi_channels(pinfo, 16);
+  if (queueId_ >= 0) {
+    snd_seq_port_info_set_timestamping(pinfo, 1);
+    snd_seq_port_info_set_timestamp_real(pinfo, 1);
+    snd_seq_port_info_set_timestamp_queue(pinfo, queueId_);
+  }
+
+  if (snd_seq_create_port(seq_, pinfo) < 0)
+    return -1;
+  return snd_seq_port_info_get_port(pinfo);
+}
+
+void MidiInAlsa::startInput()
+{
+  // The port watcher may already be running; it must not see connected_
+  // change under it
+  stopThread();
+  connected_ = true;
+  if (queueId_ >= 0) {
+    snd_seq_start_queue(seq_, queueId_, nullptr);
+    snd_seq_drain_output(seq_);
+    queueStartNs_ = monotonicNanos();
+  }
+  firstMessage_ = true;
+  sysexActive_ = false;
+  sysexPool_.clear();
+
+  startThread();
+}
+
+void MidiInAlsa::startThread()
+{
+  if (threadRunning_) return;
+  threadRunning_ = true;
+  if (pthread_create(&thread_, nullptr, alsaMidiHandler, this) != 0) {
+    threadRunning_ = false;
+    errorString_ = "MidiInAlsa::startThread: error starting MIDI input thread!";
+    error(RtMidiError::THREAD_ERROR, errorString_);
+  }
+}
+
+void MidiInAlsa::stopThread()
+{
+  if (!threadRunning_) return;
+  threadRunning_ = false;
+  char wake = 1;
+  if (triggerFds_[1] >= 0 && write(triggerFds_[1], &wake, 1) < 0) {
+    errorString_ = "MidiInAlsa::stopThread: error writing to wakeup pipe.";
+    error(RtMidiError::WARNING, errorString_);
+  }
+  pthread_join(thread_, nullptr);
+}
+
+void MidiInAlsa::openPort(unsigned int portNumber, const std::string &portName)
+{
+  if (connected_) {
+    errorString_ = "MidiInAlsa::openPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, ports);
+  if (ports.empty()) {
+    errorString_ = "MidiInAlsa::openPort: no MIDI input sources found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiInAlsa::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
+}
+
+bool MidiInAlsa::isInputSource(int client, int port)
+{
+  snd_seq_port_info_t *pinfo;
+  snd_seq_port_info_alloca(&pinfo);
+  const unsigned int readable = SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ;
+  return client >= 0 && port >= 0 && snd_seq_get_any_port_info(seq_, client, port, pinfo) >= 0
+         && (snd_seq_port_info_get_capability(pinfo) & readable) == readable;
+}
+
+// Subscribe our input port to a sender through the timestamp queue, so
+// events carry real arrival times.  The source slot is claimed first so
+// the very first event is tagged correctly.
+bool MidiInAlsa::subscribeSource(int sourceId, int client, int port)
+{
+  sourceAddr_[sourceId].store(client << 8 | port, std::memory_order_release);
+
+  snd_seq_addr_t sender, dest;
+  sender.client = client;
+  sender.port = port;
+  dest.client = snd_seq_client_id(seq_);
+  dest.port = portNum_;
+
+  snd_seq_port_subscribe_t *subs;
+  snd_seq_port_subscribe_alloca(&subs);
+  snd_seq_port_subscribe_set_sender(subs, &sender);
+  snd_seq_port_subscribe_set_dest(subs, &dest);
+  if (queueId_ >= 0) {
+    snd_seq_port_subscribe_set_queue(subs, queueId_);
+    snd_seq_port_subscribe_set_time_update(subs, 1);
+    snd_seq_port_subscribe_set_time_real(subs, 1);
+  }
+
+  if (snd_seq_subscribe_port(seq_, subs) < 0) {
+    sourceAddr_[sourceId].store(-1, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+unsigned char MidiInAlsa::lookupSource(const snd_seq_addr_t &sender) const
+{
+  int addr = sender.client << 8 | sender.port;
+  for (int i = 0; i < RtMidiIn::MAX_SOURCES; i++) {
+    if (sourceAddr_[i].load(std::memory_order_acquire) == addr)
+      return (unsigned char)i;
+  }
+  return RtMidiIn::UNKNOWN_SOURCE;
+}
+
+void MidiInAlsa::openPortAddress(int srcClient, int srcPort, const std::string &portName)
+{
+  if (connected_) {
+    errorString_ = "MidiInAlsa::openPortAddress: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  if (!isInputSource(srcClient, srcPort)) {
+    errorString_ = "MidiInAlsa::openPortAddress: no MIDI input source at that address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  portNum_ = createInputPort(portName);
+
+  if (portNum_ < 0) {
+    errorString_ = "MidiInAlsa::openPortAddress: error creating port.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  if (!subscribeSource(0, srcClient, srcPort)) {
+    snd_seq_delete_port(seq_, portNum_);
+    portNum_ = -1;
+    errorString_ = "MidiInAlsa::openPortAddress: error subscribing to input port.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  startInput();
+}
+
+// Further sources are subscribed to the same application port, so they
+// share the input thread, the queue and the timestamp queue.
+int MidiInAlsa::addSource(int srcClient, int srcPort, int sourceId, const std::string &portName)
+{
+  if (!isInputSource(srcClient, srcPort)) {
+    errorString_ = "MidiInAlsa::addSource: no MIDI input source at that address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return -1;
+  }
+
+  int addr = srcClient << 8 | srcPort;
+  for (int i = 0; i < RtMidiIn::MAX_SOURCES; i++) {
+    if (sourceAddr_[i].load(std::memory_order_relaxed) == addr) {
+      errorString_ = "MidiInAlsa::addSource: already subscribed to that source!";
+      error(RtMidiError::WARNING, errorString_);
+      return -1;
+    }
+  }
+
+  if (sourceId < 0) {
+    for (int i = 0; i < RtMidiIn::MAX_SOURCES && sourceId < 0; i++) {
+      if (sourceAddr_[i].load(std::memory_order_relaxed) < 0)
+        sourceId = i;
+    }
+    if (sourceId < 0) {
+      errorString_ = "MidiInAlsa::addSource: too many sources!";
+      error(RtMidiError::INVALID_USE, errorString_);
+      return -1;
+    }
+  }
+  else if (sourceId >= RtMidiIn::MAX_SOURCES || sourceAddr_[sourceId].load(std::memory_order_relaxed) >= 0) {
+    errorString_ = "MidiInAlsa::addSource: source id out of range or in use!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return -1;
+  }
+
+  bool opening = !connected_;
+  if (opening) {
+    portNum_ = createInputPort(portName);
+    if (portNum_ < 0) {
+      errorString_ = "MidiInAlsa::addSource: error creating port.";
+      error(RtMidiError::DRIVER_ERROR, errorString_);
+      return -1;
+    }
+  }
+
+  if (!subscribeSource(sourceId, srcClient, srcPort)) {
+    if (opening) {
+      snd_seq_delete_port(seq_, portNum_);
+      portNum_ = -1;
+    }
+    errorString_ = "MidiInAlsa::addSource: error subscribing to input port.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return -1;
+  }
+
+  if (opening) startInput();
+  return sourceId;
+}
+
+void MidiInAlsa::removeSource(int sourceId)
+{
+  if (sourceId < 0 || sourceId >= RtMidiIn::MAX_SOURCES) return;
+  int addr = sourceAddr_[sourceId].exchange(-1, std::memory_order_acq_rel);
+  if (addr < 0) {
+    errorString_ = "MidiInAlsa::removeSource: no such source!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  // Fails harmlessly when the sender is already gone, which ends the
+  // subscription on its own
+  snd_seq_disconnect_from(seq_, portNum_, addr >> 8, addr & 0xFF);
+}
+
+void MidiInAlsa::openVirtualPort(const std::string &portName)
 {
   if (connected_) {
     errorString_ = "MidiInAlsa::openVirtualPort: a valid connection already exists!";
@@ -973,9 +1995,7 @@ void MidiInAlsa::openVirtualPort(const std::string &portName)
     return;
   }
 
-  portNum_ = snd_seq_create_simple_port(seq_, portName.c_str(),
-    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
-    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  portNum_ = createInputPort(portName);
 
   if (portNum_ < 0) {
     errorString_ = "MidiInAlsa::openVirtualPort: error creating port.";
@@ -983,23 +2003,26 @@ void MidiInAlsa::openVirtualPort(const std::string &portName)
     return;
   }
 
-  threadRunning_ = true;
-  pthread_create(&thread_, nullptr, alsaMidiHandler, this);
-
-  connected_ = true;
+  startInput();
 }
 
 void MidiInAlsa::closePort()
 {
-  if (threadRunning_) {
-    threadRunning_ = false;
-    pthread_join(thread_, nullptr);
+  stopThread();
+  if (connected_ && queueId_ >= 0) {
+    snd_seq_stop_queue(seq_, queueId_, nullptr);
+    snd_seq_drain_output(seq_);
   }
   if (portNum_ >= 0) {
     snd_seq_delete_port(seq_, portNum_);
     portNum_ = -1;
   }
+  for (auto &addr : sourceAddr_)
+    addr.store(-1, std::memory_order_relaxed);
   connected_ = false;
+
+  // Keep reporting port changes while no port is open
+  if (portCallback_) startThread();
 }
 
 void MidiInAlsa::setClientName(const std::string &clientName)
@@ -1033,17 +2056,26 @@ public:
   void setPortName(const std::string &portName) override;
   unsigned int getPortCount() override;
   std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
   void sendMessage(const unsigned char *message, size_t size) override;
+  void sendEvents(const RtMidiEvent *events, unsigned int count) override;
 
 private:
+  enum { SYSEX_CHUNK_SIZE = 256 };
+
   snd_seq_t *seq_;
   int portNum_;
   int destClient_;
   int destPort_;
+  int queueId_;                        // schedules sendEvents() with future times
+  unsigned long long queueStartNs_;
+  bool outputMessage(const unsigned char *message, size_t size, unsigned long long timeNs);
+  void startQueue();
 };
 
 MidiOutAlsa::MidiOutAlsa(const std::string &clientName)
-  : MidiOutApi(), seq_(nullptr), portNum_(-1), destClient_(-1), destPort_(-1)
+  : MidiOutApi(), seq_(nullptr), portNum_(-1), destClient_(-1), destPort_(-1), queueId_(-1), queueStartNs_(0)
 {
   if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
     errorString_ = "MidiOutAlsa::MidiOutAlsa: error creating ALSA sequencer client.";
@@ -1056,59 +2088,28 @@ MidiOutAlsa::MidiOutAlsa(const std::string &clientName)
 MidiOutAlsa::~MidiOutAlsa()
 {
   closePort();
+  if (queueId_ >= 0) snd_seq_free_queue(seq_, queueId_);
   if (seq_) snd_seq_close(seq_);
 }
 
 unsigned int MidiOutAlsa::getPortCount()
 {
-  snd_seq_port_info_t *pinfo;
-  snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
-  snd_seq_client_info_alloca(&cinfo);
-
-  unsigned int count = 0;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_WRITE) && (caps & SND_SEQ_PORT_CAP_SUBS_WRITE))
-        count++;
-    }
-  }
-  return count;
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE, ports);
+  return (unsigned int)ports.size();
 }
 
 std::string MidiOutAlsa::getPortName(unsigned int portNumber)
 {
-  snd_seq_port_info_t *pinfo;
-  snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
-  snd_seq_client_info_alloca(&cinfo);
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE, ports);
+  if (portNumber >= ports.size()) return "";
+  return ports[portNumber].name;
+}
 
-  unsigned int count = 0;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_WRITE) && (caps & SND_SEQ_PORT_CAP_SUBS_WRITE)) {
-        if (count == portNumber) {
-          std::ostringstream os;
-          os << snd_seq_client_info_get_name(cinfo) << ":" << snd_seq_port_info_get_name(pinfo);
-          return os.str();
-        }
-        count++;
-      }
-    }
-  }
-  return "";
+void MidiOutAlsa::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE, ports);
 }
 
 void MidiOutAlsa::openPort(unsigned int portNumber, const std::string &portName)
@@ -1119,44 +2120,43 @@ void MidiOutAlsa::openPort(unsigned int portNumber, const std::string &portName)
     return;
   }
 
-  snd_seq_port_info_t *pinfo;
-  snd_seq_client_info_t *cinfo;
-  snd_seq_port_info_alloca(&pinfo);
-  snd_seq_client_info_alloca(&cinfo);
+  std::vector<RtMidiPortInfo> ports;
+  alsaEnumeratePorts(seq_, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE, ports);
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiOutAlsa::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
 
-  unsigned int count = 0;
-  snd_seq_client_info_set_client(cinfo, -1);
-  while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
-    int client = snd_seq_client_info_get_client(cinfo);
-    if (client == snd_seq_client_id(seq_)) continue;
-    snd_seq_port_info_set_client(pinfo, client);
-    snd_seq_port_info_set_port(pinfo, -1);
-    while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
-      unsigned int caps = snd_seq_port_info_get_capability(pinfo);
-      if ((caps & SND_SEQ_PORT_CAP_WRITE) && (caps & SND_SEQ_PORT_CAP_SUBS_WRITE)) {
-        if (count == portNumber) {
-          destClient_ = snd_seq_port_info_get_client(pinfo);
-          destPort_ = snd_seq_port_info_get_port(pinfo);
-          break;
-        }
-        count++;
-      }
-    }
-    if (destClient_ >= 0) break;
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
+}
+
+void MidiOutAlsa::openPortAddress(int client, int port, const std::string &portName)
+{
+  if (connected_) {
+    errorString_ = "MidiOutAlsa::openPortAddress: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
   }
 
-  if (destClient_ < 0) {
-    errorString_ = "MidiOutAlsa::openPort: invalid port number!";
+  snd_seq_port_info_t *pinfo;
+  snd_seq_port_info_alloca(&pinfo);
+  const unsigned int writable = SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE;
+  if (client < 0 || port < 0 || snd_seq_get_any_port_info(seq_, client, port, pinfo) < 0
+      || (snd_seq_port_info_get_capability(pinfo) & writable) != writable) {
+    errorString_ = "MidiOutAlsa::openPortAddress: no MIDI output destination at that address!";
     error(RtMidiError::INVALID_PARAMETER, errorString_);
     return;
   }
+  destClient_ = client;
+  destPort_ = port;
 
   portNum_ = snd_seq_create_simple_port(seq_, portName.c_str(),
     SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
     SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
 
   if (portNum_ < 0) {
-    errorString_ = "MidiOutAlsa::openPort: error creating port.";
+    errorString_ = "MidiOutAlsa::openPortAddress: error creating port.";
     error(RtMidiError::DRIVER_ERROR, errorString_);
     return;
   }
@@ -1213,65 +2213,1112 @@ void MidiOutAlsa::setPortName(const std::string &portName)
   }
 }
 
-void MidiOutAlsa::sendMessage(const unsigned char *message, size_t size)
+// Encode one message into the client's output buffer without draining
+// it.  A nonzero timeNs schedules it on the output queue for that
+// monotonic time.  Returns false if nothing was queued.
+bool MidiOutAlsa::outputMessage(const unsigned char *message, size_t size, unsigned long long timeNs)
 {
-  if (!connected_) {
-    errorString_ = "MidiOutAlsa::sendMessage: no open port!";
+  if (size == 0 || !message) return false;
+
+  unsigned char status = message[0];
+  if (status < 0x80) {
+    errorString_ = "MidiOutAlsa::outputMessage: message does not start with a status byte (running status is not supported).";
     error(RtMidiError::WARNING, errorString_);
-    return;
+    return false;
+  }
+
+  size_t expected = (status == 0xF0) ? 2 : expectedMessageSize(status);
+  if (expected == 0 || size < expected) {
+    errorString_ = "MidiOutAlsa::outputMessage: incomplete or undefined MIDI message.";
+    error(RtMidiError::WARNING, errorString_);
+    return false;
   }
 
   snd_seq_event_t ev;
   snd_seq_ev_clear(&ev);
   snd_seq_ev_set_source(&ev, portNum_);
   snd_seq_ev_set_subs(&ev);
-  snd_seq_ev_set_direct(&ev);
+  if (timeNs > queueStartNs_ && queueId_ >= 0) {
+    snd_seq_real_time_t when;
+    unsigned long long queueNs = timeNs - queueStartNs_;
+    when.tv_sec = (unsigned int)(queueNs / 1000000000ULL);
+    when.tv_nsec = (unsigned int)(queueNs % 1000000000ULL);
+    snd_seq_ev_schedule_real(&ev, queueId_, 0, &when);
+  } else {
+    snd_seq_ev_set_direct(&ev);
+  }
+
+  if (status == 0xF0) {
+    // Large SysEx goes out in chunks so it never exceeds the client's
+    // output buffer; the receiving side sees one continuous byte stream.
+    for (size_t offset = 0; offset < size; offset += SYSEX_CHUNK_SIZE) {
+      size_t len = std::min<size_t>(SYSEX_CHUNK_SIZE, size - offset);
+      snd_seq_ev_set_sysex(&ev, (unsigned int)len, const_cast<unsigned char *>(message + offset));
+      if (snd_seq_event_output(seq_, &ev) < 0) {
+        errorString_ = "MidiOutAlsa::outputMessage: error sending SysEx chunk.";
+        error(RtMidiError::WARNING, errorString_);
+        return false;
+      }
+    }
+    return true;
+  }
 
-  unsigned char status = message[0];
-  unsigned char type = status >> 4;
+  snd_seq_ev_set_fixed(&ev);
   unsigned char channel = status & 0x0F;
+  unsigned char d1 = size > 1 ? message[1] & 0x7F : 0;
+  unsigned char d2 = size > 2 ? message[2] & 0x7F : 0;
+
+  switch (status >> 4) {
+    case 0x8:  // Note Off
+      snd_seq_ev_set_noteoff(&ev, channel, d1, d2);
+      break;
+    case 0x9:  // Note On
+      snd_seq_ev_set_noteon(&ev, channel, d1, d2);
+      break;
+    case 0xA:  // Polyphonic Aftertouch
+      snd_seq_ev_set_keypress(&ev, channel, d1, d2);
+      break;
+    case 0xB:  // Control Change
+      snd_seq_ev_set_controller(&ev, channel, d1, d2);
+      break;
+    case 0xC:  // Program Change
+      snd_seq_ev_set_pgmchange(&ev, channel, d1);
+      break;
+    case 0xD:  // Channel Aftertouch
+      snd_seq_ev_set_chanpress(&ev, channel, d1);
+      break;
+    case 0xE:  // Pitch Bend, centred on 0 for ALSA
+      snd_seq_ev_set_pitchbend(&ev, channel, ((d2 << 7) | d1) - 8192);
+      break;
+    case 0xF:  // System Common / Real-Time
+      switch (status) {
+        case 0xF1:
+          ev.type = SND_SEQ_EVENT_QFRAME;
+          ev.data.control.value = d1;
+          break;
+        case 0xF2:
+          ev.type = SND_SEQ_EVENT_SONGPOS;
+          ev.data.control.value = (d2 << 7) | d1;
+          break;
+        case 0xF3:
+          ev.type = SND_SEQ_EVENT_SONGSEL;
+          ev.data.control.value = d1;
+          break;
+        case 0xF6: ev.type = SND_SEQ_EVENT_TUNE_REQUEST; break;
+        case 0xF8: ev.type = SND_SEQ_EVENT_CLOCK; break;
+        case 0xF9: ev.type = SND_SEQ_EVENT_TICK; break;
+        case 0xFA: ev.type = SND_SEQ_EVENT_START; break;
+        case 0xFB: ev.type = SND_SEQ_EVENT_CONTINUE; break;
+        case 0xFC: ev.type = SND_SEQ_EVENT_STOP; break;
+        case 0xFE: ev.type = SND_SEQ_EVENT_SENSING; break;
+        case 0xFF: ev.type = SND_SEQ_EVENT_RESET; break;
+        default:
+          return false;
+      }
+      break;
+  }
+
+  if (snd_seq_event_output(seq_, &ev) < 0) {
+    errorString_ = "MidiOutAlsa::outputMessage: error sending event.";
+    error(RtMidiError::WARNING, errorString_);
+    return false;
+  }
+  return true;
+}
+
+void MidiOutAlsa::sendMessage(const unsigned char *message, size_t size)
+{
+  if (!connected_) {
+    errorString_ = "MidiOutAlsa::sendMessage: no open port!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  if (outputMessage(message, size, 0))
+    snd_seq_drain_output(seq_);
+}
+
+void MidiOutAlsa::sendEvents(const RtMidiEvent *events, unsigned int count)
+{
+  if (!connected_) {
+    errorString_ = "MidiOutAlsa::sendEvents: no open port!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  unsigned long long now = MidiInApi::monotonicNanos();
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned long long timeNs = events[i].timeNs > now ? events[i].timeNs : 0;
+    // The queue is only created once something is actually scheduled
+    if (timeNs && queueId_ < 0) startQueue();
+    outputMessage(events[i].data(), events[i].size, timeNs);
+  }
+  // One write to the kernel for the whole batch
+  snd_seq_drain_output(seq_);
+}
+
+void MidiOutAlsa::startQueue()
+{
+  queueId_ = snd_seq_alloc_named_queue(seq_, "RtMidi Output Queue");
+  if (queueId_ < 0) {
+    errorString_ = "MidiOutAlsa::startQueue: error allocating output queue, sending immediately.";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  snd_seq_start_queue(seq_, queueId_, nullptr);
+  snd_seq_drain_output(seq_);
+  queueStartNs_ = MidiInApi::monotonicNanos();
+}
+
+// ALSA raw MIDI implementation
+//
+// Reads and writes a card's rawmidi device directly, skipping the
+// sequencer's routing hop and per-event conversion.  Only hardware ports
+// are available, one per input, addressed as client = card and
+// port = device << 8 | subdevice.  The byte stream is parsed here, so
+// events are timestamped when a read returns instead of by the kernel.
+
+// Walk every card's rawmidi devices once, collecting the subdevices that
+// have a stream in the given direction.
+static void rawmidiEnumeratePorts(snd_rawmidi_stream_t stream, std::vector<RtMidiPortInfo> &ports)
+{
+  ports.clear();
+
+  snd_rawmidi_info_t *info;
+  snd_rawmidi_info_alloca(&info);
+
+  int card = -1;
+  while (snd_card_next(&card) >= 0 && card >= 0) {
+    char ctlName[32];
+    snprintf(ctlName, sizeof(ctlName), "hw:%d", card);
+    snd_ctl_t *ctl;
+    if (snd_ctl_open(&ctl, ctlName, 0) < 0) continue;
+
+    int device = -1;
+    while (snd_ctl_rawmidi_next_device(ctl, &device) >= 0 && device >= 0) {
+      snd_rawmidi_info_set_device(info, device);
+      snd_rawmidi_info_set_subdevice(info, 0);
+      snd_rawmidi_info_set_stream(info, stream);
+      if (snd_ctl_rawmidi_info(ctl, info) < 0) continue;
+
+      unsigned int subdevices = snd_rawmidi_info_get_subdevices_count(info);
+      for (unsigned int sub = 0; sub < subdevices; sub++) {
+        snd_rawmidi_info_set_subdevice(info, sub);
+        if (snd_ctl_rawmidi_info(ctl, info) < 0) continue;
+
+        const char *subName = snd_rawmidi_info_get_subdevice_name(info);
+        char address[32];
+        snprintf(address, sizeof(address), " hw:%d,%d,%u", card, device, sub);
+
+        RtMidiPortInfo port;
+        port.name = std::string(subdevices > 1 && subName[0] ? subName : snd_rawmidi_info_get_name(info)) + address;
+        port.client = card;
+        port.port = (device << 8) | (int)sub;
+        port.capabilities = RtMidiPortInfo::HARDWARE
+                            | (stream == SND_RAWMIDI_STREAM_INPUT ? RtMidiPortInfo::INPUT : RtMidiPortInfo::OUTPUT);
+        ports.push_back(port);
+      }
+    }
+    snd_ctl_close(ctl);
+  }
+}
+
+static std::string rawmidiDeviceName(int card, int port)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "hw:%d,%d,%d", card, port >> 8, port & 0xFF);
+  return name;
+}
+
+// Raw MIDI Input
+
+class MidiInRawMidi : public MidiInApi
+{
+public:
+  MidiInRawMidi(const std::string &clientName, unsigned int queueSizeLimit);
+  ~MidiInRawMidi();
+  RtMidi::Api getCurrentApi() override { return RtMidi::LINUX_RAWMIDI; }
+  void openPort(unsigned int portNumber, const std::string &portName) override;
+  void openVirtualPort(const std::string &portName) override;
+  void closePort() override;
+  void setClientName(const std::string &clientName) override;
+  void setPortName(const std::string &portName) override;
+  unsigned int getPortCount() override;
+  std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
+  bool setThreadOptions(const RtMidiThreadOptions &options) override;
+
+private:
+  enum { READ_SIZE = 256 };
+
+  snd_rawmidi_t *handle_;
+  pthread_t thread_;
+  std::atomic<bool> threadRunning_;
+  int triggerFds_[2];
+  // Stream parser state, input thread only
+  unsigned char status_;               // status of the message being read, kept for running status
+  unsigned char data_[2];
+  unsigned int dataCount_;
+  unsigned int dataNeeded_;
+  bool sysexActive_;                   // a SysEx message is being reassembled
+  bool sysexOverflow_;                 // ... and it no longer fits the pool
+  unsigned long long sysexTimeNs_;     // arrival time of its F0
+  void parseBytes(const unsigned char *bytes, size_t count, unsigned long long timeNs);
+  void deliverShort(unsigned long long timeNs, unsigned int size,
+                    unsigned char b0, unsigned char b1 = 0, unsigned char b2 = 0);
+  void finishSysex();
+  void startThread();
+  void stopThread();
+  static void *rawMidiHandler(void *ptr);
+};
+
+MidiInRawMidi::MidiInRawMidi(const std::string & /*clientName*/, unsigned int queueSizeLimit)
+  : MidiInApi(queueSizeLimit), handle_(nullptr), threadRunning_(false), status_(0), dataCount_(0),
+    dataNeeded_(0), sysexActive_(false), sysexOverflow_(false), sysexTimeNs_(0)
+{
+  // Self-pipe used by closePort() to wake the input thread out of poll().
+  if (pipe2(triggerFds_, O_NONBLOCK | O_CLOEXEC) < 0) {
+    triggerFds_[0] = triggerFds_[1] = -1;
+    errorString_ = "MidiInRawMidi::MidiInRawMidi: error creating wakeup pipe.";
+    error(RtMidiError::SYSTEM_ERROR, errorString_);
+  }
+}
+
+MidiInRawMidi::~MidiInRawMidi()
+{
+  closePort();
+  if (triggerFds_[0] >= 0) close(triggerFds_[0]);
+  if (triggerFds_[1] >= 0) close(triggerFds_[1]);
+}
+
+unsigned int MidiInRawMidi::getPortCount()
+{
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_INPUT, ports);
+  return (unsigned int)ports.size();
+}
+
+std::string MidiInRawMidi::getPortName(unsigned int portNumber)
+{
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_INPUT, ports);
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiInRawMidi::getPortName: invalid port number!";
+    error(RtMidiError::WARNING, errorString_);
+    return "";
+  }
+  return ports[portNumber].name;
+}
+
+void MidiInRawMidi::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_INPUT, ports);
+}
+
+void MidiInRawMidi::openPort(unsigned int portNumber, const std::string &portName)
+{
+  if (connected_) {
+    errorString_ = "MidiInRawMidi::openPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_INPUT, ports);
+  if (ports.empty()) {
+    errorString_ = "MidiInRawMidi::openPort: no raw MIDI input devices found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiInRawMidi::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
+}
+
+void MidiInRawMidi::openPortAddress(int client, int port, const std::string & /*portName*/)
+{
+  if (connected_) {
+    errorString_ = "MidiInRawMidi::openPortAddress: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  if (client < 0 || port < 0) {
+    errorString_ = "MidiInRawMidi::openPortAddress: invalid port address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  if (snd_rawmidi_open(&handle_, nullptr, rawmidiDeviceName(client, port).c_str(), SND_RAWMIDI_NONBLOCK) < 0) {
+    handle_ = nullptr;
+    errorString_ = "MidiInRawMidi::openPortAddress: error opening raw MIDI device.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  connected_ = true;
+  firstMessage_ = true;
+  status_ = 0;
+  dataCount_ = 0;
+  sysexActive_ = false;
+  sysexPool_.clear();
+  startThread();
+}
+
+void MidiInRawMidi::openVirtualPort(const std::string & /*portName*/)
+{
+  errorString_ = "MidiInRawMidi::openVirtualPort: virtual ports are not supported by raw MIDI.";
+  error(RtMidiError::WARNING, errorString_);
+}
+
+bool MidiInRawMidi::setThreadOptions(const RtMidiThreadOptions &options)
+{
+  // Bytes wait in the device buffer while the thread restarts
+  bool running = threadRunning_;
+  stopThread();
+  threadOptions_ = options;
+  if (running) startThread();
+  return true;
+}
+
+void MidiInRawMidi::startThread()
+{
+  if (threadRunning_) return;
+  threadRunning_ = true;
+  if (pthread_create(&thread_, nullptr, rawMidiHandler, this) != 0) {
+    threadRunning_ = false;
+    errorString_ = "MidiInRawMidi::startThread: error starting MIDI input thread!";
+    error(RtMidiError::THREAD_ERROR, errorString_);
+  }
+}
+
+void MidiInRawMidi::stopThread()
+{
+  if (!threadRunning_) return;
+  threadRunning_ = false;
+  char wake = 1;
+  if (triggerFds_[1] >= 0 && write(triggerFds_[1], &wake, 1) < 0) {
+    errorString_ = "MidiInRawMidi::stopThread: error writing to wakeup pipe.";
+    error(RtMidiError::WARNING, errorString_);
+  }
+  pthread_join(thread_, nullptr);
+}
+
+void MidiInRawMidi::closePort()
+{
+  stopThread();
+  if (handle_) {
+    snd_rawmidi_close(handle_);
+    handle_ = nullptr;
+  }
+  connected_ = false;
+}
+
+void MidiInRawMidi::setClientName(const std::string & /*clientName*/)
+{
+  // Raw MIDI devices have no client
+}
+
+void MidiInRawMidi::setPortName(const std::string & /*portName*/)
+{
+  // Raw MIDI devices have no application port
+}
+
+void *MidiInRawMidi::rawMidiHandler(void *ptr)
+{
+  MidiInRawMidi *data = static_cast<MidiInRawMidi *>(ptr);
+  data->applyThreadOptions();
+
+  int devFdCount = snd_rawmidi_poll_descriptors_count(data->handle_);
+  std::vector<struct pollfd> pollFds(devFdCount + 1);
+  pollFds[0].fd = data->triggerFds_[0];
+  pollFds[0].events = POLLIN;
+  snd_rawmidi_poll_descriptors(data->handle_, &pollFds[1], devFdCount);
+
+  // Without a wakeup pipe, fall back to a short timeout so closePort() can't hang.
+  int timeoutMs = data->triggerFds_[0] >= 0 ? -1 : 10;
+
+  // Read until the device has nothing left, then hand the batch over
+  // and sleep.  Bytes go from the read buffer straight into events.
+  unsigned char buffer[READ_SIZE];
+  while (data->threadRunning_) {
+    ssize_t count = snd_rawmidi_read(data->handle_, buffer, sizeof(buffer));
+    if (count > 0) {
+      data->parseBytes(buffer, (size_t)count, monotonicNanos());
+      continue;
+    }
+
+    data->flushBatch();
+    if (count < 0 && count != -EAGAIN && count != -EINTR) {
+      // Typically -ENODEV once the device is unplugged
+      data->errorString_ = std::string("MidiInRawMidi::rawMidiHandler: read failed, ") + snd_strerror((int)count) + ".";
+      data->error(RtMidiError::DRIVER_ERROR, data->errorString_);
+      break;
+    }
+    if (poll(pollFds.data(), pollFds.size(), timeoutMs) > 0 && (pollFds[0].revents & POLLIN)) {
+      char drain[16];
+      while (read(data->triggerFds_[0], drain, sizeof(drain)) > 0) {}
+    }
+  }
+  data->flushBatch();
+  return nullptr;
+}
+
+// MIDI 1.0 byte stream to events.  Handles running status, real-time
+// bytes interleaved anywhere (including inside SysEx and between a status
+// and its data), and SysEx split across reads.
+void MidiInRawMidi::parseBytes(const unsigned char *bytes, size_t count, unsigned long long timeNs)
+{
+  for (size_t i = 0; i < count; i++) {
+    unsigned char byte = bytes[i];
+
+    if (byte >= 0xF8) {
+      // Real-time: delivered on its own, leaves the message in progress alone
+      if (byte == 0xFD) continue;  // undefined
+      if ((byte == 0xF8 || byte == 0xF9) && ignoreFlags_[1].load(std::memory_order_relaxed)) continue;
+      if (byte == 0xFE && ignoreFlags_[2].load(std::memory_order_relaxed)) continue;
+      deliverShort(timeNs, 1, byte);
+      continue;
+    }
+
+    if (byte < 0x80) {
+      if (sysexActive_) {
+        // Stay within the preallocated pool so the input thread never allocates
+        if (sysexPool_.size() < sysexPool_.capacity())
+          sysexPool_.push_back(byte);
+        else
+          sysexOverflow_ = true;
+        continue;
+      }
+      if (status_ == 0) continue;  // data without a status to run from
+
+      data_[dataCount_++] = byte;
+      if (dataCount_ < dataNeeded_) continue;
+      dataCount_ = 0;
+      if (!(status_ == 0xF1 && ignoreFlags_[1].load(std::memory_order_relaxed)))
+        deliverShort(timeNs, dataNeeded_ + 1, status_, data_[0], data_[1]);
+      // Only channel messages establish running status
+      if (status_ >= 0xF0) status_ = 0;
+      continue;
+    }
+
+    // Any other status byte ends the message in progress.  System
+    // common and SysEx also cancel running status.
+    dataCount_ = 0;
+    status_ = 0;
+    if (byte == 0xF7) {
+      if (sysexActive_) {
+        if (sysexPool_.size() < sysexPool_.capacity())
+          sysexPool_.push_back(byte);
+        else
+          sysexOverflow_ = true;
+        finishSysex();
+      }
+      continue;
+    }
+
+    // An unterminated SysEx is dropped
+    sysexActive_ = false;
+    sysexPool_.clear();
+
+    if (byte == 0xF0) {
+      sysexActive_ = true;
+      sysexOverflow_ = false;
+      sysexTimeNs_ = timeNs;
+      sysexPool_.push_back(byte);
+      continue;
+    }
+
+    size_t size = expectedMessageSize(byte);
+    if (size == 0) continue;  // undefined system common
+    if (size == 1) {
+      deliverShort(timeNs, 1, byte);  // Tune Request
+      continue;
+    }
+    status_ = byte;
+    dataNeeded_ = (unsigned int)size - 1;
+  }
+}
+
+void MidiInRawMidi::deliverShort(unsigned long long timeNs, unsigned int size,
+                                 unsigned char b0, unsigned char b1, unsigned char b2)
+{
+  RtMidiEvent event;
+  setEventBytes(event, size, b0, b1, b2);
+  event.timeNs = timeNs;
+  deliverEvent(event);
+}
+
+void MidiInRawMidi::finishSysex()
+{
+  sysexActive_ = false;
+  if (ignoreFlags_[0].load(std::memory_order_relaxed)) {
+    sysexPool_.clear();
+    return;
+  }
+  if (sysexOverflow_) {
+    sysexPool_.clear();
+    errorString_ = "MidiInRawMidi::rawMidiHandler: SysEx message larger than the reassembly buffer, dropped.";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  RtMidiEvent event;
+  event.sysex = sysexPool_.data();
+  event.size = (unsigned int)sysexPool_.size();
+  event.timeNs = sysexTimeNs_;
+  deliverEvent(event);
+  sysexPool_.clear();
+}
+
+// Raw MIDI Output
+
+class MidiOutRawMidi : public MidiOutApi
+{
+public:
+  MidiOutRawMidi(const std::string &clientName);
+  ~MidiOutRawMidi();
+  RtMidi::Api getCurrentApi() override { return RtMidi::LINUX_RAWMIDI; }
+  void openPort(unsigned int portNumber, const std::string &portName) override;
+  void openVirtualPort(const std::string &portName) override;
+  void closePort() override;
+  void setClientName(const std::string &clientName) override;
+  void setPortName(const std::string &portName) override;
+  unsigned int getPortCount() override;
+  std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
+  void sendMessage(const unsigned char *message, size_t size) override;
+
+private:
+  snd_rawmidi_t *handle_;
+};
+
+MidiOutRawMidi::MidiOutRawMidi(const std::string & /*clientName*/)
+  : MidiOutApi(), handle_(nullptr)
+{
+}
+
+MidiOutRawMidi::~MidiOutRawMidi()
+{
+  closePort();
+}
+
+unsigned int MidiOutRawMidi::getPortCount()
+{
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_OUTPUT, ports);
+  return (unsigned int)ports.size();
+}
+
+std::string MidiOutRawMidi::getPortName(unsigned int portNumber)
+{
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_OUTPUT, ports);
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiOutRawMidi::getPortName: invalid port number!";
+    error(RtMidiError::WARNING, errorString_);
+    return "";
+  }
+  return ports[portNumber].name;
+}
+
+void MidiOutRawMidi::getPorts(std::vector<RtMidiPortInfo> &ports)
+{
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_OUTPUT, ports);
+}
+
+void MidiOutRawMidi::openPort(unsigned int portNumber, const std::string &portName)
+{
+  if (connected_) {
+    errorString_ = "MidiOutRawMidi::openPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  std::vector<RtMidiPortInfo> ports;
+  rawmidiEnumeratePorts(SND_RAWMIDI_STREAM_OUTPUT, ports);
+  if (ports.empty()) {
+    errorString_ = "MidiOutRawMidi::openPort: no raw MIDI output devices found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiOutRawMidi::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
+}
+
+void MidiOutRawMidi::openPortAddress(int client, int port, const std::string & /*portName*/)
+{
+  if (connected_) {
+    errorString_ = "MidiOutRawMidi::openPortAddress: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  if (client < 0 || port < 0) {
+    errorString_ = "MidiOutRawMidi::openPortAddress: invalid port address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  // Blocking, like the sequencer output: a full device buffer waits
+  // rather than dropping bytes
+  if (snd_rawmidi_open(nullptr, &handle_, rawmidiDeviceName(client, port).c_str(), 0) < 0) {
+    handle_ = nullptr;
+    errorString_ = "MidiOutRawMidi::openPortAddress: error opening raw MIDI device.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  connected_ = true;
+}
+
+void MidiOutRawMidi::openVirtualPort(const std::string & /*portName*/)
+{
+  errorString_ = "MidiOutRawMidi::openVirtualPort: virtual ports are not supported by raw MIDI.";
+  error(RtMidiError::WARNING, errorString_);
+}
+
+void MidiOutRawMidi::closePort()
+{
+  if (handle_) {
+    snd_rawmidi_close(handle_);
+    handle_ = nullptr;
+  }
+  connected_ = false;
+}
+
+void MidiOutRawMidi::setClientName(const std::string & /*clientName*/)
+{
+  // Raw MIDI devices have no client
+}
+
+void MidiOutRawMidi::setPortName(const std::string & /*portName*/)
+{
+  // Raw MIDI devices have no application port
+}
+
+void MidiOutRawMidi::sendMessage(const unsigned char *message, size_t size)
+{
+  if (!connected_) {
+    errorString_ = "MidiOutRawMidi::sendMessage: no open port!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  if (size == 0 || !message) return;
+
+  unsigned char status = message[0];
+  if (status < 0x80) {
+    errorString_ = "MidiOutRawMidi::sendMessage: message does not start with a status byte (running status is not supported).";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  size_t expected = (status == 0xF0) ? 2 : expectedMessageSize(status);
+  if (expected == 0 || size < expected) {
+    errorString_ = "MidiOutRawMidi::sendMessage: incomplete or undefined MIDI message.";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  if (status != 0xF0) size = expected;
+
+  ssize_t written = snd_rawmidi_write(handle_, message, size);
+  if (written < 0 || (size_t)written != size) {
+    errorString_ = "MidiOutRawMidi::sendMessage: error writing to raw MIDI device.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+  }
+}
+
+#endif // __LINUX_ALSA__
+
+#if defined(__WINDOWS_MM__)
+
+// Windows Multimedia implementation
+
+class MidiInWinMM : public MidiInApi
+{
+public:
+  MidiInWinMM(const std::string &clientName, unsigned int queueSizeLimit);
+  ~MidiInWinMM();
+  RtMidi::Api getCurrentApi() override { return RtMidi::WINDOWS_MM; }
+  void openPort(unsigned int portNumber, const std::string &portName) override;
+  void openVirtualPort(const std::string &portName) override;
+  void closePort() override;
+  void setClientName(const std::string &clientName) override;
+  void setPortName(const std::string &portName) override;
+  unsigned int getPortCount() override;
+  std::string getPortName(unsigned int portNumber) override;
+
+private:
+  HMIDIIN inHandle_;
+  unsigned long long startTimeNs_;
+  static void CALLBACK midiInputCallback(HMIDIIN hMidiIn, UINT wMsg, DWORD_PTR dwInstance,
+                                          DWORD_PTR dwParam1, DWORD_PTR dwParam2);
+};
+
+MidiInWinMM::MidiInWinMM(const std::string & /*clientName*/, unsigned int queueSizeLimit)
+  : MidiInApi(queueSizeLimit), inHandle_(nullptr), startTimeNs_(0)
+{
+}
+
+MidiInWinMM::~MidiInWinMM()
+{
+  closePort();
+}
+
+unsigned int MidiInWinMM::getPortCount()
+{
+  return midiInGetNumDevs();
+}
+
+std::string MidiInWinMM::getPortName(unsigned int portNumber)
+{
+  MIDIINCAPS caps;
+  if (midiInGetDevCaps(portNumber, &caps, sizeof(MIDIINCAPS)) == MMSYSERR_NOERROR) {
+    return std::string(caps.szPname);
+  }
+  return "";
+}
+
+void CALLBACK MidiInWinMM::midiInputCallback(HMIDIIN /*hMidiIn*/, UINT wMsg,
+                                              DWORD_PTR dwInstance, DWORD_PTR dwParam1,
+                                              DWORD_PTR dwParam2)
+{
+  MidiInWinMM *data = reinterpret_cast<MidiInWinMM *>(dwInstance);
+
+  if (wMsg == MIM_DATA) {
+    RtMidiEvent event;
+    unsigned char status = dwParam1 & 0xFF;
+    unsigned int size = 1;
+
+    if ((status & 0xF0) != 0xF0) {
+      size = ((status & 0xF0) != 0xC0 && (status & 0xF0) != 0xD0) ? 3 : 2;
+    }
+    setEventBytes(event, size, status, (dwParam1 >> 8) & 0xFF, (dwParam1 >> 16) & 0xFF);
+
+    // dwParam2 is the driver timestamp in milliseconds since midiInStart()
+    event.timeNs = data->startTimeNs_ + (unsigned long long)dwParam2 * 1000000ULL;
+    data->deliverEvent(event);
+    // WinMM delivers one message per callback, so there is nothing to batch
+    data->flushBatch();
+  }
+}
+
+void MidiInWinMM::openPort(unsigned int portNumber, const std::string & /*portName*/)
+{
+  if (connected_) {
+    errorString_ = "MidiInWinMM::openPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  unsigned int nDevices = midiInGetNumDevs();
+  if (nDevices == 0) {
+    errorString_ = "MidiInWinMM::openPort: no MIDI input devices found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+
+  if (portNumber >= nDevices) {
+    errorString_ = "MidiInWinMM::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  MMRESULT result = midiInOpen(&inHandle_, portNumber,
+                                (DWORD_PTR)midiInputCallback,
+                                (DWORD_PTR)this, CALLBACK_FUNCTION);
+  if (result != MMSYSERR_NOERROR) {
+    errorString_ = "MidiInWinMM::openPort: error opening MIDI input port.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  firstMessage_ = true;
+  startTimeNs_ = monotonicNanos();
+  midiInStart(inHandle_);
+  connected_ = true;
+}
+
+void MidiInWinMM::openVirtualPort(const std::string & /*portName*/)
+{
+  errorString_ = "MidiInWinMM::openVirtualPort: virtual ports are not supported on Windows.";
+  error(RtMidiError::WARNING, errorString_);
+}
+
+void MidiInWinMM::closePort()
+{
+  if (inHandle_) {
+    midiInStop(inHandle_);
+    midiInClose(inHandle_);
+    inHandle_ = nullptr;
+  }
+  connected_ = false;
+}
+
+void MidiInWinMM::setClientName(const std::string & /*clientName*/)
+{
+  // Not supported on Windows
+}
+
+void MidiInWinMM::setPortName(const std::string & /*portName*/)
+{
+  // Not supported on Windows
+}
+
+// Windows MM Output
+
+class MidiOutWinMM : public MidiOutApi
+{
+public:
+  MidiOutWinMM(const std::string &clientName);
+  ~MidiOutWinMM();
+  RtMidi::Api getCurrentApi() override { return RtMidi::WINDOWS_MM; }
+  void openPort(unsigned int portNumber, const std::string &portName) override;
+  void openVirtualPort(const std::string &portName) override;
+  void closePort() override;
+  void setClientName(const std::string &clientName) override;
+  void setPortName(const std::string &portName) override;
+  unsigned int getPortCount() override;
+  std::string getPortName(unsigned int portNumber) override;
+  void sendMessage(const unsigned char *message, size_t size) override;
+
+private:
+  HMIDIOUT outHandle_;
+};
+
+MidiOutWinMM::MidiOutWinMM(const std::string & /*clientName*/)
+  : MidiOutApi(), outHandle_(nullptr)
+{
+}
+
+MidiOutWinMM::~MidiOutWinMM()
+{
+  closePort();
+}
+
+unsigned int MidiOutWinMM::getPortCount()
+{
+  return midiOutGetNumDevs();
+}
+
+std::string MidiOutWinMM::getPortName(unsigned int portNumber)
+{
+  MIDIOUTCAPS caps;
+  if (midiOutGetDevCaps(portNumber, &caps, sizeof(MIDIOUTCAPS)) == MMSYSERR_NOERROR) {
+    return std::string(caps.szPname);
+  }
+  return "";
+}
+
+void MidiOutWinMM::openPort(unsigned int portNumber, const std::string & /*portName*/)
+{
+  if (connected_) {
+    errorString_ = "MidiOutWinMM::openPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  unsigned int nDevices = midiOutGetNumDevs();
+  if (nDevices == 0) {
+    errorString_ = "MidiOutWinMM::openPort: no MIDI output devices found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+
+  if (portNumber >= nDevices) {
+    errorString_ = "MidiOutWinMM::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+
+  MMRESULT result = midiOutOpen(&outHandle_, portNumber, 0, 0, CALLBACK_NULL);
+  if (result != MMSYSERR_NOERROR) {
+    errorString_ = "MidiOutWinMM::openPort: error opening MIDI output port.";
+    error(RtMidiError::DRIVER_ERROR, errorString_);
+    return;
+  }
+
+  connected_ = true;
+}
+
+void MidiOutWinMM::openVirtualPort(const std::string & /*portName*/)
+{
+  errorString_ = "MidiOutWinMM::openVirtualPort: virtual ports are not supported on Windows.";
+  error(RtMidiError::WARNING, errorString_);
+}
+
+void MidiOutWinMM::closePort()
+{
+  if (outHandle_) {
+    midiOutClose(outHandle_);
+    outHandle_ = nullptr;
+  }
+  connected_ = false;
+}
+
+void MidiOutWinMM::setClientName(const std::string & /*clientName*/)
+{
+  // Not supported on Windows
+}
+
+void MidiOutWinMM::setPortName(const std::string & /*portName*/)
+{
+  // Not supported on Windows
+}
+
+void MidiOutWinMM::sendMessage(const unsigned char *message, size_t size)
+{
+  if (!connected_) {
+    errorString_ = "MidiOutWinMM::sendMessage: no open port!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  DWORD msg = 0;
+  for (size_t i = 0; i < size && i < 4; ++i) {
+    msg |= (message[i] << (i * 8));
+  }
+
+  midiOutShortMsg(outHandle_, msg);
+}
+
+#endif // __WINDOWS_MM__
+
+#if defined(__RTMIDI_DUMMY__)
+
+// **************************************************************** //
+//
+// In-process loopback API (RtMidi::RTMIDI_DUMMY).
+//
+// Virtual ports live in a process-wide table, all on client 0.  An
+// RtMidiOut with a virtual port feeds every RtMidiIn that opened it,
+// and an RtMidiOut that opened an RtMidiIn's virtual port feeds that
+// input.  Messages are delivered synchronously on the sending thread,
+// which therefore plays the part of the input thread: there is no
+// driver, no kernel and no scheduling jitter, and sendEvents() sets
+// the arrival timestamps.
+//
+// **************************************************************** //
+
+class MidiInLoopback;
+class MidiOutLoopback;
+
+struct LoopbackPort {
+  int id;
+  std::string name;
+  MidiOutLoopback *output;  // Owner of a virtual output port, or
+  MidiInLoopback *input;    // owner of a virtual input port
+};
+
+// Guards the port table and the links between inputs and outputs.
+// Only taken when ports are opened or closed, never per message.
+static std::mutex loopbackMutex;
+static std::vector<LoopbackPort> loopbackPorts;
+static int loopbackNextId = 0;
+
+static const LoopbackPort *loopbackFindPort(int id)
+{
+  for (const LoopbackPort &entry : loopbackPorts) {
+    if (entry.id == id) return &entry;
+  }
+  return nullptr;
+}
+
+// Virtual output ports are what inputs can open, and the other way round.
+static void loopbackListPorts(bool outputs, std::vector<RtMidiPortInfo> &ports)
+{
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  ports.clear();
+  for (const LoopbackPort &entry : loopbackPorts) {
+    if ((entry.output != nullptr) != outputs) continue;
+    RtMidiPortInfo info;
+    info.name = entry.name;
+    info.client = 0;
+    info.port = entry.id;
+    info.capabilities = RtMidiPortInfo::SOFTWARE
+                        | (outputs ? RtMidiPortInfo::INPUT : RtMidiPortInfo::OUTPUT);
+    ports.push_back(info);
+  }
+}
+
+static int loopbackAddPort(const std::string &name, MidiOutLoopback *output, MidiInLoopback *input)
+{
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  LoopbackPort entry;
+  entry.id = loopbackNextId++;
+  entry.name = name;
+  entry.output = output;
+  entry.input = input;
+  loopbackPorts.push_back(entry);
+  return entry.id;
+}
+
+static void loopbackRenamePort(int id, const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  for (LoopbackPort &entry : loopbackPorts) {
+    if (entry.id == id) entry.name = name;
+  }
+}
+
+// Loopback Input
+
+class MidiInLoopback : public MidiInApi
+{
+public:
+  MidiInLoopback(const std::string &clientName, unsigned int queueSizeLimit);
+  ~MidiInLoopback();
+  RtMidi::Api getCurrentApi() override { return RtMidi::RTMIDI_DUMMY; }
+  void openPort(unsigned int portNumber, const std::string &portName) override;
+  void openVirtualPort(const std::string &portName) override;
+  void closePort() override;
+  void setClientName(const std::string &clientName) override;
+  void setPortName(const std::string &portName) override;
+  unsigned int getPortCount() override;
+  std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
+  int addSource(int client, int port, int sourceId, const std::string &portName) override;
+  void removeSource(int sourceId) override;
 
-  switch (type) {
-    case 0x8:  // Note Off
-      snd_seq_ev_set_noteoff(&ev, channel, message[1], message[2]);
-      break;
-    case 0x9:  // Note On
-      snd_seq_ev_set_noteon(&ev, channel, message[1], message[2]);
-      break;
-    case 0xB:  // Control Change
-      snd_seq_ev_set_controller(&ev, channel, message[1], message[2]);
-      break;
-    case 0xF:  // System
-      if (status == 0xF8) {
-        ev.type = SND_SEQ_EVENT_CLOCK;
-      } else if (status == 0xFA) {
-        ev.type = SND_SEQ_EVENT_START;
-      } else if (status == 0xFB) {
-        ev.type = SND_SEQ_EVENT_CONTINUE;
-      } else if (status == 0xFC) {
-        ev.type = SND_SEQ_EVENT_STOP;
-      }
-      break;
-    default:
-      return;
-  }
+  // Sending thread, with the output's link mutex held.
+  void receive(const RtMidiEvent *events, unsigned int count, unsigned char source);
 
-  snd_seq_event_output(seq_, &ev);
-  snd_seq_drain_output(seq_);
-}
+  struct Feed {
+    MidiOutLoopback *output;
+    unsigned char source;
+  };
 
-#endif // __LINUX_ALSA__
+  // Outputs feeding this input.  Guarded by loopbackMutex.
+  std::vector<Feed> feeds_;
 
-#if defined(__WINDOWS_MM__)
+private:
+  std::mutex receiveMutex_;  // Serialises outputs sending from different threads
+  int virtualId_;
+};
 
-// Windows Multimedia implementation
+// Loopback Output
 
-class MidiInWinMM : public MidiInApi
+class MidiOutLoopback : public MidiOutApi
 {
 public:
-  MidiInWinMM(const std::string &clientName, unsigned int queueSizeLimit);
-  ~MidiInWinMM();
-  RtMidi::Api getCurrentApi() override { return RtMidi::WINDOWS_MM; }
+  MidiOutLoopback(const std::string &clientName);
+  ~MidiOutLoopback();
+  RtMidi::Api getCurrentApi() override { return RtMidi::RTMIDI_DUMMY; }
   void openPort(unsigned int portNumber, const std::string &portName) override;
   void openVirtualPort(const std::string &portName) override;
   void closePort() override;
@@ -1279,249 +3326,356 @@ public:
   void setPortName(const std::string &portName) override;
   unsigned int getPortCount() override;
   std::string getPortName(unsigned int portNumber) override;
+  void getPorts(std::vector<RtMidiPortInfo> &ports) override;
+  void openPortAddress(int client, int port, const std::string &portName) override;
+  void sendMessage(const unsigned char *message, size_t size) override;
+  void sendEvents(const RtMidiEvent *events, unsigned int count) override;
+
+  // Both with loopbackMutex held.  unlink() drops every link to
+  // \e input when source < 0.
+  void link(MidiInLoopback *input, unsigned char source);
+  void unlink(MidiInLoopback *input, int source);
 
 private:
-  HMIDIIN inHandle_;
-  static void CALLBACK midiInputCallback(HMIDIIN hMidiIn, UINT wMsg, DWORD_PTR dwInstance,
-                                          DWORD_PTR dwParam1, DWORD_PTR dwParam2);
+  struct Link {
+    MidiInLoopback *input;
+    unsigned char source;
+  };
+
+  std::mutex linkMutex_;  // Held while delivering
+  std::vector<Link> links_;
+  int virtualId_;
 };
 
-MidiInWinMM::MidiInWinMM(const std::string & /*clientName*/, unsigned int queueSizeLimit)
-  : MidiInApi(queueSizeLimit), inHandle_(nullptr)
+MidiInLoopback::MidiInLoopback(const std::string & /*clientName*/, unsigned int queueSizeLimit)
+  : MidiInApi(queueSizeLimit), virtualId_(-1)
 {
 }
 
-MidiInWinMM::~MidiInWinMM()
+MidiInLoopback::~MidiInLoopback()
 {
   closePort();
 }
 
-unsigned int MidiInWinMM::getPortCount()
+unsigned int MidiInLoopback::getPortCount()
 {
-  return midiInGetNumDevs();
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(true, ports);
+  return (unsigned int)ports.size();
 }
 
-std::string MidiInWinMM::getPortName(unsigned int portNumber)
+std::string MidiInLoopback::getPortName(unsigned int portNumber)
 {
-  MIDIINCAPS caps;
-  if (midiInGetDevCaps(portNumber, &caps, sizeof(MIDIINCAPS)) == MMSYSERR_NOERROR) {
-    return std::string(caps.szPname);
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(true, ports);
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiInLoopback::getPortName: invalid port number!";
+    error(RtMidiError::WARNING, errorString_);
+    return "";
   }
-  return "";
+  return ports[portNumber].name;
 }
 
-void CALLBACK MidiInWinMM::midiInputCallback(HMIDIIN /*hMidiIn*/, UINT wMsg,
-                                              DWORD_PTR dwInstance, DWORD_PTR dwParam1,
-                                              DWORD_PTR /*dwParam2*/)
+void MidiInLoopback::getPorts(std::vector<RtMidiPortInfo> &ports)
 {
-  MidiInWinMM *data = reinterpret_cast<MidiInWinMM *>(dwInstance);
-
-  if (wMsg == MIM_DATA) {
-    std::vector<unsigned char> message;
-    unsigned char status = dwParam1 & 0xFF;
-    message.push_back(status);
-
-    if ((status & 0xF0) != 0xF0) {
-      message.push_back((dwParam1 >> 8) & 0xFF);
-      if ((status & 0xF0) != 0xC0 && (status & 0xF0) != 0xD0) {
-        message.push_back((dwParam1 >> 16) & 0xFF);
-      }
-    }
+  loopbackListPorts(true, ports);
+}
 
-    double timeStamp = 0.0;
-
-    if (data->userCallback_) {
-      data->userCallback_(timeStamp, &message, data->userCallbackData_);
-    } else if (data->inputQueue_.ringSize > 0) {
-      unsigned int idx = data->inputQueue_.back;
-      data->inputQueue_.ring[idx].bytes = message;
-      data->inputQueue_.ring[idx].timeStamp = timeStamp;
-      data->inputQueue_.back = (data->inputQueue_.back + 1) % data->inputQueue_.ringSize;
-      if (data->inputQueue_.back == data->inputQueue_.front) {
-        data->inputQueue_.front = (data->inputQueue_.front + 1) % data->inputQueue_.ringSize;
-      }
-    }
+void MidiInLoopback::openPort(unsigned int portNumber, const std::string &portName)
+{
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(true, ports);
+  if (ports.empty()) {
+    errorString_ = "MidiInLoopback::openPort: no loopback output ports found!";
+    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+    return;
+  }
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiInLoopback::openPort: invalid port number!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
   }
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
 }
 
-void MidiInWinMM::openPort(unsigned int portNumber, const std::string & /*portName*/)
+void MidiInLoopback::openPortAddress(int client, int port, const std::string &portName)
 {
   if (connected_) {
-    errorString_ = "MidiInWinMM::openPort: a valid connection already exists!";
+    errorString_ = "MidiInLoopback::openPortAddress: a valid connection already exists!";
     error(RtMidiError::WARNING, errorString_);
     return;
   }
+  addSource(client, port, 0, portName);
+}
 
-  unsigned int nDevices = midiInGetNumDevs();
-  if (nDevices == 0) {
-    errorString_ = "MidiInWinMM::openPort: no MIDI input devices found!";
-    error(RtMidiError::NO_DEVICES_FOUND, errorString_);
+void MidiInLoopback::openVirtualPort(const std::string &portName)
+{
+  if (virtualId_ >= 0) {
+    errorString_ = "MidiInLoopback::openVirtualPort: a virtual port is already open!";
+    error(RtMidiError::WARNING, errorString_);
     return;
   }
+  virtualId_ = loopbackAddPort(portName, nullptr, this);
+  connected_ = true;
+}
 
-  if (portNumber >= nDevices) {
-    errorString_ = "MidiInWinMM::openPort: invalid port number!";
+int MidiInLoopback::addSource(int client, int port, int sourceId, const std::string & /*portName*/)
+{
+  if (sourceId >= RtMidiIn::MAX_SOURCES) {
+    errorString_ = "MidiInLoopback::addSource: invalid source id!";
     error(RtMidiError::INVALID_PARAMETER, errorString_);
-    return;
+    return -1;
   }
 
-  MMRESULT result = midiInOpen(&inHandle_, portNumber,
-                                (DWORD_PTR)midiInputCallback,
-                                (DWORD_PTR)this, CALLBACK_FUNCTION);
-  if (result != MMSYSERR_NOERROR) {
-    errorString_ = "MidiInWinMM::openPort: error opening MIDI input port.";
-    error(RtMidiError::DRIVER_ERROR, errorString_);
-    return;
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  const LoopbackPort *entry = client == 0 ? loopbackFindPort(port) : nullptr;
+  if (!entry || !entry->output) {
+    errorString_ = "MidiInLoopback::addSource: no loopback output port at this address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return -1;
   }
 
-  midiInStart(inHandle_);
+  bool used[RtMidiIn::MAX_SOURCES] = {};
+  for (const Feed &feed : feeds_) {
+    if (feed.source < RtMidiIn::MAX_SOURCES) used[feed.source] = true;
+  }
+  if (sourceId < 0) {
+    while (++sourceId < RtMidiIn::MAX_SOURCES && used[sourceId]) {}
+  }
+  if (sourceId >= RtMidiIn::MAX_SOURCES || used[sourceId]) {
+    errorString_ = "MidiInLoopback::addSource: no free source id!";
+    error(RtMidiError::WARNING, errorString_);
+    return -1;
+  }
+
+  entry->output->link(this, (unsigned char)sourceId);
   connected_ = true;
+  return sourceId;
 }
 
-void MidiInWinMM::openVirtualPort(const std::string & /*portName*/)
+void MidiInLoopback::removeSource(int sourceId)
 {
-  errorString_ = "MidiInWinMM::openVirtualPort: virtual ports are not supported on Windows.";
-  error(RtMidiError::WARNING, errorString_);
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  for (const Feed &feed : feeds_) {
+    if (feed.source == sourceId) {
+      MidiOutLoopback *output = feed.output;
+      output->unlink(this, sourceId);
+      return;
+    }
+  }
 }
 
-void MidiInWinMM::closePort()
+void MidiInLoopback::closePort()
 {
-  if (inHandle_) {
-    midiInStop(inHandle_);
-    midiInClose(inHandle_);
-    inHandle_ = nullptr;
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  while (!feeds_.empty())
+    feeds_.back().output->unlink(this, -1);
+  if (virtualId_ >= 0) {
+    loopbackPorts.erase(std::remove_if(loopbackPorts.begin(), loopbackPorts.end(),
+                                       [this](const LoopbackPort &entry) { return entry.id == virtualId_; }),
+                        loopbackPorts.end());
+    virtualId_ = -1;
   }
   connected_ = false;
 }
 
-void MidiInWinMM::setClientName(const std::string & /*clientName*/)
+void MidiInLoopback::setClientName(const std::string & /*clientName*/)
 {
-  // Not supported on Windows
+  // All loopback ports belong to client 0
 }
 
-void MidiInWinMM::setPortName(const std::string & /*portName*/)
+void MidiInLoopback::setPortName(const std::string &portName)
 {
-  // Not supported on Windows
+  if (virtualId_ >= 0)
+    loopbackRenamePort(virtualId_, portName);
 }
 
-// Windows MM Output
-
-class MidiOutWinMM : public MidiOutApi
+void MidiInLoopback::receive(const RtMidiEvent *events, unsigned int count, unsigned char source)
 {
-public:
-  MidiOutWinMM(const std::string &clientName);
-  ~MidiOutWinMM();
-  RtMidi::Api getCurrentApi() override { return RtMidi::WINDOWS_MM; }
-  void openPort(unsigned int portNumber, const std::string &portName) override;
-  void openVirtualPort(const std::string &portName) override;
-  void closePort() override;
-  void setClientName(const std::string &clientName) override;
-  void setPortName(const std::string &portName) override;
-  unsigned int getPortCount() override;
-  std::string getPortName(unsigned int portNumber) override;
-  void sendMessage(const unsigned char *message, size_t size) override;
-
-private:
-  HMIDIOUT outHandle_;
-};
+  std::lock_guard<std::mutex> lock(receiveMutex_);
+  eventSource_ = source;
+  unsigned long long now = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    RtMidiEvent event = events[i];
+    if (event.size == 0) continue;
+    unsigned char status = event.data()[0];
+    if ((status == 0xF0 && ignoreFlags_[0].load(std::memory_order_relaxed))
+        || ((status == 0xF1 || status == 0xF8 || status == 0xF9) && ignoreFlags_[1].load(std::memory_order_relaxed))
+        || (status == 0xFE && ignoreFlags_[2].load(std::memory_order_relaxed)))
+      continue;
+    if (event.timeNs == 0) {
+      if (now == 0) now = monotonicNanos();
+      event.timeNs = now;
+    }
+    deliverEvent(event);
+  }
+  flushBatch();
+}
 
-MidiOutWinMM::MidiOutWinMM(const std::string & /*clientName*/)
-  : MidiOutApi(), outHandle_(nullptr)
+MidiOutLoopback::MidiOutLoopback(const std::string & /*clientName*/)
+  : MidiOutApi(), virtualId_(-1)
 {
 }
 
-MidiOutWinMM::~MidiOutWinMM()
+MidiOutLoopback::~MidiOutLoopback()
 {
   closePort();
 }
 
-unsigned int MidiOutWinMM::getPortCount()
+unsigned int MidiOutLoopback::getPortCount()
 {
-  return midiOutGetNumDevs();
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(false, ports);
+  return (unsigned int)ports.size();
 }
 
-std::string MidiOutWinMM::getPortName(unsigned int portNumber)
+std::string MidiOutLoopback::getPortName(unsigned int portNumber)
 {
-  MIDIOUTCAPS caps;
-  if (midiOutGetDevCaps(portNumber, &caps, sizeof(MIDIOUTCAPS)) == MMSYSERR_NOERROR) {
-    return std::string(caps.szPname);
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(false, ports);
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiOutLoopback::getPortName: invalid port number!";
+    error(RtMidiError::WARNING, errorString_);
+    return "";
   }
-  return "";
+  return ports[portNumber].name;
 }
 
-void MidiOutWinMM::openPort(unsigned int portNumber, const std::string & /*portName*/)
+void MidiOutLoopback::getPorts(std::vector<RtMidiPortInfo> &ports)
 {
-  if (connected_) {
-    errorString_ = "MidiOutWinMM::openPort: a valid connection already exists!";
-    error(RtMidiError::WARNING, errorString_);
-    return;
-  }
+  loopbackListPorts(false, ports);
+}
 
-  unsigned int nDevices = midiOutGetNumDevs();
-  if (nDevices == 0) {
-    errorString_ = "MidiOutWinMM::openPort: no MIDI output devices found!";
+void MidiOutLoopback::openPort(unsigned int portNumber, const std::string &portName)
+{
+  std::vector<RtMidiPortInfo> ports;
+  loopbackListPorts(false, ports);
+  if (ports.empty()) {
+    errorString_ = "MidiOutLoopback::openPort: no loopback input ports found!";
     error(RtMidiError::NO_DEVICES_FOUND, errorString_);
     return;
   }
-
-  if (portNumber >= nDevices) {
-    errorString_ = "MidiOutWinMM::openPort: invalid port number!";
+  if (portNumber >= ports.size()) {
+    errorString_ = "MidiOutLoopback::openPort: invalid port number!";
     error(RtMidiError::INVALID_PARAMETER, errorString_);
     return;
   }
+  openPortAddress(ports[portNumber].client, ports[portNumber].port, portName);
+}
 
-  MMRESULT result = midiOutOpen(&outHandle_, portNumber, 0, 0, CALLBACK_NULL);
-  if (result != MMSYSERR_NOERROR) {
-    errorString_ = "MidiOutWinMM::openPort: error opening MIDI output port.";
-    error(RtMidiError::DRIVER_ERROR, errorString_);
+void MidiOutLoopback::openPortAddress(int client, int port, const std::string & /*portName*/)
+{
+  if (connected_) {
+    errorString_ = "MidiOutLoopback::openPortAddress: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
     return;
   }
 
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  const LoopbackPort *entry = client == 0 ? loopbackFindPort(port) : nullptr;
+  if (!entry || !entry->input) {
+    errorString_ = "MidiOutLoopback::openPortAddress: no loopback input port at this address!";
+    error(RtMidiError::INVALID_PARAMETER, errorString_);
+    return;
+  }
+  // Like a client writing to an ALSA virtual port without a subscription
+  link(entry->input, RtMidiIn::UNKNOWN_SOURCE);
   connected_ = true;
 }
 
-void MidiOutWinMM::openVirtualPort(const std::string & /*portName*/)
+void MidiOutLoopback::openVirtualPort(const std::string &portName)
 {
-  errorString_ = "MidiOutWinMM::openVirtualPort: virtual ports are not supported on Windows.";
-  error(RtMidiError::WARNING, errorString_);
+  if (connected_) {
+    errorString_ = "MidiOutLoopback::openVirtualPort: a valid connection already exists!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+  virtualId_ = loopbackAddPort(portName, this, nullptr);
+  connected_ = true;
 }
 
-void MidiOutWinMM::closePort()
+void MidiOutLoopback::closePort()
 {
-  if (outHandle_) {
-    midiOutClose(outHandle_);
-    outHandle_ = nullptr;
+  std::lock_guard<std::mutex> lock(loopbackMutex);
+  while (!links_.empty())
+    unlink(links_.back().input, -1);
+  if (virtualId_ >= 0) {
+    loopbackPorts.erase(std::remove_if(loopbackPorts.begin(), loopbackPorts.end(),
+                                       [this](const LoopbackPort &entry) { return entry.id == virtualId_; }),
+                        loopbackPorts.end());
+    virtualId_ = -1;
   }
   connected_ = false;
 }
 
-void MidiOutWinMM::setClientName(const std::string & /*clientName*/)
+void MidiOutLoopback::setClientName(const std::string & /*clientName*/)
 {
-  // Not supported on Windows
+  // All loopback ports belong to client 0
 }
 
-void MidiOutWinMM::setPortName(const std::string & /*portName*/)
+void MidiOutLoopback::setPortName(const std::string &portName)
 {
-  // Not supported on Windows
+  if (virtualId_ >= 0)
+    loopbackRenamePort(virtualId_, portName);
 }
 
-void MidiOutWinMM::sendMessage(const unsigned char *message, size_t size)
+void MidiOutLoopback::link(MidiInLoopback *input, unsigned char source)
 {
-  if (!connected_) {
-    errorString_ = "MidiOutWinMM::sendMessage: no open port!";
+  std::lock_guard<std::mutex> lock(linkMutex_);
+  links_.push_back({input, source});
+  input->feeds_.push_back({this, source});
+}
+
+void MidiOutLoopback::unlink(MidiInLoopback *input, int source)
+{
+  // Waits for a delivery in progress, so the input may be destroyed
+  // as soon as this returns
+  std::lock_guard<std::mutex> lock(linkMutex_);
+  links_.erase(std::remove_if(links_.begin(), links_.end(), [&](const Link &l) {
+                 return l.input == input && (source < 0 || l.source == source);
+               }), links_.end());
+  std::vector<MidiInLoopback::Feed> &feeds = input->feeds_;
+  feeds.erase(std::remove_if(feeds.begin(), feeds.end(), [&](const MidiInLoopback::Feed &f) {
+                return f.output == this && (source < 0 || f.source == source);
+              }), feeds.end());
+}
+
+void MidiOutLoopback::sendMessage(const unsigned char *message, size_t size)
+{
+  if (size == 0 || (size > 3 && message[0] != 0xF0)) {
+    errorString_ = "MidiOutLoopback::sendMessage: invalid MIDI message!";
     error(RtMidiError::WARNING, errorString_);
     return;
   }
 
-  DWORD msg = 0;
-  for (size_t i = 0; i < size && i < 4; ++i) {
-    msg |= (message[i] << (i * 8));
+  RtMidiEvent event;
+  event.timeNs = 0;
+  event.deltaTime = 0.0;
+  event.size = (unsigned int)size;
+  event.source = 0;
+  if (message[0] == 0xF0) {
+    event.sysex = message;
+  } else {
+    MidiInApi::setEventBytes(event, event.size, message[0],
+                             size > 1 ? message[1] : 0, size > 2 ? message[2] : 0);
   }
+  sendEvents(&event, 1);
+}
 
-  midiOutShortMsg(outHandle_, msg);
+void MidiOutLoopback::sendEvents(const RtMidiEvent *events, unsigned int count)
+{
+  if (!connected_) {
+    errorString_ = "MidiOutLoopback::sendEvents: no open port!";
+    error(RtMidiError::WARNING, errorString_);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(linkMutex_);
+  for (const Link &link : links_)
+    link.input->receive(events, count, link.source);
 }
 
-#endif // __WINDOWS_MM__
+#endif // __RTMIDI_DUMMY__
 
 // **************************************************************** //
 //
@@ -1567,12 +3721,19 @@ void RtMidiIn::openMidiApi(RtMidi::Api api, const std::string &clientName, unsig
 #if defined(__LINUX_ALSA__)
   if (api == LINUX_ALSA)
     rtapi_ = new MidiInAlsa(clientName, queueSizeLimit);
+  if (api == LINUX_RAWMIDI)
+    rtapi_ = new MidiInRawMidi(clientName, queueSizeLimit);
 #endif
 
 #if defined(__WINDOWS_MM__)
   if (api == WINDOWS_MM)
     rtapi_ = new MidiInWinMM(clientName, queueSizeLimit);
 #endif
+
+#if defined(__RTMIDI_DUMMY__)
+  if (api == RTMIDI_DUMMY)
+    rtapi_ = new MidiInLoopback(clientName, queueSizeLimit);
+#endif
 }
 
 RtMidi::Api RtMidiIn::getCurrentApi() throw()
@@ -1627,6 +3788,65 @@ void RtMidiIn::setCallback(RtMidiCallback callback, void *userData)
     ((MidiInApi *)rtapi_)->setCallback(callback, userData);
 }
 
+void RtMidiIn::setTimestampCallback(RtMidiTimestampCallback callback, void *userData)
+{
+  if (rtapi_)
+    ((MidiInApi *)rtapi_)->setTimestampCallback(callback, userData);
+}
+
+void RtMidiIn::setRawCallback(RtMidiRawCallback callback, void *userData)
+{
+  if (rtapi_)
+    ((MidiInApi *)rtapi_)->setRawCallback(callback, userData);
+}
+
+void RtMidiIn::setBatchCallback(RtMidiBatchCallback callback, void *userData)
+{
+  if (rtapi_)
+    ((MidiInApi *)rtapi_)->setBatchCallback(callback, userData);
+}
+
+int RtMidiIn::addSource(int client, int port, int sourceId, const std::string &portName)
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->addSource(client, port, sourceId, portName);
+  return -1;
+}
+
+void RtMidiIn::removeSource(int sourceId)
+{
+  if (rtapi_)
+    ((MidiInApi *)rtapi_)->removeSource(sourceId);
+}
+
+bool RtMidiIn::setThreadOptions(const RtMidiThreadOptions &options)
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->setThreadOptions(options);
+  return false;
+}
+
+unsigned int RtMidiIn::getThreadStatus()
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->getThreadStatus();
+  return 0;
+}
+
+unsigned long long RtMidiIn::getDriverTimeNs()
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->driverTimeNs();
+  return MidiInApi::monotonicNanos();
+}
+
+bool RtMidiIn::setPortCallback(RtMidiPortCallback callback, void *userData)
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->setPortCallback(callback, userData);
+  return false;
+}
+
 void RtMidiIn::cancelCallback()
 {
   if (rtapi_)
@@ -1639,6 +3859,19 @@ void RtMidiIn::ignoreTypes(bool midiSysex, bool midiTime, bool midiSense)
     ((MidiInApi *)rtapi_)->ignoreTypes(midiSysex, midiTime, midiSense);
 }
 
+void RtMidiIn::setFilter(const RtMidiFilter &filter)
+{
+  if (rtapi_)
+    ((MidiInApi *)rtapi_)->setFilter(filter);
+}
+
+RtMidiFilter RtMidiIn::getFilter() const
+{
+  if (rtapi_)
+    return ((MidiInApi *)rtapi_)->getFilter();
+  return RtMidiFilter();
+}
+
 double RtMidiIn::getMessage(std::vector<unsigned char> *message)
 {
   if (rtapi_)
@@ -1686,12 +3919,19 @@ void RtMidiOut::openMidiApi(RtMidi::Api api, const std::string &clientName)
 #if defined(__LINUX_ALSA__)
   if (api == LINUX_ALSA)
     rtapi_ = new MidiOutAlsa(clientName);
+  if (api == LINUX_RAWMIDI)
+    rtapi_ = new MidiOutRawMidi(clientName);
 #endif
 
 #if defined(__WINDOWS_MM__)
   if (api == WINDOWS_MM)
     rtapi_ = new MidiOutWinMM(clientName);
 #endif
+
+#if defined(__RTMIDI_DUMMY__)
+  if (api == RTMIDI_DUMMY)
+    rtapi_ = new MidiOutLoopback(clientName);
+#endif
 }
 
 RtMidi::Api RtMidiOut::getCurrentApi() throw()
@@ -1751,3 +3991,9 @@ void RtMidiOut::sendMessage(const unsigned char *message, size_t size)
   if (rtapi_)
     ((MidiOutApi *)rtapi_)->sendMessage(message, size);
 }
+
+void RtMidiOut::sendEvents(const RtMidiEvent *events, unsigned int count)
+{
+  if (rtapi_)
+    ((MidiOutApi *)rtapi_)->sendEvents(events, count);
+}
@@ -133,6 +133,35 @@ class RtMidiError : public std::exception
  */
 typedef std::function<void(RtMidiError::Type type, const std::string &errorText, void *userData)> RtMidiErrorCallback;
 
+//! Description of one MIDI port, as returned by getPorts().
+/*!
+    \e client and \e port form a stable address that survives other
+    ports appearing or disappearing, unlike the enumeration index.  On
+    ALSA they are the sequencer client and port ids; on backends without
+    such ids \e client is -1 and \e port is the enumeration index.
+*/
+struct RtMidiPortInfo
+{
+  enum Capability {
+    INPUT    = 1 << 0,  /*!< Can be opened by RtMidiIn. */
+    OUTPUT   = 1 << 1,  /*!< Can be opened by RtMidiOut. */
+    HARDWARE = 1 << 2,  /*!< Backed by a hardware device. */
+    SOFTWARE = 1 << 3   /*!< Provided by an application or virtual device. */
+  };
+
+  //! Kind of change reported to an RtMidiPortCallback.
+  enum Change {
+    ADDED,    /*!< The port appeared. */
+    REMOVED,  /*!< The port disappeared; only \e client and \e port are valid. */
+    CHANGED   /*!< The port was renamed or its capabilities changed. */
+  };
+
+  std::string name;            /*!< Same display name as getPortName(). */
+  int client;
+  int port;
+  unsigned int capabilities;   /*!< Capability flags. */
+};
+
 class MidiApi;
 
 class RtMidi
@@ -146,10 +175,11 @@ class RtMidi
     LINUX_ALSA,     /*!< The Advanced Linux Sound Architecture API. */
     UNIX_JACK,      /*!< The JACK Low-Latency MIDI Server API. */
     WINDOWS_MM,     /*!< The Microsoft Multimedia MIDI API. */
-    RTMIDI_DUMMY,   /*!< A compilable but non-functional API. */
+    RTMIDI_DUMMY,   /*!< In-process loopback between RtMidiOut and RtMidiIn (__RTMIDI_DUMMY__). */
     WEB_MIDI_API,   /*!< W3C Web MIDI API. */
     WINDOWS_UWP,    /*!< The Microsoft Universal Windows Platform MIDI API. */
     ANDROID_AMIDI,  /*!< The Android MIDI API. */
+    LINUX_RAWMIDI,  /*!< ALSA raw MIDI devices, bypassing the sequencer. */
     NUM_APIS        /*!< Number of values in this enum. */
   };
 
@@ -209,6 +239,22 @@ class RtMidi
   //! Pure virtual getPortName() function.
   virtual std::string getPortName( unsigned int portNumber = 0 ) = 0;
 
+  //! Returns every port of the current API in a single pass.
+  /*!
+      The vector is indexed like getPortName(), so it can replace a
+      getPortCount()/getPortName() loop, which walks the port list once
+      per call on some APIs.
+  */
+  std::vector<RtMidiPortInfo> getPorts();
+
+  //! Open a connection to the port with the given stable address.
+  /*!
+      \param client The \e client field of an RtMidiPortInfo.
+      \param port   The \e port field of an RtMidiPortInfo.
+      \param portName An optional name for the application port.
+  */
+  void openPortAddress( int client, int port, const std::string &portName = std::string( "RtMidi" ) );
+
   //! Pure virtual closePort() function.
   virtual void closePort( void ) = 0;
 
@@ -266,10 +312,156 @@ class RtMidi
 //! User callback function type definition.
 typedef std::function<void(double timeStamp, std::vector<unsigned char> *message, void *userData)> RtMidiCallback;
 
+//! Timestamped user callback function type definition.
+/*!
+    \param deltaTime Seconds elapsed since the previous message (0 for the first one).
+    \param timeNs    Absolute arrival time in nanoseconds on the monotonic clock
+                     (CLOCK_MONOTONIC on Linux), taken from the driver when it
+                     provides one.
+    \param message   The raw MIDI bytes.
+    \param userData  The pointer passed to setTimestampCallback().
+*/
+typedef std::function<void(double deltaTime, unsigned long long timeNs, std::vector<unsigned char> *message, void *userData)> RtMidiTimestampCallback;
+
+//! A single incoming MIDI message that needs no heap storage.
+/*!
+    Channel, system common and realtime messages (up to three bytes) are
+    stored inline in \e bytes.  SysEx messages point into storage owned
+    by the input API, which is only valid for the duration of the
+    callback; copy the bytes out if they are needed later.
+*/
+struct RtMidiEvent
+{
+  unsigned long long timeNs;   /*!< Absolute monotonic arrival time in nanoseconds. */
+  double deltaTime;            /*!< Seconds since the previous message. */
+  const unsigned char *sysex;  /*!< SysEx bytes, or nullptr for inline messages. */
+  unsigned int size;           /*!< Number of message bytes. */
+  unsigned char bytes[3];      /*!< Inline message bytes. */
+  unsigned char source;        /*!< Source id from addSource(); see RtMidiIn::UNKNOWN_SOURCE. */
+
+  //! Returns a pointer to the \e size message bytes.
+  const unsigned char *data() const { return sysex ? sysex : bytes; }
+};
+
+//! Allocation-free input callback function type definition.
+/*!
+    Invoked on the API's input thread with a pointer to a stack-allocated
+    event; the pointer must not be retained after the callback returns.
+*/
+typedef void (*RtMidiRawCallback)(const RtMidiEvent *event, void *userData);
+
+//! Batched input callback function type definition.
+/*!
+    Invoked on the API's input thread with every event decoded since the
+    previous call, in arrival order.  Backends that can tell when the
+    driver has nothing more pending (ALSA, CoreMIDI packet lists) deliver
+    one batch per wakeup; a batch never holds more than
+    RtMidiIn::BATCH_SIZE events and always ends after a SysEx event.
+    The array and any SysEx data it points to are only valid for the
+    duration of the call.
+*/
+typedef void (*RtMidiBatchCallback)(const RtMidiEvent *events, unsigned int count, void *userData);
+
+//! Port hotplug callback function type definition.
+/*!
+    Invoked on the API's input thread for every port of another client
+    that appears, disappears or changes, with \e change one of
+    RtMidiPortInfo::Change.  The port information is only valid for the
+    duration of the call.
+*/
+typedef void (*RtMidiPortCallback)(int change, const RtMidiPortInfo &port, void *userData);
+
+//! Scheduling of the API's input thread.
+/*!
+    Realtime policies need CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO on
+    Linux.  When a request cannot be granted the thread keeps running
+    with its previous settings, a warning is reported and the matching
+    \e *_FAILED bit is set in RtMidiIn::getThreadStatus().
+*/
+struct RtMidiThreadOptions
+{
+  enum Policy {
+    NORMAL,       /*!< The default time-sharing scheduler. */
+    FIFO,         /*!< SCHED_FIFO. */
+    ROUND_ROBIN   /*!< SCHED_RR. */
+  };
+
+  //! Bits returned by RtMidiIn::getThreadStatus().
+  enum Status {
+    PRIORITY_APPLIED = 1 << 0,  /*!< The thread runs with \e policy and \e priority. */
+    AFFINITY_APPLIED = 1 << 1,  /*!< The thread is pinned to \e cpus. */
+    PRIORITY_FAILED  = 1 << 2,
+    AFFINITY_FAILED  = 1 << 3
+  };
+
+  Policy policy;
+  int priority;              /*!< 1 (lowest) to 99 on Linux; ignored for NORMAL. */
+  unsigned long long cpus;   /*!< Bit per CPU the thread may run on, 0 for any. */
+
+  RtMidiThreadOptions() : policy(NORMAL), priority(0), cpus(0) {}
+};
+
+//! Selects which incoming messages are delivered.
+/*!
+    Messages are accepted when their type bit is set in \e types and,
+    for channel messages, their channel bit is set in \e channels.
+    Note on/off and polyphonic aftertouch must additionally fall within
+    [\e noteLow, \e noteHigh].  When \e clockWhileStopped is false, MIDI
+    clock and tick messages are dropped between Stop and the next
+    Start/Continue.  Backends apply the static part of the filter in the
+    driver where they can (ALSA client event filters) and reject the rest,
+    clock while stopped included, before any decoding or queueing.
+*/
+struct RtMidiFilter
+{
+  enum Type {
+    NOTE_OFF         = 1 << 0,
+    NOTE_ON          = 1 << 1,
+    POLY_PRESSURE    = 1 << 2,
+    CONTROL_CHANGE   = 1 << 3,
+    PROGRAM_CHANGE   = 1 << 4,
+    CHANNEL_PRESSURE = 1 << 5,
+    PITCH_BEND       = 1 << 6,
+    SYSEX            = 1 << 7,
+    TIME_CODE        = 1 << 8,
+    SONG_POSITION    = 1 << 9,
+    SONG_SELECT      = 1 << 10,
+    TUNE_REQUEST     = 1 << 11,
+    CLOCK            = 1 << 12,
+    TICK             = 1 << 13,
+    START            = 1 << 14,
+    CONTINUE         = 1 << 15,
+    STOP             = 1 << 16,
+    ACTIVE_SENSING   = 1 << 17,
+    RESET            = 1 << 18,
+    ALL_TYPES        = (1 << 19) - 1
+  };
+
+  unsigned int types;
+  unsigned short channels;
+  unsigned char noteLow;
+  unsigned char noteHigh;
+  bool clockWhileStopped;
+
+  RtMidiFilter()
+    : types(ALL_TYPES), channels(0xFFFF), noteLow(0), noteHigh(127), clockWhileStopped(true) {}
+
+  //! Returns the Type bit for a status byte, or 0 for undefined statuses.
+  static unsigned int typeBit( unsigned char status );
+};
+
 class RtMidiIn : public RtMidi
 {
  public:
 
+  //! Maximum number of events passed to a batch callback at once.
+  enum { BATCH_SIZE = 256 };
+
+  //! Number of sources one input can be subscribed to, and the id
+  //! reported for events from senders that were not added as a source
+  //! (e.g. clients writing to a virtual port).
+  enum { MAX_SOURCES = 16, UNKNOWN_SOURCE = MAX_SOURCES };
+
   //! Default constructor that allows an optional api, client name and queue size.
   /*!
       An exception will be thrown if a MIDI system initialization error occurs.
@@ -330,6 +522,69 @@ class RtMidiIn : public RtMidi
   */
   void setCallback( RtMidiCallback callback, void *userData = nullptr );
 
+  //! Set a callback function that also receives the absolute driver timestamp.
+  /*!
+      Behaves like setCallback(), but the callback is given both the
+      RtMidi-style delta time and the absolute monotonic arrival time of
+      each message in nanoseconds.  Only one callback (of either kind)
+      can be set at a time; cancelCallback() removes it.
+  */
+  void setTimestampCallback( RtMidiTimestampCallback callback, void *userData = nullptr );
+
+  //! Set an allocation-free callback function for incoming MIDI messages.
+  /*!
+      Messages are passed as RtMidiEvent structures that keep short
+      messages inline and SysEx in preallocated storage, so the input
+      path performs no heap allocation per message.  Only one callback
+      (of any kind) can be set at a time; cancelCallback() removes it.
+  */
+  void setRawCallback( RtMidiRawCallback callback, void *userData = nullptr );
+
+  //! Set a callback that receives incoming messages in batches.
+  /*!
+      Like setRawCallback(), but all events that arrive together are
+      passed in one call, so per-message synchronization in the receiver
+      can be replaced by one commit per batch.  Only one callback (of
+      any kind) can be set at a time; cancelCallback() removes it.
+  */
+  void setBatchCallback( RtMidiBatchCallback callback, void *userData = nullptr );
+
+  //! Set a callback that is notified when ports come and go.
+  /*!
+      Changes are watched on the input thread whether or not a port is
+      open, without re-enumerating the port graph.  Pass nullptr to stop
+      watching.
+
+      \return false if the current API cannot report port changes.
+  */
+  bool setPortCallback( RtMidiPortCallback callback, void *userData = nullptr );
+
+  //! Set the scheduling policy, priority and CPU affinity of the input thread.
+  /*!
+      Takes effect immediately, restarting the input thread if it is
+      running, and is kept across openPort()/closePort().  Currently
+      supported by ALSA and raw MIDI.
+
+      \return false if the current API has no input thread of its own.
+  */
+  bool setThreadOptions( const RtMidiThreadOptions &options );
+
+  //! Returns RtMidiThreadOptions::Status bits for the input thread.
+  /*!
+      Updated each time the thread starts, so requests made while no
+      thread is running show up once a port is opened.
+  */
+  unsigned int getThreadStatus( void );
+
+  //! Returns the current time of the clock incoming events are stamped with, in nanoseconds.
+  /*!
+      On the same scale as RtMidiEvent::timeNs.  With ALSA this reads the
+      kernel queue that stamps events, which can drift from the
+      monotonic clock; comparing the two over time measures the drift.
+      Other APIs stamp events with the monotonic clock and return it.
+  */
+  unsigned long long getDriverTimeNs( void );
+
   //! Cancel use of the current callback function (if one exists).
   /*!
       Subsequent incoming MIDI messages will be written to the queue
@@ -337,6 +592,25 @@ class RtMidiIn : public RtMidi
   */
   void cancelCallback();
 
+  //! Subscribe the input to one more source port.
+  /*!
+      Events from every source share the callback, the input thread and
+      the queue, and carry the returned id in RtMidiEvent::source.  The
+      port opened by openPort() or openPortAddress() is source 0.  If no
+      port is open yet, one is opened as by openPortAddress().
+      Currently only supported by ALSA.
+
+      \param client   The \e client field of an RtMidiPortInfo.
+      \param port     The \e port field of an RtMidiPortInfo.
+      \param sourceId Id to use, or -1 for the lowest free one.
+      \param portName An optional name for the application port.
+      \return The source id, or -1 on error.
+  */
+  int addSource( int client, int port, int sourceId = -1, const std::string &portName = std::string( "RtMidi" ) );
+
+  //! Unsubscribe a source added by addSource().  The port stays open.
+  void removeSource( int sourceId );
+
   //! Close an open MIDI connection (if one exists).
   void closePort( void );
 
@@ -370,6 +644,16 @@ class RtMidiIn : public RtMidi
   */
   void ignoreTypes( bool midiSysex = true, bool midiTime = true, bool midiSense = true );
 
+  //! Restrict input to the messages accepted by \e filter.
+  /*!
+      Applied on top of ignoreTypes().  May be called at any time,
+      including while a port is open.
+  */
+  void setFilter( const RtMidiFilter &filter );
+
+  //! Returns the current input filter.
+  RtMidiFilter getFilter() const;
+
   //! Fill the user-provided vector with the data bytes for the next available MIDI message in the input queue and return the event delta-time in seconds.
   /*!
       This function returns immediately whether a new message is
@@ -485,6 +769,19 @@ class RtMidiOut : public RtMidi
   */
   void sendMessage( const unsigned char *message, size_t size );
 
+  //! Send a batch of messages with explicit arrival times.
+  /*!
+      With the loopback API (RTMIDI_DUMMY) the connected RtMidiIn
+      instances receive \e events as one batch, on the calling thread,
+      stamped with each event's \e timeNs (0 means the current monotonic
+      time).  This makes input timing reproducible without hardware.
+      With ALSA the batch is written with a single drain; events whose
+      \e timeNs lies in the future are scheduled on a sequencer queue
+      and delivered by the kernel at that time.  Other APIs send the
+      messages immediately, in order, and ignore \e timeNs.  Only \e timeNs, \e size, \e bytes and \e sysex are read.
+  */
+  void sendEvents( const RtMidiEvent *events, unsigned int count );
+
  protected:
   void openMidiApi( RtMidi::Api api, const std::string &clientName );
 };
@@ -0,0 +1,108 @@
+#ifndef GODOT_MIDI_BROADCAST_H
+#define GODOT_MIDI_BROADCAST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Bounded single-producer/multi-consumer broadcast ring.
+//
+// Every consumer sees every entry. Consumers don't remove anything; each
+// one advances its own cursor, so adding consumers costs no copies on the
+// producer side and the producer never waits for them. A consumer that
+// falls more than a ring behind skips to the oldest entry still present
+// and is told how many it missed.
+//
+// Each slot records the sequence number of the entry it holds, so a reader
+// can tell when the producer overwrote the slot while it was copying it.
+// T must be trivially copyable.
+template <typename T>
+class MidiBroadcast {
+public:
+    explicit MidiBroadcast(size_t p_capacity) {
+        size_t capacity = 1;
+        while (capacity < p_capacity) {
+            capacity <<= 1;
+        }
+        slots = std::vector<Slot>(capacity);
+        mask = capacity - 1;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Slot storage, e.g. to lock it in memory
+    const void *storage() const { return slots.data(); }
+    size_t storage_size() const { return slots.size() * sizeof(Slot); }
+
+    // Sequence number of the next entry to be published. A new consumer
+    // starts here to see only what comes after it.
+    uint64_t published() const { return tail.load(std::memory_order_acquire); }
+
+    // Producer: append p_values and publish them with a single index update.
+    void publish(const T *p_values, size_t p_count) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        // Entries that would be overwritten within this batch are skipped;
+        // readers see them as dropped.
+        size_t skip = p_count > capacity() ? p_count - capacity() : 0;
+        for (size_t i = skip; i < p_count; i++) {
+            Slot &slot = slots[(t + i) & mask];
+            slot.seq.store(SLOT_BUSY, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.value = p_values[i];
+            slot.seq.store(t + i + 1, std::memory_order_release);
+        }
+        tail.store(t + p_count, std::memory_order_release);
+    }
+
+    // Consumer: copy the entry at r_cursor and advance the cursor. Returns
+    // false once the cursor has caught up. Entries the producer overwrote
+    // before they could be read are added to r_dropped.
+    bool read(uint64_t &r_cursor, T &r_value, uint64_t &r_dropped) const {
+        for (;;) {
+            uint64_t t = tail.load(std::memory_order_acquire);
+            if (r_cursor >= t) {
+                return false;
+            }
+            if (t - r_cursor > capacity()) {
+                r_dropped += t - capacity() - r_cursor;
+                r_cursor = t - capacity();
+            }
+
+            const Slot &slot = slots[r_cursor & mask];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == r_cursor + 1) {
+                r_value = slot.value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                    r_cursor++;
+                    return true;
+                }
+            }
+            // Lapped while reading this slot: the entry is gone
+            r_dropped++;
+            r_cursor++;
+        }
+    }
+
+private:
+    static constexpr uint64_t SLOT_BUSY = ~uint64_t(0);
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> seq{ 0 };  // Sequence number + 1 of the entry held
+        T value{};
+    };
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+
+    std::atomic<uint64_t> tail{ 0 };
+    char tail_pad[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+};
+
+}
+
+#endif // GODOT_MIDI_BROADCAST_H
@@ -0,0 +1,152 @@
+#include "midi_clock.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godot;
+
+MidiClock::MidiClock() {
+    reset();
+}
+
+void MidiClock::reset() {
+    state = State();
+    last_tick_time = 0.0;
+    jitter_sq = 0.0;
+    stable_ticks = 0;
+    publish();
+}
+
+bool MidiClock::process(unsigned char status, double time) {
+    switch (status) {
+        case 0xF8:  // Clock
+            on_tick(time);
+            break;
+        case 0xFA:  // Start: the next tick is the first tick of beat 0
+            state.playing = true;
+            state.ref_tick = -1;
+            break;
+        case 0xFB:  // Continue
+            state.playing = true;
+            break;
+        case 0xFC:  // Stop
+            state.playing = false;
+            break;
+        default:
+            return false;
+    }
+
+    publish();
+    return true;
+}
+
+void MidiClock::on_tick(double time) {
+    // Position only advances while playing; tempo is tracked regardless
+    if (state.playing) {
+        state.ref_tick++;
+    }
+
+    double interval = time - last_tick_time;
+    last_tick_time = time;
+
+    // First tick, or a gap too long to be part of the same clock stream
+    if (interval <= 0.0 || interval > 1.0) {
+        state.ref_time = time;
+        state.period = 0.0;
+        state.locked = false;
+        stable_ticks = 0;
+        return;
+    }
+
+    if (state.period <= 0.0) {
+        state.ref_time = time;
+        state.period = interval;
+        return;
+    }
+
+    double predicted = state.ref_time + state.period;
+    double error = time - predicted;
+
+    // Tempo jump or lost ticks: re-acquire from the raw interval
+    if (std::fabs(error) > state.period * 0.5) {
+        state.ref_time = time;
+        state.period = interval;
+        state.locked = false;
+        stable_ticks = 0;
+        return;
+    }
+
+    state.ref_time = predicted + ALPHA * error;
+    state.period += BETA * error;
+
+    state.drift += STATS_WEIGHT * (error - state.drift);
+    jitter_sq += STATS_WEIGHT * (error * error - jitter_sq);
+    state.jitter = std::sqrt(jitter_sq);
+
+    if (stable_ticks < LOCK_TICKS) {
+        stable_ticks++;
+    }
+    state.locked = stable_ticks >= LOCK_TICKS;
+}
+
+void MidiClock::publish() {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    pub_ref_time.store(state.ref_time, std::memory_order_relaxed);
+    pub_period.store(state.period, std::memory_order_relaxed);
+    pub_ref_tick.store(state.ref_tick, std::memory_order_relaxed);
+    pub_jitter.store(state.jitter, std::memory_order_relaxed);
+    pub_drift.store(state.drift, std::memory_order_relaxed);
+    pub_flags.store((state.playing ? 1 : 0) | (state.locked ? 2 : 0), std::memory_order_relaxed);
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+MidiClock::State MidiClock::get_state() const {
+    State result;
+    for (;;) {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        result.ref_time = pub_ref_time.load(std::memory_order_relaxed);
+        result.period = pub_period.load(std::memory_order_relaxed);
+        result.ref_tick = pub_ref_tick.load(std::memory_order_relaxed);
+        result.jitter = pub_jitter.load(std::memory_order_relaxed);
+        result.drift = pub_drift.load(std::memory_order_relaxed);
+        uint8_t flags = pub_flags.load(std::memory_order_relaxed);
+        result.playing = flags & 1;
+        result.locked = flags & 2;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
+
+double MidiClock::get_bpm() const {
+    double period = get_state().period;
+    if (period <= 0.0) {
+        return 0.0;
+    }
+    return 60.0 / (period * TICKS_PER_BEAT);
+}
+
+double MidiClock::get_beat_position(double at_time) const {
+    State s = get_state();
+    if (s.ref_tick < 0) {
+        return 0.0;
+    }
+
+    double ticks = (double)s.ref_tick;
+    if (s.playing && s.period > 0.0) {
+        // Interpolate between ticks, but never run more than a tick past
+        // the last one received
+        ticks += std::clamp((at_time - s.ref_time) / s.period, -1.0, 1.0);
+    }
+    return std::max(ticks, 0.0) / TICKS_PER_BEAT;
+}
@@ -0,0 +1,68 @@
+#ifndef GODOT_MIDI_CLOCK_H
+#define GODOT_MIDI_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace godot {
+
+// Tracks incoming MIDI clock (0xF8 at 24 PPQ) and transport messages.
+//
+// process() runs on the MIDI thread and feeds the driver timestamp of each
+// tick into a second-order phase-locked loop (an alpha-beta filter on the
+// predicted tick time), which smooths out driver and cable jitter while
+// following tempo changes. The filtered state is published through a
+// seqlock so any thread can query it without locking.
+class MidiClock {
+public:
+    static const int TICKS_PER_BEAT = 24;
+
+    struct State {
+        double ref_time = 0.0;    // Filtered time of the reference tick, seconds
+        double period = 0.0;      // Filtered seconds per tick, 0 until known
+        int64_t ref_tick = -1;    // Index of the reference tick since start
+        double jitter = 0.0;      // RMS tick timing error, seconds
+        double drift = 0.0;       // Mean tick timing error, seconds
+        bool playing = false;
+        bool locked = false;
+    };
+
+    MidiClock();
+
+    // MIDI thread: consume a realtime status byte. Returns true if handled.
+    bool process(unsigned char status, double time);
+    void reset();
+
+    // Any thread
+    State get_state() const;
+    double get_bpm() const;
+    double get_beat_position(double at_time) const;
+
+private:
+    static constexpr double ALPHA = 0.2;
+    static constexpr double BETA = ALPHA * ALPHA / (2.0 - ALPHA);
+    static constexpr double STATS_WEIGHT = 0.05;
+    static const int LOCK_TICKS = 12;
+
+    // MIDI thread only
+    State state;
+    double last_tick_time = 0.0;
+    double jitter_sq = 0.0;
+    int stable_ticks = 0;
+
+    void on_tick(double time);
+    void publish();
+
+    // Seqlock-protected copy of state for readers
+    std::atomic<uint32_t> sequence{ 0 };
+    std::atomic<double> pub_ref_time{ 0.0 };
+    std::atomic<double> pub_period{ 0.0 };
+    std::atomic<int64_t> pub_ref_tick{ -1 };
+    std::atomic<double> pub_jitter{ 0.0 };
+    std::atomic<double> pub_drift{ 0.0 };
+    std::atomic<uint8_t> pub_flags{ 0 };
+};
+
+}
+
+#endif // GODOT_MIDI_CLOCK_H
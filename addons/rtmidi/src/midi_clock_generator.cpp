@@ -0,0 +1,212 @@
+#include "midi_clock_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+#endif
+
+using namespace godot;
+
+MidiClockGenerator::MidiClockGenerator(SendCallback p_send, void *p_user_data) :
+        send(p_send), user_data(p_user_data) {
+}
+
+MidiClockGenerator::~MidiClockGenerator() {
+    stop_clock();
+}
+
+bool MidiClockGenerator::start_clock(double p_bpm) {
+    if (thread.joinable()) {
+        return false;
+    }
+
+    set_bpm(p_bpm);
+    commands.store(0, std::memory_order_relaxed);
+    stat_ticks.store(0, std::memory_order_relaxed);
+    stat_last_error.store(0, std::memory_order_relaxed);
+    stat_max_error.store(0, std::memory_order_relaxed);
+    stat_error_sum.store(0, std::memory_order_relaxed);
+    stat_first_error.store(0, std::memory_order_relaxed);
+    stat_resyncs.store(0, std::memory_order_relaxed);
+    quit.store(false, std::memory_order_release);
+    thread = std::thread(&MidiClockGenerator::run, this);
+    return true;
+}
+
+void MidiClockGenerator::stop_clock() {
+    if (!thread.joinable()) {
+        return;
+    }
+
+    {
+        // Set under the mutex so the thread can't miss the wake-up between
+        // checking quit and starting to wait
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        quit.store(true, std::memory_order_release);
+    }
+    wake.notify_all();
+    thread.join();
+    playing.store(false, std::memory_order_release);
+}
+
+bool MidiClockGenerator::is_running() const {
+    return thread.joinable();
+}
+
+void MidiClockGenerator::set_bpm(double p_bpm) {
+    bpm.store(std::clamp(p_bpm, MIN_BPM, MAX_BPM), std::memory_order_release);
+}
+
+double MidiClockGenerator::get_bpm() const {
+    return bpm.load(std::memory_order_acquire);
+}
+
+void MidiClockGenerator::transport_start() {
+    commands.fetch_or(COMMAND_START, std::memory_order_acq_rel);
+}
+
+void MidiClockGenerator::transport_stop() {
+    commands.fetch_or(COMMAND_STOP, std::memory_order_acq_rel);
+}
+
+void MidiClockGenerator::transport_continue() {
+    commands.fetch_or(COMMAND_CONTINUE, std::memory_order_acq_rel);
+}
+
+void MidiClockGenerator::set_song_position(int p_sixteenths) {
+    pending_position.store(std::clamp(p_sixteenths, 0, 0x3FFF), std::memory_order_relaxed);
+    commands.fetch_or(COMMAND_SONG_POSITION, std::memory_order_acq_rel);
+}
+
+bool MidiClockGenerator::is_playing() const {
+    return playing.load(std::memory_order_acquire);
+}
+
+int64_t MidiClockGenerator::get_song_position() const {
+    return position.load(std::memory_order_acquire);
+}
+
+MidiClockGenerator::Stats MidiClockGenerator::get_stats() const {
+    Stats stats;
+    stats.ticks = stat_ticks.load(std::memory_order_acquire);
+    if (stats.ticks == 0) {
+        return stats;
+    }
+    int64_t last = stat_last_error.load(std::memory_order_relaxed);
+    stats.last_error = last / 1000000000.0;
+    stats.max_error = stat_max_error.load(std::memory_order_relaxed) / 1000000000.0;
+    stats.mean_error = stat_error_sum.load(std::memory_order_relaxed) / (double)stats.ticks / 1000000000.0;
+    stats.drift = (last - stat_first_error.load(std::memory_order_relaxed)) / 1000000000.0;
+    stats.resyncs = stat_resyncs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool MidiClockGenerator::wait_until_ns(uint64_t p_deadline) {
+    // steady_clock waits are absolute on CLOCK_MONOTONIC, as precise as
+    // sleep_until_ns()
+    std::chrono::steady_clock::time_point until(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(p_deadline)));
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    return !wake.wait_until(lock, until, [this] { return quit.load(std::memory_order_acquire); });
+}
+
+void MidiClockGenerator::send_status(unsigned char p_status) {
+    send(&p_status, 1, user_data);
+}
+
+void MidiClockGenerator::run() {
+    double period = 60000000000.0 / (get_bpm() * TICKS_PER_BEAT);
+    uint64_t anchor = now_ns();
+    uint64_t anchor_tick = 0;
+    uint64_t tick = 0;
+    int step_ticks = 0;
+
+    while (!quit.load(std::memory_order_acquire)) {
+        uint64_t deadline = anchor + (uint64_t)std::llround((tick - anchor_tick) * period);
+        if (!wait_until_ns(deadline)) {
+            break;
+        }
+
+        // More than a period late: the missed ticks are gone, so start the
+        // grid over from now instead of sending them back to back
+        uint64_t now = now_ns();
+        if (now > deadline && (double)(now - deadline) > period) {
+            anchor = now;
+            anchor_tick = tick;
+            deadline = now;
+            stat_resyncs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t pending = commands.exchange(0, std::memory_order_acq_rel);
+        if (pending & COMMAND_STOP) {
+            send_status(0xFC);
+            playing.store(false, std::memory_order_release);
+        }
+        if (pending & COMMAND_SONG_POSITION) {
+            int sixteenths = pending_position.load(std::memory_order_relaxed);
+            const unsigned char message[3] = { 0xF2, (unsigned char)(sixteenths & 0x7F), (unsigned char)(sixteenths >> 7) };
+            send(message, 3, user_data);
+            position.store(sixteenths, std::memory_order_release);
+            step_ticks = 0;
+        }
+        if (pending & COMMAND_START) {
+            send_status(0xFA);
+            position.store(0, std::memory_order_release);
+            step_ticks = 0;
+            playing.store(true, std::memory_order_release);
+        } else if (pending & COMMAND_CONTINUE) {
+            send_status(0xFB);
+            playing.store(true, std::memory_order_release);
+        }
+
+        send_status(0xF8);
+        int64_t error = (int64_t)(now_ns() - deadline);
+
+        if (playing.load(std::memory_order_relaxed) && ++step_ticks == TICKS_PER_STEP) {
+            step_ticks = 0;
+            position.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        uint64_t count = stat_ticks.load(std::memory_order_relaxed);
+        if (count == 0) {
+            stat_first_error.store(error, std::memory_order_relaxed);
+        }
+        stat_last_error.store(error, std::memory_order_relaxed);
+        stat_max_error.store(std::max(error, stat_max_error.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        stat_error_sum.fetch_add(error, std::memory_order_relaxed);
+        stat_ticks.store(count + 1, std::memory_order_release);
+
+        // A new tempo starts from the tick just sent
+        double new_period = 60000000000.0 / (get_bpm() * TICKS_PER_BEAT);
+        if (new_period != period) {
+            anchor = deadline;
+            anchor_tick = tick;
+            period = new_period;
+        }
+        tick++;
+    }
+}
+
+uint64_t MidiClockGenerator::now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+void MidiClockGenerator::sleep_until_ns(uint64_t p_deadline) {
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    struct timespec ts;
+    ts.tv_sec = (time_t)(p_deadline / 1000000000ULL);
+    ts.tv_nsec = (long)(p_deadline % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(p_deadline))));
+#endif
+}
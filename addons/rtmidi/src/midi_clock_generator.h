@@ -0,0 +1,106 @@
+#ifndef GODOT_MIDI_CLOCK_GENERATOR_H
+#define GODOT_MIDI_CLOCK_GENERATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace godot {
+
+// Generates MIDI clock (0xF8 at 24 PPQ) as tempo master.
+//
+// A dedicated thread sleeps to absolute deadlines computed from a tempo
+// anchor (deadline = anchor + ticks since anchor * period), so sleep
+// overshoot never accumulates. A tempo change re-anchors at the tick just
+// sent: the next tick is exactly one new period later and the beat grid
+// stays continuous. If the thread falls more than a period behind (it was
+// descheduled, or the send blocked), it re-anchors at the current time and
+// carries on from there rather than sending the missed ticks in a burst.
+// Transport messages requested from other threads are sent by the clock
+// thread right before the next tick, so Start always lines up with the
+// first clock of a beat.
+class MidiClockGenerator {
+public:
+    typedef void (*SendCallback)(const unsigned char *p_message, size_t p_size, void *p_user_data);
+
+    static const int TICKS_PER_BEAT = 24;
+    static const int TICKS_PER_STEP = 6;  // Song position counts sixteenths
+    static constexpr double MIN_BPM = 20.0;
+    static constexpr double MAX_BPM = 300.0;
+
+    struct Stats {
+        uint64_t ticks = 0;
+        double last_error = 0.0;  // Send time - deadline of the latest tick, seconds
+        double max_error = 0.0;
+        double mean_error = 0.0;
+        double drift = 0.0;       // Change in error since the first tick, seconds
+        uint64_t resyncs = 0;     // Times the clock fell a period behind and re-anchored
+    };
+
+    MidiClockGenerator(SendCallback p_send, void *p_user_data);
+    ~MidiClockGenerator();
+
+    // Main thread
+    bool start_clock(double p_bpm);
+    void stop_clock();
+    bool is_running() const;
+    void set_bpm(double p_bpm);
+    double get_bpm() const;
+
+    // Transport, sent with the next tick. The song position (in sixteenths)
+    // should only be set while stopped, followed by transport_continue().
+    void transport_start();
+    void transport_stop();
+    void transport_continue();
+    void set_song_position(int p_sixteenths);
+
+    // Any thread
+    bool is_playing() const;
+    int64_t get_song_position() const;
+    Stats get_stats() const;
+
+    // Steady clock in nanoseconds, and an absolute sleep on it
+    static uint64_t now_ns();
+    static void sleep_until_ns(uint64_t p_deadline);
+
+private:
+    enum Command {
+        COMMAND_START = 1,
+        COMMAND_STOP = 2,
+        COMMAND_CONTINUE = 4,
+        COMMAND_SONG_POSITION = 8,
+    };
+
+    SendCallback send;
+    void *user_data;
+
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    // The clock thread waits on this between ticks so stop_clock() can wake it
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<double> bpm{ 120.0 };
+    std::atomic<uint32_t> commands{ 0 };
+    std::atomic<int> pending_position{ 0 };
+
+    // Published by the clock thread
+    std::atomic<bool> playing{ false };
+    std::atomic<int64_t> position{ 0 };
+    std::atomic<uint64_t> stat_ticks{ 0 };
+    std::atomic<int64_t> stat_last_error{ 0 };
+    std::atomic<int64_t> stat_max_error{ 0 };
+    std::atomic<int64_t> stat_error_sum{ 0 };
+    std::atomic<int64_t> stat_first_error{ 0 };
+    std::atomic<uint64_t> stat_resyncs{ 0 };
+
+    void run();
+    bool wait_until_ns(uint64_t p_deadline);
+    void send_status(unsigned char p_status);
+};
+
+}
+
+#endif // GODOT_MIDI_CLOCK_GENERATOR_H
@@ -0,0 +1,547 @@
+#include "midi_file.h"
+#include "midi_clock_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace godot {
+
+static const double DEFAULT_TEMPO_US = 500000.0;  // 120 BPM until the first tempo event
+static const int CLOCKS_PER_QUARTER = 24;
+
+static uint32_t read_be32(const uint8_t *p_data) {
+    return (uint32_t(p_data[0]) << 24) | (uint32_t(p_data[1]) << 16) | (uint32_t(p_data[2]) << 8) | p_data[3];
+}
+
+static uint16_t read_be16(const uint8_t *p_data) {
+    return uint16_t((p_data[0] << 8) | p_data[1]);
+}
+
+// Variable-length quantity, at most four bytes
+static bool read_vlq(const uint8_t *p_data, uint32_t p_size, uint32_t &r_offset, uint32_t &r_value) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        if (r_offset >= p_size) {
+            return false;
+        }
+        uint8_t byte = p_data[r_offset++];
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            r_value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MidiFile::open(const std::string &p_path) {
+    close();
+    if (!file.open_read(p_path) || file.get_size() < 14) {
+        close();
+        return false;
+    }
+
+    const uint8_t *data = file.get_data();
+    size_t size = file.get_size();
+    uint32_t header_size = read_be32(data + 4);
+    if (memcmp(data, "MThd", 4) != 0 || header_size < 6 || header_size > size - 8) {
+        close();
+        return false;
+    }
+    // Type 2 holds independent sequences, which don't merge into one stream
+    int format = read_be16(data + 8);
+    int track_count = read_be16(data + 10);
+    int division = read_be16(data + 12);
+    if (format > 1) {
+        close();
+        return false;
+    }
+
+    size_t offset = 8 + header_size;
+    while (offset + 8 <= size && (int)tracks.size() < track_count) {
+        size_t body = offset + 8;
+        size_t chunk_size = std::min<size_t>(read_be32(data + offset + 4), size - body);
+        // Unknown chunk types are skipped
+        if (memcmp(data + offset, "MTrk", 4) == 0) {
+            Track track;
+            track.data = data + body;
+            track.size = uint32_t(chunk_size);
+            tracks.push_back(track);
+        }
+        offset = body + chunk_size;
+    }
+
+    double smpte_ns_per_tick = 0.0;
+    if (division & 0x8000) {
+        // SMPTE: frames per second (negative) and ticks per frame
+        int fps = -int(int8_t(division >> 8));
+        int ticks_per_frame = division & 0xFF;
+        if (fps > 0 && ticks_per_frame > 0) {
+            smpte_ns_per_tick = 1000000000.0 / ((fps == 29 ? 29.97 : fps) * ticks_per_frame);
+        }
+    } else {
+        ppq = division;
+    }
+    if (tracks.empty() || (ppq == 0 && smpte_ns_per_tick == 0.0)) {
+        close();
+        return false;
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> tempos;
+    uint64_t end_tick = 0;
+    for (int i = 0; i < (int)tracks.size(); i++) {
+        uint64_t track_end = 0;
+        index_track(i, tempos, track_end);
+        end_tick = std::max(end_tick, track_end);
+    }
+
+    if (ppq > 0) {
+        // Tempo events can sit in any track; at equal ticks the later track wins
+        std::stable_sort(tempos.begin(), tempos.end(),
+                [](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b) { return a.first < b.first; });
+        tempo_map.push_back({ 0, 0.0, DEFAULT_TEMPO_US * 1000.0 / ppq });
+        for (const std::pair<uint64_t, uint32_t> &tempo : tempos) {
+            double ns_per_tick = tempo.second * 1000.0 / ppq;
+            TempoPoint &last = tempo_map.back();
+            if (tempo.first == last.tick) {
+                last.ns_per_tick = ns_per_tick;
+                continue;
+            }
+            double time_ns = last.time_ns + (tempo.first - last.tick) * last.ns_per_tick;
+            tempo_map.push_back({ tempo.first, time_ns, ns_per_tick });
+        }
+    } else {
+        tempo_map.push_back({ 0, 0.0, smpte_ns_per_tick });
+    }
+
+    length_ns = tick_to_ns(double(end_tick));
+    return true;
+}
+
+void MidiFile::close() {
+    tracks.clear();
+    tempo_map.clear();
+    ppq = 0;
+    length_ns = 0;
+    file.close();
+}
+
+// One pass over the track: index entries, tempo changes and the last tick
+bool MidiFile::index_track(int p_track, std::vector<std::pair<uint64_t, uint32_t>> &r_tempos, uint64_t &r_end_tick) {
+    Track &track = tracks[p_track];
+    Cursor cursor;
+    Event event;
+    uint64_t count = 0;
+    while (true) {
+        Cursor before = cursor;
+        if (!read_event(p_track, cursor, event)) {
+            break;
+        }
+        if (count++ % INDEX_STRIDE == 0) {
+            track.index.push_back({ event.tick, before });
+        }
+        if (event.status == 0xFF && event.meta_type == 0x51 && event.payload_size >= 3) {
+            uint32_t tempo = (uint32_t(event.payload[0]) << 16) | (uint32_t(event.payload[1]) << 8) | event.payload[2];
+            if (tempo > 0) {
+                r_tempos.push_back({ event.tick, tempo });
+            }
+        }
+    }
+    // A delta time on the end-of-track event still extends the track
+    uint32_t offset = cursor.offset;
+    uint32_t delta = 0;
+    if (read_vlq(track.data, track.size, offset, delta)) {
+        cursor.tick += delta;
+    }
+    r_end_tick = cursor.tick;
+    return count > 0;
+}
+
+bool MidiFile::read_event(int p_track, Cursor &r_cursor, Event &r_event) const {
+    const Track &track = tracks[p_track];
+    const uint8_t *data = track.data;
+    uint32_t size = track.size;
+    uint32_t offset = r_cursor.offset;
+
+    uint32_t delta;
+    if (!read_vlq(data, size, offset, delta) || offset >= size) {
+        return false;
+    }
+    uint8_t status = data[offset];
+    if (status & 0x80) {
+        offset++;
+    } else if (r_cursor.running_status) {
+        status = r_cursor.running_status;
+    } else {
+        return false;
+    }
+
+    r_event.tick = r_cursor.tick + delta;
+    r_event.status = status;
+    r_event.meta_type = 0;
+    r_event.data_size = 0;
+    r_event.payload = nullptr;
+    r_event.payload_size = 0;
+
+    uint8_t running_status = r_cursor.running_status;
+    if (status < 0xF0) {
+        int data_size = (status & 0xE0) == 0xC0 ? 1 : 2;
+        if (offset + data_size > size) {
+            return false;
+        }
+        r_event.data[0] = data[offset];
+        r_event.data[1] = data_size == 2 ? data[offset + 1] : 0;
+        r_event.data_size = uint8_t(data_size);
+        offset += data_size;
+        running_status = status;
+    } else if (status == 0xF0 || status == 0xF7 || status == 0xFF) {
+        if (status == 0xFF) {
+            if (offset >= size) {
+                return false;
+            }
+            r_event.meta_type = data[offset++];
+            if (r_event.meta_type == 0x2F) {
+                return false;  // End of track
+            }
+        }
+        uint32_t length;
+        if (!read_vlq(data, size, offset, length) || length > size - offset) {
+            return false;
+        }
+        r_event.payload = data + offset;
+        r_event.payload_size = length;
+        offset += length;
+        // Running status survives SysEx and meta events: the spec says it
+        // shouldn't, but files in the wild rely on it
+    } else {
+        return false;
+    }
+
+    r_cursor.offset = offset;
+    r_cursor.tick = r_event.tick;
+    r_cursor.running_status = running_status;
+    return true;
+}
+
+MidiFile::Cursor MidiFile::seek(int p_track, uint64_t p_time_ns) const {
+    const std::vector<IndexEntry> &index = tracks[p_track].index;
+    // Rounded down, so the entry found is never past the target
+    uint64_t tick = uint64_t(ns_to_tick(p_time_ns));
+    auto entry = std::lower_bound(index.begin(), index.end(), tick,
+            [](const IndexEntry &e, uint64_t t) { return e.tick < t; });
+
+    Cursor cursor;
+    if (entry != index.begin()) {
+        cursor = std::prev(entry)->cursor;
+    }
+    Cursor next = cursor;
+    Event event;
+    while (read_event(p_track, next, event) && tick_to_ns(double(event.tick)) < p_time_ns) {
+        cursor = next;
+    }
+    return cursor;
+}
+
+const MidiFile::TempoPoint &MidiFile::tempo_at_tick(double p_tick) const {
+    auto point = std::upper_bound(tempo_map.begin(), tempo_map.end(), p_tick,
+            [](double t, const TempoPoint &p) { return t < double(p.tick); });
+    return *std::prev(point);
+}
+
+uint64_t MidiFile::tick_to_ns(double p_tick) const {
+    if (tempo_map.empty()) {
+        return 0;
+    }
+    const TempoPoint &point = tempo_at_tick(p_tick);
+    return uint64_t(std::llround(point.time_ns + (p_tick - double(point.tick)) * point.ns_per_tick));
+}
+
+double MidiFile::ns_to_tick(uint64_t p_time_ns) const {
+    if (tempo_map.empty()) {
+        return 0.0;
+    }
+    auto point = std::upper_bound(tempo_map.begin(), tempo_map.end(), double(p_time_ns),
+            [](double t, const TempoPoint &p) { return t < p.time_ns; });
+    const TempoPoint &tempo = *std::prev(point);
+    return double(tempo.tick) + (double(p_time_ns) - tempo.time_ns) / tempo.ns_per_tick;
+}
+
+// Heap order: earliest first, clock ticks before track events at the same
+// time, then tracks in file order
+bool MidiFilePlayer::stream_after(const Stream &a, const Stream &b) {
+    return a.time_ns != b.time_ns ? a.time_ns > b.time_ns : a.track > b.track;
+}
+
+MidiFilePlayer::MidiFilePlayer(SendCallback p_send, void *p_user_data) :
+        send(p_send), user_data(p_user_data) {
+}
+
+MidiFilePlayer::~MidiFilePlayer() {
+    close();
+}
+
+bool MidiFilePlayer::open(const std::string &p_path) {
+    close();
+    if (!midi_file.open(p_path)) {
+        return false;
+    }
+    int track_count = midi_file.get_track_count();
+    cursors.resize(track_count);
+    next_events.resize(track_count);
+    heap.reserve(track_count + 1);
+    return true;
+}
+
+void MidiFilePlayer::close() {
+    pause();
+    midi_file.close();
+    position.store(0, std::memory_order_relaxed);
+}
+
+bool MidiFilePlayer::play() {
+    if (!midi_file.is_open()) {
+        return false;
+    }
+    if (is_playing()) {
+        return true;
+    }
+    if (thread.joinable()) {
+        thread.join();  // Ran to the end
+    }
+
+    // At the end, playing starts over
+    uint64_t start = position.load(std::memory_order_relaxed);
+    if (start >= get_length()) {
+        start = 0;
+        position.store(0, std::memory_order_relaxed);
+    }
+    prepare(start);
+    quit.store(false, std::memory_order_relaxed);
+    finished.store(false, std::memory_order_release);
+    thread = std::thread(&MidiFilePlayer::run, this);
+    return true;
+}
+
+void MidiFilePlayer::pause() {
+    if (thread.joinable()) {
+        quit.store(true, std::memory_order_release);
+        thread.join();
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+bool MidiFilePlayer::is_playing() const {
+    return !finished.load(std::memory_order_acquire);
+}
+
+bool MidiFilePlayer::seek(uint64_t p_time_ns) {
+    if (!midi_file.is_open()) {
+        return false;
+    }
+    bool was_playing = is_playing();
+    pause();
+    position.store(std::min(p_time_ns, get_length()), std::memory_order_relaxed);
+    return !was_playing || play();
+}
+
+uint64_t MidiFilePlayer::get_position() const {
+    if (!is_playing()) {
+        return position.load(std::memory_order_relaxed);
+    }
+    uint64_t elapsed = MidiClockGenerator::now_ns() - base_ns.load(std::memory_order_relaxed);
+    return std::min(elapsed, get_length());
+}
+
+uint64_t MidiFilePlayer::clock_time(uint64_t p_tick) const {
+    return midi_file.tick_to_ns(double(p_tick) * midi_file.get_ppq() / CLOCKS_PER_QUARTER);
+}
+
+void MidiFilePlayer::push_stream(uint64_t p_time_ns, int p_track) {
+    heap.push_back({ p_time_ns, p_track });
+    std::push_heap(heap.begin(), heap.end(), stream_after);
+}
+
+// Read the next sendable event of p_track into next_events and queue it on
+// the heap. Meta events are skipped: tempo is already in the tempo map.
+bool MidiFilePlayer::advance(int p_track) {
+    MidiFile::Event &event = next_events[p_track];
+    while (midi_file.read_event(p_track, cursors[p_track], event)) {
+        if (event.status != 0xFF) {
+            push_stream(midi_file.tick_to_ns(double(event.tick)), p_track);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Main thread, with the playback thread stopped
+void MidiFilePlayer::prepare(uint64_t p_time_ns) {
+    heap.clear();
+    batch_count = 0;
+    memset(held_notes, 0, sizeof(held_notes));
+
+    clock_enabled = send_clock && midi_file.get_ppq() > 0;
+    if (clock_enabled) {
+        // Song Position Pointer counts sixteenths, and a receiver counts
+        // clocks on from there, so resume from the sixteenth at or before
+        // the position: the clock and the events then agree on the beat
+        double beats = midi_file.ns_to_tick(p_time_ns) / midi_file.get_ppq();
+        uint64_t sixteenths = uint64_t(beats * 4.0);
+        if (sixteenths <= 0x3FFF) {
+            song_position = int(sixteenths);
+            clock_tick = sixteenths * MidiClockGenerator::TICKS_PER_STEP;
+            p_time_ns = std::min(clock_time(clock_tick), p_time_ns);
+            position.store(p_time_ns, std::memory_order_relaxed);
+        } else {
+            // Past what a pointer can express: the nearest clock after
+            song_position = 0x3FFF;
+            clock_tick = uint64_t(beats * CLOCKS_PER_QUARTER);
+            while (clock_time(clock_tick) < p_time_ns) {
+                clock_tick++;
+            }
+        }
+        push_stream(clock_time(clock_tick), CLOCK_STREAM);
+    }
+
+    for (int i = 0; i < midi_file.get_track_count(); i++) {
+        cursors[i] = midi_file.seek(i, p_time_ns);
+        advance(i);
+    }
+}
+
+// Messages over three bytes must already be in sysex
+void MidiFilePlayer::queue(const unsigned char *p_bytes, unsigned int p_size, uint64_t p_time_ns) {
+    RtMidiEvent &event = batch[batch_count++];
+    event.timeNs = p_time_ns;
+    event.deltaTime = 0.0;
+    event.source = 0;
+    event.size = p_size;
+    if (p_size <= 3) {
+        event.sysex = nullptr;
+        memcpy(event.bytes, p_bytes, p_size);
+    } else {
+        event.sysex = p_bytes;
+    }
+    // SysEx data lives in the shared buffer, so it ends the batch
+    if (batch_count == BATCH_SIZE || event.sysex) {
+        flush_batch();
+    }
+}
+
+void MidiFilePlayer::flush_batch() {
+    if (batch_count > 0) {
+        send(batch, batch_count, user_data);
+        batch_count = 0;
+    }
+}
+
+void MidiFilePlayer::release_notes(uint64_t p_time_ns) {
+    for (int channel = 0; channel < 16; channel++) {
+        for (int word = 0; word < 8; word++) {
+            uint16_t bits = held_notes[channel][word];
+            for (int bit = 0; bits; bit++, bits >>= 1) {
+                if (bits & 1) {
+                    const unsigned char message[3] = { (unsigned char)(0x80 | channel), (unsigned char)(word * 16 + bit), 0 };
+                    queue(message, 3, p_time_ns);
+                }
+            }
+            held_notes[channel][word] = 0;
+        }
+    }
+}
+
+void MidiFilePlayer::run() {
+    uint64_t start = position.load(std::memory_order_relaxed);
+    uint64_t now = MidiClockGenerator::now_ns();
+    uint64_t base = now - start;
+    base_ns.store(base, std::memory_order_relaxed);
+    uint64_t length = get_length();
+
+    if (clock_enabled) {
+        if (start == 0) {
+            const unsigned char message[1] = { 0xFA };
+            queue(message, 1, now);
+        } else {
+            // Song position in sixteenths, then Continue
+            const unsigned char message[3] = { 0xF2, (unsigned char)(song_position & 0x7F), (unsigned char)(song_position >> 7) };
+            queue(message, 3, now);
+            const unsigned char resume[1] = { 0xFB };
+            queue(resume, 1, now);
+        }
+    }
+
+    while (!quit.load(std::memory_order_acquire) && !heap.empty()) {
+        Stream next = heap.front();
+        uint64_t deadline = base + next.time_ns;
+        if (deadline > now) {
+            now = MidiClockGenerator::now_ns();
+            if (deadline > now) {
+                // Everything due so far goes out in one call
+                flush_batch();
+                MidiClockGenerator::sleep_until_ns(std::min<uint64_t>(deadline, now + MAX_SLEEP_NS));
+                now = MidiClockGenerator::now_ns();
+                continue;
+            }
+        }
+
+        std::pop_heap(heap.begin(), heap.end(), stream_after);
+        heap.pop_back();
+
+        if (next.track == CLOCK_STREAM) {
+            const unsigned char message[1] = { 0xF8 };
+            queue(message, 1, deadline);
+            uint64_t time = clock_time(++clock_tick);
+            if (time <= length) {
+                push_stream(time, CLOCK_STREAM);
+            }
+            continue;
+        }
+
+        const MidiFile::Event &event = next_events[next.track];
+        if (event.status == 0xF0 || event.status == 0xF7) {
+            // F7 escapes carry raw bytes; longer messages than fit are dropped
+            unsigned int size = 0;
+            if (event.status == 0xF0) {
+                sysex[size++] = 0xF0;
+            }
+            if (event.payload_size > 0 && event.payload_size <= SYSEX_SIZE - size) {
+                memcpy(sysex + size, event.payload, event.payload_size);
+                size += event.payload_size;
+                queue(sysex, size, deadline);
+            }
+        } else {
+            const unsigned char message[3] = { event.status, event.data[0], event.data[1] };
+            uint8_t command = event.status & 0xF0;
+            if (command == 0x90 || command == 0x80) {
+                uint8_t note = event.data[0] & 0x7F;
+                uint16_t &word = held_notes[event.status & 0x0F][note >> 4];
+                uint16_t bit = uint16_t(1 << (note & 0x0F));
+                if (command == 0x90 && event.data[1] > 0) {
+                    word |= bit;
+                } else {
+                    word &= ~bit;
+                }
+            }
+            queue(message, 1 + event.data_size, deadline);
+        }
+        advance(next.track);
+    }
+
+    // All events before the earliest unsent one went out
+    uint64_t stopped_at = length;
+    if (!heap.empty()) {
+        stopped_at = std::min(std::min<uint64_t>(MidiClockGenerator::now_ns() - base, heap.front().time_ns), length);
+    }
+    now = MidiClockGenerator::now_ns();
+    release_notes(now);
+    if (clock_enabled) {
+        const unsigned char message[1] = { 0xFC };
+        queue(message, 1, now);
+    }
+    flush_batch();
+    position.store(stopped_at, std::memory_order_relaxed);
+    finished.store(true, std::memory_order_release);
+}
+
+}
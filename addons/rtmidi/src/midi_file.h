@@ -0,0 +1,171 @@
+#ifndef GODOT_MIDI_FILE_H
+#define GODOT_MIDI_FILE_H
+
+#include <RtMidi.h>
+#include "midi_log.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace godot {
+
+// Standard MIDI File (type 0 or 1), memory-mapped and decoded in place.
+// open() makes one pass over every track to build the tempo map and a
+// sparse per-track index; events are then read on demand through cursors,
+// so a file is never expanded into an event list.
+class MidiFile {
+public:
+    // Every INDEX_STRIDE events a track records where it is
+    static const int INDEX_STRIDE = 64;
+
+    struct Cursor {
+        uint32_t offset = 0;  // Next event's delta time in the track data
+        uint64_t tick = 0;    // Tick of the previous event
+        uint8_t running_status = 0;
+    };
+
+    struct Event {
+        uint64_t tick;
+        uint8_t status;      // Channel status, 0xF0/0xF7 for SysEx, 0xFF for meta
+        uint8_t meta_type;
+        uint8_t data[2];     // Channel message data bytes
+        uint8_t data_size;
+        const uint8_t *payload;  // SysEx and meta bytes after the length
+        uint32_t payload_size;
+    };
+
+    bool open(const std::string &p_path);
+    void close();
+    bool is_open() const { return file.is_open(); }
+
+    int get_track_count() const { return (int)tracks.size(); }
+    // Ticks per quarter note, 0 for SMPTE time division
+    int get_ppq() const { return ppq; }
+    uint64_t get_length_ns() const { return length_ns; }
+
+    // Decode the event at r_cursor and step past it. False at the end of
+    // the track, including a truncated one.
+    bool read_event(int p_track, Cursor &r_cursor, Event &r_event) const;
+    // Cursor at the first event of p_track not earlier than p_time_ns, in
+    // O(log n) index lookup plus at most INDEX_STRIDE decoded events
+    Cursor seek(int p_track, uint64_t p_time_ns) const;
+
+    uint64_t tick_to_ns(double p_tick) const;
+    double ns_to_tick(uint64_t p_time_ns) const;
+
+private:
+    struct IndexEntry {
+        uint64_t tick;
+        Cursor cursor;
+    };
+
+    struct Track {
+        const uint8_t *data;
+        uint32_t size;
+        std::vector<IndexEntry> index;
+    };
+
+    // Tempo in effect from tick on
+    struct TempoPoint {
+        uint64_t tick;
+        double time_ns;
+        double ns_per_tick;
+    };
+
+    MidiLogFile file;
+    std::vector<Track> tracks;
+    std::vector<TempoPoint> tempo_map;
+    int ppq = 0;
+    uint64_t length_ns = 0;
+
+    bool index_track(int p_track, std::vector<std::pair<uint64_t, uint32_t>> &r_tempos, uint64_t &r_end_tick);
+    const TempoPoint &tempo_at_tick(double p_tick) const;
+};
+
+// Plays a MidiFile through a send callback from its own thread. Tracks are
+// merged with a k-way heap keyed on event time, and every event is sent at
+// an absolute deadline from the start of playback, so timing doesn't drift
+// over a long file. Optionally sends MIDI clock derived from the tempo map,
+// with Start/Continue/Stop, the way a sequencer running as clock master
+// would; playing from a position then resumes from the sixteenth at or
+// before it, where its Song Position Pointer and the first clock fall.
+// Stopping releases the notes still held.
+class MidiFilePlayer {
+public:
+    typedef void (*SendCallback)(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data);
+
+    MidiFilePlayer(SendCallback p_send, void *p_user_data);
+    ~MidiFilePlayer();
+
+    bool open(const std::string &p_path);
+    void close();
+    bool is_open() const { return midi_file.is_open(); }
+
+    // From the current position
+    bool play();
+    // Keep the position
+    void pause();
+    bool is_playing() const;
+    // Takes effect immediately while playing
+    bool seek(uint64_t p_time_ns);
+    uint64_t get_position() const;
+    uint64_t get_length() const { return midi_file.get_length_ns(); }
+
+    // Applies from the next play() or seek(). Ignored for SMPTE time
+    // division, which has no beats.
+    void set_send_clock(bool p_enabled) { send_clock = p_enabled; }
+    bool get_send_clock() const { return send_clock; }
+
+private:
+    static const int BATCH_SIZE = 256;
+    static const int SYSEX_SIZE = 8192;
+    static const uint64_t MAX_SLEEP_NS = 100000000;  // Longest sleep between quit checks
+    static const int CLOCK_STREAM = -1;               // Heap entry for clock ticks
+
+    struct Stream {
+        uint64_t time_ns;  // File time of the next event
+        int track;
+    };
+
+    SendCallback send;
+    void *user_data;
+
+    MidiFile midi_file;
+    bool send_clock = true;
+
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> finished{ true };
+    // File time playback resumes from; while playing, file time = now - base
+    std::atomic<uint64_t> position{ 0 };
+    std::atomic<uint64_t> base_ns{ 0 };
+
+    // Playback thread only; sized on the main thread before it starts
+    std::vector<Stream> heap;
+    std::vector<MidiFile::Cursor> cursors;
+    std::vector<MidiFile::Event> next_events;
+    bool clock_enabled = false;
+    uint64_t clock_tick = 0;
+    int song_position = 0;  // Sixteenths, sent before Continue
+    uint16_t held_notes[16][8];  // Bit per note still sounding
+    RtMidiEvent batch[BATCH_SIZE];
+    unsigned int batch_count = 0;
+    unsigned char sysex[SYSEX_SIZE];
+
+    static bool stream_after(const Stream &a, const Stream &b);
+    void run();
+    void prepare(uint64_t p_time_ns);
+    bool advance(int p_track);
+    uint64_t clock_time(uint64_t p_tick) const;
+    void push_stream(uint64_t p_time_ns, int p_track);
+    void queue(const unsigned char *p_bytes, unsigned int p_size, uint64_t p_time_ns);
+    void flush_batch();
+    void release_notes(uint64_t p_time_ns);
+};
+
+}
+
+#endif // GODOT_MIDI_FILE_H
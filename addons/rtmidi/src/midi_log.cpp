@@ -0,0 +1,399 @@
+#include "midi_log.h"
+#include "midi_clock_generator.h"
+#include "midi_memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace godot {
+
+static const char MIDI_LOG_MAGIC[8] = { 'G', 'D', 'M', 'I', 'D', 'L', 'O', 'G' };
+
+MidiLogFile::~MidiLogFile() {
+    close();
+}
+
+// Write to every page of a new log, so the MIDI thread never takes a page
+// fault (or a write fault on a page mapped in read-only) while appending,
+// and lock it in RAM if asked
+void MidiLogFile::prepare_pages(bool p_lock) {
+    static const size_t PAGE_STRIDE = 4096;  // The smallest page size in use
+    for (size_t offset = 0; offset < size; offset += PAGE_STRIDE) {
+        data[offset] = 0;
+    }
+    locked = p_lock && midi_lock_memory(data, size);
+}
+
+#ifdef _WIN32
+
+static std::wstring widen(const std::string &p_path) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, p_path.c_str(), -1, nullptr, 0);
+    std::wstring result(length > 0 ? length : 0, L'\0');
+    if (length > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, p_path.c_str(), -1, &result[0], length);
+    }
+    return result;
+}
+
+bool MidiLogFile::create(const std::string &p_path, size_t p_size, bool p_lock) {
+    close();
+    file = CreateFileW(widen(p_path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, DWORD(uint64_t(p_size) >> 32), DWORD(p_size & 0xFFFFFFFF), nullptr);
+    if (mapping) {
+        data = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, p_size));
+    }
+    if (!data) {
+        close();
+        return false;
+    }
+    size = p_size;
+    writable = true;
+    prepare_pages(p_lock);
+    return true;
+}
+
+bool MidiLogFile::open_read(const std::string &p_path) {
+    close();
+    file = CreateFileW(widen(p_path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        data = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!data) {
+        close();
+        return false;
+    }
+    size = size_t(file_size.QuadPart);
+    writable = false;
+    return true;
+}
+
+void MidiLogFile::close(size_t p_keep) {
+    if (data) {
+        if (locked) {
+            midi_unlock_memory(data, size);
+            locked = false;
+        }
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file) {
+        if (writable && p_keep > 0) {
+            LARGE_INTEGER end;
+            end.QuadPart = LONGLONG(p_keep);
+            SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(file);
+        }
+        CloseHandle(file);
+        file = nullptr;
+    }
+    size = 0;
+}
+
+#else
+
+bool MidiLogFile::create(const std::string &p_path, size_t p_size, bool p_lock) {
+    close();
+    fd = ::open(p_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // Reserve the blocks up front rather than leaving a sparse file for the
+    // filesystem to allocate into on the first write to each page
+    bool allocated = false;
+#ifdef __linux__
+    allocated = posix_fallocate(fd, 0, off_t(p_size)) == 0;
+#endif
+    if (!allocated && ftruncate(fd, off_t(p_size)) != 0) {
+        close();
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, p_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = static_cast<uint8_t *>(mapped);
+    size = p_size;
+    writable = true;
+    prepare_pages(p_lock);
+    return true;
+}
+
+bool MidiLogFile::open_read(const std::string &p_path) {
+    close();
+    fd = ::open(p_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = static_cast<uint8_t *>(mapped);
+    size = size_t(st.st_size);
+    writable = false;
+    return true;
+}
+
+void MidiLogFile::close(size_t p_keep) {
+    if (data) {
+        if (locked) {
+            midi_unlock_memory(data, size);
+            locked = false;
+        }
+        munmap(data, size);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        if (writable && p_keep > 0) {
+            // On failure the file keeps its preallocated size; the header
+            // count still tells how much of it is valid
+            int result = ftruncate(fd, off_t(p_keep));
+            (void)result;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+#endif
+
+bool MidiLogWriter::open(const std::string &p_path, uint64_t p_capacity, uint64_t p_start_time_ns, bool p_lock) {
+    close();
+    if (p_capacity == 0) {
+        return false;
+    }
+    if (!file.create(p_path, sizeof(MidiLogHeader) + size_t(p_capacity) * sizeof(MidiLogRecord), p_lock)) {
+        return false;
+    }
+
+    header = reinterpret_cast<MidiLogHeader *>(file.get_data());
+    records = reinterpret_cast<MidiLogRecord *>(file.get_data() + sizeof(MidiLogHeader));
+    memset(header, 0, sizeof(MidiLogHeader));
+    memcpy(header->magic, MIDI_LOG_MAGIC, sizeof(MIDI_LOG_MAGIC));
+    header->version = VERSION;
+    header->record_size = sizeof(MidiLogRecord);
+    header->capacity = p_capacity;
+    header->start_time_ns = p_start_time_ns;
+    capacity = p_capacity;
+    count.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void MidiLogWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    uint64_t written = count.load(std::memory_order_relaxed);
+    header->count = written;
+    // Drop the unused preallocation
+    file.close(sizeof(MidiLogHeader) + size_t(written) * sizeof(MidiLogRecord));
+    header = nullptr;
+    records = nullptr;
+    capacity = 0;
+}
+
+void MidiLogWriter::append(const RtMidiEvent &p_event) {
+    if (p_event.size == 0) {
+        return;
+    }
+
+    uint64_t index = count.load(std::memory_order_relaxed);
+    uint64_t needed = (p_event.size + MidiLogRecord::DATA_SIZE - 1) / MidiLogRecord::DATA_SIZE;
+    if (index + needed > capacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const unsigned char *bytes = p_event.data();
+    unsigned int offset = 0;
+    for (uint64_t i = 0; i < needed; i++) {
+        MidiLogRecord &record = records[index + i];
+        unsigned int chunk = std::min<unsigned int>(p_event.size - offset, MidiLogRecord::DATA_SIZE);
+        record.time_ns = p_event.timeNs;
+        record.source = p_event.source;
+        record.size = uint8_t(chunk);
+        record.flags = i + 1 < needed ? MidiLogRecord::FLAG_CONTINUES : 0;
+        memcpy(record.data, bytes + offset, chunk);
+        memset(record.data + chunk, 0, MidiLogRecord::DATA_SIZE - chunk);
+        offset += chunk;
+    }
+    count.store(index + needed, std::memory_order_relaxed);
+}
+
+void MidiLogWriter::commit() {
+    if (header) {
+        header->count = count.load(std::memory_order_relaxed);
+    }
+}
+
+MidiLogPlayer::MidiLogPlayer(SendCallback p_send, void *p_user_data) :
+        send(p_send), user_data(p_user_data) {
+}
+
+MidiLogPlayer::~MidiLogPlayer() {
+    stop();
+}
+
+bool MidiLogPlayer::start(const std::string &p_path, bool p_realtime) {
+    stop();
+    if (!file.open_read(p_path) || file.get_size() < sizeof(MidiLogHeader)) {
+        file.close();
+        return false;
+    }
+
+    const MidiLogHeader *header = reinterpret_cast<const MidiLogHeader *>(file.get_data());
+    if (memcmp(header->magic, MIDI_LOG_MAGIC, sizeof(MIDI_LOG_MAGIC)) != 0 ||
+            header->version != MidiLogWriter::VERSION || header->record_size != sizeof(MidiLogRecord)) {
+        file.close();
+        return false;
+    }
+
+    // A log cut short by a crash has fewer records than the header claims
+    uint64_t stored = (file.get_size() - sizeof(MidiLogHeader)) / sizeof(MidiLogRecord);
+    records = reinterpret_cast<const MidiLogRecord *>(file.get_data() + sizeof(MidiLogHeader));
+    length = std::min(header->count, stored);
+    realtime = p_realtime;
+    position.store(0, std::memory_order_relaxed);
+    quit.store(false, std::memory_order_relaxed);
+    finished.store(false, std::memory_order_release);
+    thread = std::thread(&MidiLogPlayer::run, this);
+    return true;
+}
+
+void MidiLogPlayer::stop() {
+    if (thread.joinable()) {
+        quit.store(true, std::memory_order_release);
+        thread.join();
+    }
+    file.close();
+    records = nullptr;
+    finished.store(true, std::memory_order_release);
+}
+
+bool MidiLogPlayer::is_playing() const {
+    return !finished.load(std::memory_order_acquire);
+}
+
+// Decode the message starting at p_index. Returns the index after it.
+uint64_t MidiLogPlayer::read_event(uint64_t p_index, RtMidiEvent &r_event) {
+    const MidiLogRecord &first = records[p_index];
+    r_event.timeNs = first.time_ns;
+    r_event.deltaTime = 0.0;
+    r_event.source = first.source;
+
+    if (!(first.flags & MidiLogRecord::FLAG_CONTINUES) && first.size <= 3) {
+        r_event.sysex = nullptr;
+        r_event.size = first.size;
+        memcpy(r_event.bytes, first.data, 3);
+        return p_index + 1;
+    }
+
+    // Longer than three bytes: reassemble, truncating past SYSEX_SIZE
+    unsigned int size = 0;
+    uint64_t index = p_index;
+    for (;;) {
+        const MidiLogRecord &record = records[index++];
+        unsigned int chunk = std::min<unsigned int>(record.size, SYSEX_SIZE - size);
+        memcpy(sysex + size, record.data, chunk);
+        size += chunk;
+        if (!(record.flags & MidiLogRecord::FLAG_CONTINUES) || index >= length) {
+            break;
+        }
+    }
+    r_event.sysex = sysex;
+    r_event.size = size;
+    return index;
+}
+
+void MidiLogPlayer::run() {
+    if (length > 0) {
+        uint64_t now = MidiClockGenerator::now_ns();
+        uint64_t first = records[0].time_ns;
+        uint64_t last = records[length - 1].time_ns;
+        // Realtime: the first event goes out now. Otherwise the whole log is
+        // already due, ending now, so nothing waits.
+        uint64_t base = realtime ? now : (now > last - first ? now - (last - first) : 0);
+
+        uint64_t index = 0;
+        unsigned int count = 0;
+        while (index < length && !quit.load(std::memory_order_acquire)) {
+            RtMidiEvent &event = batch[count];
+            uint64_t next = read_event(index, event);
+            event.timeNs = base + (event.timeNs > first ? event.timeNs - first : 0);
+
+            if (realtime && event.timeNs > now) {
+                now = MidiClockGenerator::now_ns();
+                if (event.timeNs > now) {
+                    // Everything due so far goes out in one call
+                    if (count > 0) {
+                        send(batch, count, user_data);
+                        count = 0;
+                        position.store(index, std::memory_order_relaxed);
+                    }
+                    MidiClockGenerator::sleep_until_ns(std::min<uint64_t>(event.timeNs, now + MAX_SLEEP_NS));
+                    now = MidiClockGenerator::now_ns();
+                    continue;
+                }
+            }
+
+            index = next;
+            count++;
+            // SysEx data lives in the shared buffer, so it ends the batch
+            if (count == BATCH_SIZE || event.sysex) {
+                send(batch, count, user_data);
+                count = 0;
+                position.store(index, std::memory_order_relaxed);
+            }
+        }
+        if (count > 0 && !quit.load(std::memory_order_acquire)) {
+            send(batch, count, user_data);
+        }
+        position.store(index, std::memory_order_relaxed);
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+}
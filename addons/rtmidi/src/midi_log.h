@@ -0,0 +1,147 @@
+#ifndef GODOT_MIDI_LOG_H
+#define GODOT_MIDI_LOG_H
+
+#include <RtMidi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace godot {
+
+// Binary MIDI session log: a 64-byte header followed by fixed-width
+// 16-byte records in arrival order. Messages longer than a record (SysEx)
+// continue in the following records. All fields are little-endian.
+struct MidiLogHeader {
+    char magic[8];           // "GDMIDLOG"
+    uint32_t version;
+    uint32_t record_size;    // sizeof(MidiLogRecord)
+    uint64_t capacity;       // Records preallocated
+    uint64_t count;          // Records written
+    uint64_t start_time_ns;  // Monotonic time recording started
+    uint8_t reserved[24];
+};
+
+struct MidiLogRecord {
+    static const int DATA_SIZE = 5;
+    static const uint8_t FLAG_CONTINUES = 1;  // Next record holds more bytes of this message
+
+    uint64_t time_ns;  // Absolute monotonic arrival time
+    uint8_t source;
+    uint8_t size;      // Bytes used in data
+    uint8_t flags;
+    uint8_t data[DATA_SIZE];
+};
+
+static_assert(sizeof(MidiLogHeader) == 64, "MidiLogHeader layout");
+static_assert(sizeof(MidiLogRecord) == 16, "MidiLogRecord layout");
+
+// Memory-mapped file, shared by the writer and reader.
+class MidiLogFile {
+public:
+    ~MidiLogFile();
+
+    // A new log of p_size bytes, allocated on disk and with every page
+    // faulted in writable; p_lock also keeps it resident (mlock)
+    bool create(const std::string &p_path, size_t p_size, bool p_lock = false);
+    bool open_read(const std::string &p_path);
+    // Unmap, and truncate to p_keep bytes if given (writers)
+    void close(size_t p_keep = 0);
+
+    bool is_open() const { return data != nullptr; }
+    bool is_locked() const { return locked; }
+    uint8_t *get_data() const { return data; }
+    size_t get_size() const { return size; }
+
+private:
+    uint8_t *data = nullptr;
+    size_t size = 0;
+    bool writable = false;
+    bool locked = false;
+
+    void prepare_pages(bool p_lock);
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// Appends events to a preallocated log. open() and close() run on the
+// main thread; append() and commit() on the MIDI thread, where they never
+// allocate, block or make a syscall. Once the file is full further events
+// are counted as dropped.
+class MidiLogWriter {
+public:
+    static const uint32_t VERSION = 1;
+
+    bool open(const std::string &p_path, uint64_t p_capacity, uint64_t p_start_time_ns, bool p_lock = false);
+    void close();
+    bool is_open() const { return file.is_open(); }
+    bool is_locked() const { return file.is_locked(); }
+
+    void append(const RtMidiEvent &p_event);
+    // Publish the record count in the header, once per batch
+    void commit();
+
+    uint64_t get_count() const { return count.load(std::memory_order_relaxed); }
+    uint64_t get_dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    MidiLogFile file;
+    MidiLogHeader *header = nullptr;
+    MidiLogRecord *records = nullptr;
+    uint64_t capacity = 0;
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+};
+
+// Feeds a recorded log back through a send callback from its own thread,
+// either with the original spacing or as fast as possible. Event times
+// keep the original spacing in both modes: in realtime mode they are the
+// send deadlines, otherwise they end at the time playback started.
+class MidiLogPlayer {
+public:
+    typedef void (*SendCallback)(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data);
+
+    MidiLogPlayer(SendCallback p_send, void *p_user_data);
+    ~MidiLogPlayer();
+
+    bool start(const std::string &p_path, bool p_realtime);
+    void stop();
+    // Until the whole log has been sent or stop() is called
+    bool is_playing() const;
+    uint64_t get_position() const { return position.load(std::memory_order_relaxed); }
+    uint64_t get_length() const { return length; }
+
+private:
+    static const int BATCH_SIZE = 256;
+    static const int SYSEX_SIZE = 8192;
+    static const uint64_t MAX_SLEEP_NS = 100000000;  // Longest sleep between quit checks
+
+    SendCallback send;
+    void *user_data;
+
+    MidiLogFile file;
+    const MidiLogRecord *records = nullptr;
+    uint64_t length = 0;
+    bool realtime = true;
+
+    std::thread thread;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> finished{ true };
+    std::atomic<uint64_t> position{ 0 };
+
+    // Playback thread only
+    RtMidiEvent batch[BATCH_SIZE];
+    unsigned char sysex[SYSEX_SIZE];
+
+    void run();
+    uint64_t read_event(uint64_t p_index, RtMidiEvent &r_event);
+};
+
+}
+
+#endif // GODOT_MIDI_LOG_H
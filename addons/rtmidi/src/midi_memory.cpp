@@ -0,0 +1,39 @@
+#include "midi_memory.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace godot {
+
+bool midi_lock_memory(const void *p_address, size_t p_size) {
+    if (p_size == 0) {
+        return true;
+    }
+#ifdef _WIN32
+    return VirtualLock(const_cast<void *>(p_address), p_size) != 0;
+#else
+    return mlock(p_address, p_size) == 0;
+#endif
+}
+
+void midi_unlock_memory(const void *p_address, size_t p_size) {
+    if (p_size == 0) {
+        return;
+    }
+#ifdef _WIN32
+    VirtualUnlock(const_cast<void *>(p_address), p_size);
+#else
+    munlock(p_address, p_size);
+#endif
+}
+
+}
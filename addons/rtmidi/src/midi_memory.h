@@ -0,0 +1,17 @@
+#ifndef GODOT_MIDI_MEMORY_H
+#define GODOT_MIDI_MEMORY_H
+
+#include <cstddef>
+
+namespace godot {
+
+// Keep a buffer resident in RAM (mlock / VirtualLock), faulting its pages
+// in now so the MIDI thread never takes a page fault on it later. Returns
+// false if the OS refused, typically because of RLIMIT_MEMLOCK or the
+// process working-set size.
+bool midi_lock_memory(const void *p_address, size_t p_size);
+void midi_unlock_memory(const void *p_address, size_t p_size);
+
+}
+
+#endif // GODOT_MIDI_MEMORY_H
@@ -0,0 +1,195 @@
+#include "midi_param_decoder.h"
+
+using namespace godot;
+
+MidiParamDecoder::MidiParamDecoder() {
+    reset();
+}
+
+void MidiParamDecoder::reset() {
+    for (int i = 0; i < 16; i++) {
+        ChannelState &ch = channels[i];
+        for (int c = 0; c < 32; c++) {
+            ch.cc_msb[c] = 0;
+            ch.cc_time[c] = 0.0;
+        }
+        ch.cc_pending = 0;
+        ch.param_kind = KIND_MIDI;
+        ch.param_msb = 0;
+        ch.param_lsb = 0;
+        ch.data_msb = 0;
+        ch.data_pending = false;
+        ch.data_time = 0.0;
+        ch.data_value = 0;
+    }
+    event_count = 0;
+}
+
+void MidiParamDecoder::set_cc14_pairing(int msb_controller, bool enabled) {
+    if (msb_controller < 0 || msb_controller >= 32) {
+        return;
+    }
+    uint32_t bit = 1u << msb_controller;
+    if (enabled) {
+        cc14_pairs.fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        cc14_pairs.fetch_and(~bit, std::memory_order_relaxed);
+    }
+}
+
+bool MidiParamDecoder::get_cc14_pairing(int msb_controller) const {
+    if (msb_controller < 0 || msb_controller >= 32) {
+        return false;
+    }
+    return cc14_pairs.load(std::memory_order_relaxed) & (1u << msb_controller);
+}
+
+void MidiParamDecoder::emit(uint8_t kind, uint8_t channel, uint16_t param, uint16_t value, double time) {
+    if (event_count >= MAX_EVENTS) {
+        return;
+    }
+    Event &e = events[event_count++];
+    e.kind = kind;
+    e.channel = channel;
+    e.param = param;
+    e.value = value;
+    e.time = time;
+}
+
+void MidiParamDecoder::emit_data(uint8_t channel, ChannelState &ch, uint16_t value, double time) {
+    ch.data_value = value;
+    emit(ch.param_kind, channel, uint16_t((ch.param_msb << 7) | ch.param_lsb), value, time);
+}
+
+void MidiParamDecoder::flush(uint8_t channel, ChannelState &ch, int controller) {
+    uint32_t pending = controller < 0 ? ch.cc_pending : (ch.cc_pending & (1u << controller));
+    for (int c = 0; pending; c++, pending >>= 1) {
+        if (pending & 1) {
+            emit(KIND_CC14, channel, c, uint16_t(ch.cc_msb[c] << 7), ch.cc_time[c]);
+            ch.cc_pending &= ~(1u << c);
+        }
+    }
+
+    if (controller < 0 && ch.data_pending) {
+        ch.data_pending = false;
+        emit_data(channel, ch, uint16_t(ch.data_msb << 7), ch.data_time);
+    }
+}
+
+bool MidiParamDecoder::flush_channel(int channel) {
+    event_count = 0;
+    ChannelState &ch = channels[channel & 0x0F];
+    if (ch.cc_pending || ch.data_pending) {
+        flush(uint8_t(channel & 0x0F), ch, -1);
+    }
+    return event_count > 0;
+}
+
+bool MidiParamDecoder::process(uint8_t status, uint8_t data1, uint8_t data2, double time) {
+    event_count = 0;
+    if (status >= 0xF0) {
+        return false;
+    }
+
+    uint8_t channel = status & 0x0F;
+    ChannelState &ch = channels[channel];
+
+    // Any other channel message ends a held MSB on this channel
+    if ((status & 0xF0) != 0xB0) {
+        if (ch.cc_pending || ch.data_pending) {
+            flush(channel, ch, -1);
+        }
+        return false;
+    }
+
+    uint8_t control = data1 & 0x7F;
+    uint8_t value = data2 & 0x7F;
+
+    if (nrpn_enabled.load(std::memory_order_relaxed)) {
+        switch (control) {
+            case 99:  // NRPN MSB
+            case 98:  // NRPN LSB
+            case 101: // RPN MSB
+            case 100: // RPN LSB
+            {
+                uint8_t kind = (control >= 100) ? KIND_RPN : KIND_NRPN;
+                if (ch.data_pending) {
+                    flush(channel, ch, -1);
+                }
+                if (ch.param_kind != kind) {
+                    ch.param_kind = kind;
+                    ch.param_msb = 0;
+                    ch.param_lsb = 0;
+                }
+                if (control == 99 || control == 101) {
+                    ch.param_msb = value;
+                } else {
+                    ch.param_lsb = value;
+                }
+                ch.data_value = 0;
+                // RPN 127/127 deselects the parameter
+                if (kind == KIND_RPN && ch.param_msb == 0x7F && ch.param_lsb == 0x7F) {
+                    ch.param_kind = KIND_MIDI;
+                }
+                return true;
+            }
+            case 6:  // Data Entry MSB
+                if (ch.param_kind == KIND_MIDI) {
+                    break;
+                }
+                if (ch.data_pending) {
+                    flush(channel, ch, -1);
+                }
+                ch.data_msb = value;
+                if (data_entry_wait_lsb.load(std::memory_order_relaxed)) {
+                    ch.data_pending = true;
+                    ch.data_time = time;
+                } else {
+                    emit_data(channel, ch, uint16_t(value << 7), time);
+                }
+                return true;
+            case 38:  // Data Entry LSB
+                if (ch.param_kind == KIND_MIDI) {
+                    break;
+                }
+                ch.data_pending = false;
+                emit_data(channel, ch, uint16_t((ch.data_msb << 7) | value), time);
+                return true;
+            case 96:  // Data Increment
+            case 97:  // Data Decrement
+            {
+                if (ch.param_kind == KIND_MIDI) {
+                    break;
+                }
+                if (ch.data_pending) {
+                    flush(channel, ch, -1);
+                }
+                int next = ch.data_value + (control == 96 ? 1 : -1);
+                next = next < 0 ? 0 : (next > PARAM_NULL ? PARAM_NULL : next);
+                emit_data(channel, ch, uint16_t(next), time);
+                return true;
+            }
+            default:
+                break;
+        }
+    }
+
+    uint32_t pairs = cc14_pairs.load(std::memory_order_relaxed);
+    if (control < 32 && (pairs & (1u << control))) {
+        // A second MSB before the LSB: the first one stands on its own
+        flush(channel, ch, control);
+        ch.cc_msb[control] = value;
+        ch.cc_time[control] = time;
+        ch.cc_pending |= 1u << control;
+        return true;
+    }
+
+    if (control >= 32 && control < 64 && (pairs & (1u << (control - 32)))) {
+        uint8_t msb_controller = control - 32;
+        ch.cc_pending &= ~(1u << msb_controller);
+        emit(KIND_CC14, channel, msb_controller, uint16_t((ch.cc_msb[msb_controller] << 7) | value), time);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,103 @@
+#ifndef GODOT_MIDI_PARAM_DECODER_H
+#define GODOT_MIDI_PARAM_DECODER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace godot {
+
+// Merges multi-message controller sequences into single 14-bit events:
+//
+// - 14-bit CC: MSB on controller 0-31 followed by LSB on controller + 32.
+//   Pairing is enabled per MSB controller. The MSB is held until its LSB
+//   arrives; if a non-controller message on the same channel or a second
+//   MSB for that controller comes first, the held MSB is flushed on its
+//   own (LSB = 0, as the spec prescribes).
+//   An LSB without a preceding MSB reuses the last MSB.
+// - NRPN (CC 99/98) and RPN (CC 101/100) parameter selection followed by
+//   Data Entry (CC 6/38) or Data Increment/Decrement (CC 96/97). Data
+//   Entry MSB is either held for its LSB or emitted immediately.
+//
+// An LSB is only waited for within one driver batch: flush_channel() at
+// the end of the batch emits whatever is still held, since many devices
+// never send it (Data Entry MSB alone for the pitch bend range). A late
+// LSB then refines the value with a second event.
+//
+// Runs on the MIDI thread. Configuration setters may be called from any
+// thread.
+class MidiParamDecoder {
+public:
+    enum Kind : uint8_t {
+        KIND_MIDI = 0,  // Plain MIDI message, not produced by the decoder
+        KIND_CC14 = 1,
+        KIND_NRPN = 2,
+        KIND_RPN = 3,
+    };
+
+    struct Event {
+        uint8_t kind;
+        uint8_t channel;
+        uint16_t param;  // MSB controller for KIND_CC14, parameter number otherwise
+        uint16_t value;  // 14-bit value
+        double time;     // Of the message that carried the value: the LSB, or a flushed MSB
+    };
+
+    // Upper bound on the events a single process() or flush_channel() call
+    // can produce
+    static const int MAX_EVENTS = 34;
+
+    MidiParamDecoder();
+
+    // Feed a channel message and its arrival time. Returns true if the
+    // message was consumed (it must not be forwarded as-is). Completed
+    // events are available via get_events() until the next call, and
+    // precede the message itself.
+    bool process(uint8_t status, uint8_t data1, uint8_t data2, double time);
+    // End of a driver batch: emit the MSBs still held on a channel through
+    // get_events(). Returns false if there were none.
+    bool flush_channel(int channel);
+    const Event *get_events() const { return events; }
+    int get_event_count() const { return event_count; }
+    void reset();
+
+    void set_cc14_pairing(int msb_controller, bool enabled);
+    bool get_cc14_pairing(int msb_controller) const;
+    void set_nrpn_enabled(bool enabled) { nrpn_enabled.store(enabled, std::memory_order_relaxed); }
+    bool is_nrpn_enabled() const { return nrpn_enabled.load(std::memory_order_relaxed); }
+    void set_data_entry_waits_for_lsb(bool wait) { data_entry_wait_lsb.store(wait, std::memory_order_relaxed); }
+    bool get_data_entry_waits_for_lsb() const { return data_entry_wait_lsb.load(std::memory_order_relaxed); }
+
+private:
+    static const uint16_t PARAM_NULL = 0x3FFF;
+
+    struct ChannelState {
+        uint8_t cc_msb[32];        // Last MSB per paired controller
+        uint32_t cc_pending;       // Controllers whose MSB awaits its LSB
+        double cc_time[32];        // Arrival of each held MSB
+        uint8_t param_kind;        // KIND_NRPN, KIND_RPN or KIND_MIDI (none)
+        uint8_t param_msb;
+        uint8_t param_lsb;
+        uint8_t data_msb;
+        bool data_pending;         // Data Entry MSB awaits its LSB
+        double data_time;
+        uint16_t data_value;       // Last value sent for the selected parameter
+    };
+
+    ChannelState channels[16];
+    Event events[MAX_EVENTS];
+    int event_count = 0;
+
+    std::atomic<uint32_t> cc14_pairs{ 0 };
+    std::atomic<bool> nrpn_enabled{ true };
+    std::atomic<bool> data_entry_wait_lsb{ true };
+
+    void emit(uint8_t kind, uint8_t channel, uint16_t param, uint16_t value, double time);
+    void emit_data(uint8_t channel, ChannelState &ch, uint16_t value, double time);
+    // Emit held MSBs: only `controller`'s, or all of them (including Data
+    // Entry) when controller < 0
+    void flush(uint8_t channel, ChannelState &ch, int controller);
+};
+
+}
+
+#endif // GODOT_MIDI_PARAM_DECODER_H
@@ -0,0 +1,216 @@
+#ifndef GODOT_MIDI_RING_H
+#define GODOT_MIDI_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace godot {
+
+// Bounded single-producer/single-consumer ring buffer.
+//
+// The producer (the MIDI input thread) never blocks and never allocates:
+// push() and push_batch() are wait-free, and the overwrite variants make
+// room by advancing the consumer index past the oldest entries. Batches are
+// published and taken (push_batch(), pop_batch()) with a single index
+// update. The consumer side is lock-free and only retries when the producer
+// overwrote a slot it was reading.
+//
+// Indices are free-running 64-bit counters; the slot is index & mask.
+// T must be trivially copyable.
+template <typename T>
+class MidiRing {
+public:
+    MidiRing() { reset(1); }
+
+    explicit MidiRing(size_t p_capacity) { reset(p_capacity); }
+
+    // Resize and clear. Only call while neither side is running.
+    void reset(size_t p_capacity) {
+        size_t capacity = 1;
+        while (capacity < p_capacity) {
+            capacity <<= 1;
+        }
+        slots.assign(capacity, T());
+        mask = capacity - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        producer_head_cache = 0;
+        consumer_tail_cache = 0;
+    }
+
+    // Drop all pending entries. Only call while the producer is stopped.
+    void clear() {
+        uint64_t t = tail.load(std::memory_order_acquire);
+        head.store(t, std::memory_order_release);
+        producer_head_cache = t;
+        consumer_tail_cache = t;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Slot storage, e.g. to lock it in memory. Moves on reset().
+    const void *storage() const { return slots.data(); }
+    size_t storage_size() const { return slots.size() * sizeof(T); }
+
+    // Approximate number of pending entries.
+    size_t size() const {
+        uint64_t t = tail.load(std::memory_order_acquire);
+        uint64_t h = head.load(std::memory_order_acquire);
+        return t > h ? size_t(t - h) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Index the next pushed entry will get (producer), and index of the
+    // oldest entry not yet consumed or discarded. An entry at index i is
+    // still pending while read_index() <= i.
+    uint64_t write_index() const { return tail.load(std::memory_order_relaxed); }
+    uint64_t read_index() const { return head.load(std::memory_order_acquire); }
+
+    // Producer: append, or return false if the ring is full.
+    bool push(const T &p_value) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - producer_head_cache > mask) {
+            producer_head_cache = head.load(std::memory_order_acquire);
+            if (t - producer_head_cache > mask) {
+                return false;
+            }
+        }
+        slots[t & mask] = p_value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: append, discarding the oldest entry if the ring is full.
+    // Returns true if an entry was discarded.
+    bool push_overwrite(const T &p_value) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        bool dropped = false;
+        uint64_t h = head.load(std::memory_order_acquire);
+        if (t - h > mask) {
+            // If the CAS fails the consumer just freed a slot for us.
+            dropped = head.compare_exchange_strong(h, h + 1, std::memory_order_acq_rel);
+        }
+        slots[t & mask] = p_value;
+        tail.store(t + 1, std::memory_order_release);
+        return dropped;
+    }
+
+    // Producer: append as many of p_values as fit and publish them with a
+    // single index update. Returns how many were appended.
+    size_t push_batch(const T *p_values, size_t p_count) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        // The cached head may lag by more than a ring after overwrites
+        uint64_t used = t - producer_head_cache;
+        if (used > capacity() || capacity() - used < p_count) {
+            producer_head_cache = head.load(std::memory_order_acquire);
+            used = t - producer_head_cache;
+        }
+        size_t free_slots = capacity() - size_t(used);
+        size_t n = p_count < free_slots ? p_count : free_slots;
+        for (size_t i = 0; i < n; i++) {
+            slots[(t + i) & mask] = p_values[i];
+        }
+        if (n > 0) {
+            tail.store(t + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // Producer: append all of p_values, discarding the oldest entries to
+    // make room, and publish with a single index update. Returns how many
+    // entries were discarded (including any of p_values themselves when
+    // the batch is larger than the ring).
+    size_t push_batch_overwrite(const T *p_values, size_t p_count) {
+        size_t dropped = 0;
+        if (p_count > capacity()) {
+            dropped = p_count - capacity();
+            p_values += dropped;
+            p_count = capacity();
+        }
+        if (p_count == 0) {
+            return dropped;
+        }
+
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t new_head = t + p_count - capacity();
+        uint64_t h = head.load(std::memory_order_acquire);
+        // Advance the consumer past everything we are about to overwrite;
+        // a failed CAS means the consumer moved, so re-check.
+        while (t + p_count - h > capacity()) {
+            if (head.compare_exchange_weak(h, new_head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                dropped += size_t(new_head - h);
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < p_count; i++) {
+            slots[(t + i) & mask] = p_values[i];
+        }
+        tail.store(t + p_count, std::memory_order_release);
+        return dropped;
+    }
+
+    // Consumer: take the oldest entry, or return false if the ring is empty.
+    bool pop(T &r_value) {
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (;;) {
+            if (consumer_tail_cache <= h) {
+                consumer_tail_cache = tail.load(std::memory_order_acquire);
+                if (consumer_tail_cache <= h) {
+                    return false;
+                }
+            }
+            r_value = slots[h & mask];
+            // Fails only if push_overwrite() discarded this entry meanwhile.
+            if (head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+
+    // Consumer: take up to p_max of the oldest entries, in order, with a
+    // single index update. Returns how many were taken. Retries only if
+    // an overwrite discarded entries while they were being copied.
+    size_t pop_batch(T *r_values, size_t p_max) {
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (;;) {
+            consumer_tail_cache = tail.load(std::memory_order_acquire);
+            if (consumer_tail_cache <= h || p_max == 0) {
+                return 0;
+            }
+            size_t n = size_t(consumer_tail_cache - h);
+            if (n > p_max) {
+                n = p_max;
+            }
+            for (size_t i = 0; i < n; i++) {
+                r_values[i] = slots[(h + i) & mask];
+            }
+            if (head.compare_exchange_weak(h, h + n, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return n;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    // Consumer-owned index, written by the producer only when overwriting.
+    std::atomic<uint64_t> head{ 0 };
+    uint64_t consumer_tail_cache = 0;
+    char head_pad[CACHE_LINE - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+
+    // Producer-owned index.
+    std::atomic<uint64_t> tail{ 0 };
+    uint64_t producer_head_cache = 0;
+    char tail_pad[CACHE_LINE - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+};
+
+}
+
+#endif // GODOT_MIDI_RING_H
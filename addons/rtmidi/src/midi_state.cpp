@@ -0,0 +1,89 @@
+#include "midi_state.h"
+
+using namespace godot;
+
+MidiState::MidiState() {
+    for (int i = 0; i < SLOTS; i++) {
+        ccs[i].store(0, std::memory_order_relaxed);
+        notes[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < PARAM_SLOTS; i++) {
+        param_keys[i].store(0, std::memory_order_relaxed);
+        param_values[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// The entry carrying a sequence number is stored before the number is
+// published, so a reader that sees get_sequence() == N also sees every
+// entry up to N and can use N as its get_changed_ccs() cursor
+uint64_t MidiState::next_sequence() const {
+    // Single writer, so the load can't race with another increment
+    return sequence.load(std::memory_order_relaxed) + 1;
+}
+
+void MidiState::publish_sequence(uint64_t seq) {
+    sequence.store(seq, std::memory_order_release);
+}
+
+void MidiState::set_cc(int channel, int control, uint32_t value14) {
+    uint64_t seq = next_sequence();
+    ccs[slot(channel, control)].store((seq << 16) | (value14 & MAX_VALUE), std::memory_order_release);
+    publish_sequence(seq);
+}
+
+void MidiState::set_note(int channel, int note, uint32_t velocity7) {
+    uint64_t seq = next_sequence();
+    notes[slot(channel, note)].store((seq << 16) | scale7(velocity7 & 0x7F), std::memory_order_release);
+    publish_sequence(seq);
+}
+
+void MidiState::set_param(bool registered, int channel, int param, uint32_t value14) {
+    uint32_t key = param_key(registered, channel, param);
+    uint32_t index = param_hash(key);
+    for (int probe = 0; probe < PARAM_SLOTS; probe++, index = (index + 1) & (PARAM_SLOTS - 1)) {
+        uint32_t existing = param_keys[index].load(std::memory_order_relaxed);
+        if (existing != key && existing != 0) {
+            continue;
+        }
+
+        uint64_t seq = next_sequence();
+        param_values[index].store((seq << 16) | (value14 & MAX_VALUE), std::memory_order_release);
+        if (existing == 0) {
+            // Publish the key only once its value is in place
+            param_keys[index].store(key, std::memory_order_release);
+        }
+        publish_sequence(seq);
+        return;
+    }
+}
+
+int32_t MidiState::get_param(bool registered, int channel, int param) const {
+    uint32_t key = param_key(registered, channel, param);
+    uint32_t index = param_hash(key);
+    for (int probe = 0; probe < PARAM_SLOTS; probe++, index = (index + 1) & (PARAM_SLOTS - 1)) {
+        uint32_t existing = param_keys[index].load(std::memory_order_acquire);
+        if (existing == 0) {
+            return -1;
+        }
+        if (existing == key) {
+            return int32_t(unpack_value(param_values[index].load(std::memory_order_acquire)));
+        }
+    }
+    return -1;
+}
+
+void MidiState::clear_notes() {
+    for (int i = 0; i < SLOTS; i++) {
+        notes[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+int MidiState::get_changed_ccs(uint64_t since_seq, int32_t *r_slots, int max_slots) const {
+    int count = 0;
+    for (int i = 0; i < SLOTS && count < max_slots; i++) {
+        if ((ccs[i].load(std::memory_order_acquire) >> 16) > since_seq) {
+            r_slots[count++] = i;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,74 @@
+#ifndef GODOT_MIDI_STATE_H
+#define GODOT_MIDI_STATE_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace godot {
+
+// Latest value of every controller and note on all 16 channels.
+//
+// Written by the MIDI thread, readable from any thread without locking.
+// Each entry packs a 14-bit value with the global change sequence number
+// at which it was last written (seq << 16 | value), so a single relaxed
+// load yields a consistent pair. 7-bit values are stored scaled to 14 bits
+// (v << 7 | v), which keeps value / 16383.0 equal to v / 127.0.
+class MidiState {
+public:
+    static const int CHANNELS = 16;
+    static const int SLOTS = CHANNELS * 128;
+    static const uint32_t MAX_VALUE = 16383;
+
+    MidiState();
+
+    // MIDI thread
+    void set_cc(int channel, int control, uint32_t value14);
+    void set_note(int channel, int note, uint32_t velocity7);
+    void clear_notes();
+    // NRPN (registered = false) or RPN parameter value. Parameters are kept
+    // in a fixed open-addressed table; once it is full new ones are dropped.
+    void set_param(bool registered, int channel, int param, uint32_t value14);
+
+    // Any thread
+    uint64_t get_sequence() const { return sequence.load(std::memory_order_acquire); }
+    uint32_t get_cc(int channel, int control) const { return unpack_value(ccs[slot(channel, control)].load(std::memory_order_relaxed)); }
+    uint32_t get_note(int channel, int note) const { return unpack_value(notes[slot(channel, note)].load(std::memory_order_relaxed)); }
+    uint64_t get_cc_sequence(int channel, int control) const { return ccs[slot(channel, control)].load(std::memory_order_relaxed) >> 16; }
+    // Returns -1 if the parameter has never been received
+    int32_t get_param(bool registered, int channel, int param) const;
+
+    // Fill r_slots with channel * 128 + control for every CC written after
+    // since_seq; returns how many were written (at most max_slots). Every
+    // CC up to get_sequence() read beforehand is visible, so that value is
+    // the next call's since_seq; entries written meanwhile may show twice.
+    int get_changed_ccs(uint64_t since_seq, int32_t *r_slots, int max_slots) const;
+
+    static uint32_t scale7(uint32_t value7) { return (value7 << 7) | value7; }
+
+private:
+    static int slot(int channel, int index) { return ((channel & 0x0F) << 7) | (index & 0x7F); }
+    static uint32_t unpack_value(uint64_t packed) { return uint32_t(packed & 0xFFFF); }
+
+    // Non-zero key: 1 << 31 | registered << 18 | channel << 14 | param
+    static uint32_t param_key(bool registered, int channel, int param) {
+        return 0x80000000u | (registered ? 1u << 18 : 0u) | (uint32_t(channel & 0x0F) << 14) | uint32_t(param & 0x3FFF);
+    }
+    static uint32_t param_hash(uint32_t key) { return (key * 2654435761u) >> (32 - PARAM_BITS); }
+
+    uint64_t next_sequence() const;
+    void publish_sequence(uint64_t seq);
+
+    std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<uint64_t> ccs[SLOTS];
+    std::atomic<uint64_t> notes[SLOTS];
+
+    static const int PARAM_BITS = 8;
+    static const int PARAM_SLOTS = 1 << PARAM_BITS;
+    // Keys are written once (after their value) and never removed
+    std::atomic<uint32_t> param_keys[PARAM_SLOTS];
+    std::atomic<uint64_t> param_values[PARAM_SLOTS];
+};
+
+}
+
+#endif // GODOT_MIDI_STATE_H
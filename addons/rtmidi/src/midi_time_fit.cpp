@@ -0,0 +1,74 @@
+#include "midi_time_fit.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godot;
+
+void MidiTimeFit::set_window(int p_samples) {
+    window = std::clamp(p_samples, 2, int(MAX_WINDOW));
+    reset();
+}
+
+void MidiTimeFit::reset() {
+    count = 0;
+    next = 0;
+    mean_reference = 0.0;
+    mean_time = 0.0;
+    rate = 1.0;
+    residual = 0.0;
+}
+
+void MidiTimeFit::add_sample(double p_reference, double p_time, double p_max_error) {
+    if (count > 0 && std::abs(to_time(p_reference) - p_time) > p_max_error) {
+        reset();
+    }
+
+    references[next] = p_reference;
+    times[next] = p_time;
+    next = (next + 1) % window;
+    count = std::min(count + 1, window);
+    solve();
+}
+
+double MidiTimeFit::to_time(double p_reference) const {
+    return mean_time + rate * (p_reference - mean_reference);
+}
+
+double MidiTimeFit::to_reference(double p_time) const {
+    return mean_reference + (p_time - mean_time) / rate;
+}
+
+void MidiTimeFit::solve() {
+    // Summed relative to one sample, so large absolute times don't eat
+    // the precision of the sums
+    double sum_reference = 0.0;
+    double sum_time = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum_reference += references[i] - references[0];
+        sum_time += times[i] - times[0];
+    }
+    mean_reference = references[0] + sum_reference / count;
+    mean_time = times[0] + sum_time / count;
+
+    double covariance = 0.0;
+    double variance = 0.0;
+    for (int i = 0; i < count; i++) {
+        double dr = references[i] - mean_reference;
+        covariance += dr * (times[i] - mean_time);
+        variance += dr * dr;
+    }
+    // Too few or too close together to tell a rate: assume the clocks run
+    // at the same speed
+    rate = variance > 1e-12 ? covariance / variance : 1.0;
+    if (!(rate > 0.5 && rate < 2.0)) {
+        rate = 1.0;
+    }
+
+    double error_sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        double error = times[i] - to_time(references[i]);
+        error_sum += error * error;
+    }
+    residual = std::sqrt(error_sum / count);
+}
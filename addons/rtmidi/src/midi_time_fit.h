@@ -0,0 +1,50 @@
+#ifndef GODOT_MIDI_TIME_FIT_H
+#define GODOT_MIDI_TIME_FIT_H
+
+namespace godot {
+
+// Least-squares line relating one clock to the monotonic reference clock
+// over its most recent samples: time = mean_time + rate * (reference -
+// mean_reference). Samples are centered on their means before solving, so
+// seconds-since-boot values keep sub-microsecond precision in doubles.
+// With no samples the fit is the identity.
+class MidiTimeFit {
+public:
+    static const int MAX_WINDOW = 256;
+    static const int DEFAULT_WINDOW = 120;  // About two seconds at one sample per frame
+
+    void set_window(int p_samples);
+    int get_window() const { return window; }
+    void reset();
+
+    // A sample further than p_max_error from the current fit means the
+    // clock jumped (an audio stream restarted, a port was reopened), so the
+    // fit starts over from it
+    void add_sample(double p_reference, double p_time, double p_max_error);
+    int get_sample_count() const { return count; }
+
+    double to_time(double p_reference) const;
+    double to_reference(double p_time) const;
+    // Clock seconds per reference second
+    double get_rate() const { return rate; }
+    // RMS distance of the samples from the line, seconds
+    double get_residual() const { return residual; }
+
+private:
+    double references[MAX_WINDOW];
+    double times[MAX_WINDOW];
+    int window = DEFAULT_WINDOW;
+    int count = 0;
+    int next = 0;
+
+    double mean_reference = 0.0;
+    double mean_time = 0.0;
+    double rate = 1.0;
+    double residual = 0.0;
+
+    void solve();
+};
+
+}
+
+#endif // GODOT_MIDI_TIME_FIT_H
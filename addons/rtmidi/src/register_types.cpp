@@ -1,24 +1,44 @@
 #include "register_types.h"
+#include "rtmidi_hub.h"
 #include "rtmidi_in.h"
+#include "rtmidi_out.h"
+#include "rtmidi_subscriber.h"
+#include "rtmidi_time_map.h"
 
 #include <gdextension_interface.h>
+#include <godot_cpp/classes/engine.hpp>
 #include <godot_cpp/core/defs.hpp>
 #include <godot_cpp/godot.hpp>
 
 using namespace godot;
 
+static GodotRtMidiHub *rtmidi_hub = nullptr;
+
 void initialize_rtmidi_module(ModuleInitializationLevel p_level) {
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
         return;
     }
 
     ClassDB::register_class<GodotRtMidiIn>();
+    ClassDB::register_class<GodotRtMidiOut>();
+    ClassDB::register_class<GodotRtMidiSubscriber>();
+    ClassDB::register_class<GodotRtMidiHub>();
+    ClassDB::register_class<GodotRtMidiTimeMap>();
+
+    rtmidi_hub = memnew(GodotRtMidiHub);
+    Engine::get_singleton()->register_singleton("RtMidiHub", rtmidi_hub);
 }
 
 void uninitialize_rtmidi_module(ModuleInitializationLevel p_level) {
     if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
         return;
     }
+
+    if (rtmidi_hub) {
+        Engine::get_singleton()->unregister_singleton("RtMidiHub");
+        memdelete(rtmidi_hub);
+        rtmidi_hub = nullptr;
+    }
 }
 
 extern "C" {
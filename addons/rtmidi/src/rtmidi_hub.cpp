@@ -0,0 +1,96 @@
+#include "rtmidi_hub.h"
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/class_db.hpp>
+
+using namespace godot;
+
+GodotRtMidiHub *GodotRtMidiHub::singleton = nullptr;
+
+// MSB controllers (0-31) whose LSB is merged into one 14-bit event
+const char *GodotRtMidiHub::SETTING_HIGH_RESOLUTION_CCS = "rtmidi/hub/high_resolution_ccs";
+// FIFO priority of the input thread, 1-99; 0 keeps normal scheduling
+const char *GodotRtMidiHub::SETTING_REALTIME_PRIORITY = "rtmidi/hub/realtime_priority";
+
+void GodotRtMidiHub::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_input"), &GodotRtMidiHub::get_input);
+    ClassDB::bind_method(D_METHOD("subscribe"), &GodotRtMidiHub::subscribe);
+}
+
+GodotRtMidiHub *GodotRtMidiHub::get_singleton() {
+    return singleton;
+}
+
+GodotRtMidiHub::GodotRtMidiHub() {
+    singleton = this;
+    define_settings();
+}
+
+GodotRtMidiHub::~GodotRtMidiHub() {
+    if (input.is_valid()) {
+        input->close_port();
+        input.unref();
+    }
+    singleton = nullptr;
+}
+
+void GodotRtMidiHub::define_settings() {
+    ProjectSettings *settings = ProjectSettings::get_singleton();
+    if (!settings) return;
+
+    struct Setting {
+        const char *name;
+        Variant value;
+        Variant::Type type;
+        PropertyHint hint;
+        const char *hint_string;
+    };
+    const Setting defined[] = {
+        { SETTING_HIGH_RESOLUTION_CCS, PackedInt32Array(), Variant::PACKED_INT32_ARRAY, PROPERTY_HINT_NONE, "" },
+        { SETTING_REALTIME_PRIORITY, 0, Variant::INT, PROPERTY_HINT_RANGE, "0,99" },
+    };
+    for (const Setting &setting : defined) {
+        if (!settings->has_setting(setting.name)) {
+            settings->set_setting(setting.name, setting.value);
+        }
+        settings->set_initial_value(setting.name, setting.value);
+        Dictionary info;
+        info["name"] = setting.name;
+        info["type"] = setting.type;
+        info["hint"] = setting.hint;
+        info["hint_string"] = setting.hint_string;
+        settings->add_property_info(info);
+    }
+}
+
+void GodotRtMidiHub::ensure_input() {
+    if (input.is_valid()) return;
+
+    ring = std::make_shared<GodotRtMidiIn::Broadcast>(BROADCAST_CAPACITY);
+    input.instantiate();
+    input->set_broadcast(ring);
+
+    ProjectSettings *settings = ProjectSettings::get_singleton();
+    if (!settings) return;
+    PackedInt32Array controls = settings->get_setting(SETTING_HIGH_RESOLUTION_CCS, PackedInt32Array());
+    for (int i = 0; i < controls.size(); i++) {
+        input->set_cc14_pairing(controls[i], true);
+    }
+    int priority = settings->get_setting(SETTING_REALTIME_PRIORITY, 0);
+    if (priority > 0) {
+        input->set_thread_priority(GodotRtMidiIn::THREAD_FIFO, priority);
+        input->set_memory_locked(true);
+    }
+}
+
+Ref<GodotRtMidiIn> GodotRtMidiHub::get_input() {
+    ensure_input();
+    return input;
+}
+
+Ref<GodotRtMidiSubscriber> GodotRtMidiHub::subscribe() {
+    ensure_input();
+    Ref<GodotRtMidiSubscriber> subscriber;
+    subscriber.instantiate();
+    subscriber->attach(ring);
+    return subscriber;
+}
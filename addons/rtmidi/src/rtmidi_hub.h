@@ -0,0 +1,57 @@
+#ifndef GODOT_RTMIDI_HUB_H
+#define GODOT_RTMIDI_HUB_H
+
+#include <godot_cpp/classes/object.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include "rtmidi_in.h"
+#include "rtmidi_subscriber.h"
+#include <memory>
+
+namespace godot {
+
+// Engine singleton ("RtMidiHub") that owns the MIDI device connections for
+// the whole process. Scenes subscribe instead of creating their own
+// GodotRtMidiIn, so they share one sequencer client, one input thread and
+// one clock tracker, and each reads the shared broadcast ring at its own
+// pace. Settings of the shared device (14-bit CC pairing, thread priority)
+// come from the rtmidi/hub/* project settings, so no scene changes them
+// for the others.
+class GodotRtMidiHub : public Object {
+    GDCLASS(GodotRtMidiHub, Object)
+
+public:
+    static const int BROADCAST_CAPACITY = 8192;
+
+    static const char *SETTING_HIGH_RESOLUTION_CCS;
+    static const char *SETTING_REALTIME_PRIORITY;
+
+private:
+    static GodotRtMidiHub *singleton;
+
+    // Created on first use so projects that never touch MIDI don't open a
+    // sequencer client
+    Ref<GodotRtMidiIn> input;
+    std::shared_ptr<GodotRtMidiIn::Broadcast> ring;
+
+    static void define_settings();
+    void ensure_input();
+
+protected:
+    static void _bind_methods();
+
+public:
+    static GodotRtMidiHub *get_singleton();
+
+    GodotRtMidiHub();
+    ~GodotRtMidiHub();
+
+    // The shared input: ports, sources, filters, clock and state. Its own
+    // poll_message()/drain_messages() stay empty; read through a subscriber.
+    Ref<GodotRtMidiIn> get_input();
+    // A new reader that sees every message published from now on
+    Ref<GodotRtMidiSubscriber> subscribe();
+};
+
+}
+
+#endif // GODOT_RTMIDI_HUB_H
@@ -1,64 +1,620 @@
 #include "rtmidi_in.h"
+#include "midi_memory.h"
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
 
 using namespace godot;
 
+// Plain 7-bit CC: the only kind the coalescing tables can hold
+static bool is_plain_cc(const GodotRtMidiIn::MidiMessage &m) {
+    return (m.status & 0xF0) == 0xB0 && m.kind == GodotRtMidiIn::MESSAGE_MIDI;
+}
+
 void GodotRtMidiIn::_bind_methods() {
     // Device management
     ClassDB::bind_method(D_METHOD("get_port_names"), &GodotRtMidiIn::get_port_names);
     ClassDB::bind_method(D_METHOD("get_port_count"), &GodotRtMidiIn::get_port_count);
+    ClassDB::bind_method(D_METHOD("get_ports"), &GodotRtMidiIn::get_ports);
     ClassDB::bind_method(D_METHOD("open_port", "port_number"), &GodotRtMidiIn::open_port);
+    ClassDB::bind_method(D_METHOD("open_port_address", "client", "port"), &GodotRtMidiIn::open_port_address);
     ClassDB::bind_method(D_METHOD("open_virtual_port", "name"), &GodotRtMidiIn::open_virtual_port);
     ClassDB::bind_method(D_METHOD("close_port"), &GodotRtMidiIn::close_port);
     ClassDB::bind_method(D_METHOD("is_port_open"), &GodotRtMidiIn::is_port_open);
+    ClassDB::bind_method(D_METHOD("set_api", "name"), &GodotRtMidiIn::set_api);
+    ClassDB::bind_method(D_METHOD("get_api"), &GodotRtMidiIn::get_api);
+
+    // Multiple sources
+    ClassDB::bind_method(D_METHOD("add_source", "port_number"), &GodotRtMidiIn::add_source);
+    ClassDB::bind_method(D_METHOD("add_source_address", "client", "port"), &GodotRtMidiIn::add_source_address);
+    ClassDB::bind_method(D_METHOD("remove_source", "source"), &GodotRtMidiIn::remove_source);
+    ClassDB::bind_method(D_METHOD("get_sources"), &GodotRtMidiIn::get_sources);
+
+    BIND_ENUM_CONSTANT(MAX_SOURCES);
+    BIND_ENUM_CONSTANT(SOURCE_UNKNOWN);
+
+    // Hotplug
+    ClassDB::bind_method(D_METHOD("set_auto_reconnect", "enabled"), &GodotRtMidiIn::set_auto_reconnect);
+    ClassDB::bind_method(D_METHOD("get_auto_reconnect"), &GodotRtMidiIn::get_auto_reconnect);
+    ClassDB::bind_method(D_METHOD("get_open_port_name"), &GodotRtMidiIn::get_open_port_name);
+    ClassDB::bind_method(D_METHOD("_flush_port_events"), &GodotRtMidiIn::_flush_port_events);
+
+    ADD_SIGNAL(MethodInfo("ports_changed"));
+    ADD_SIGNAL(MethodInfo("port_added", PropertyInfo(Variant::STRING, "name"), PropertyInfo(Variant::INT, "client"), PropertyInfo(Variant::INT, "port")));
+    ADD_SIGNAL(MethodInfo("port_removed", PropertyInfo(Variant::STRING, "name"), PropertyInfo(Variant::INT, "client"), PropertyInfo(Variant::INT, "port")));
+
+    BIND_ENUM_CONSTANT(PORT_INPUT);
+    BIND_ENUM_CONSTANT(PORT_OUTPUT);
+    BIND_ENUM_CONSTANT(PORT_HARDWARE);
+    BIND_ENUM_CONSTANT(PORT_SOFTWARE);
 
     // Message filtering
     ClassDB::bind_method(D_METHOD("ignore_types", "sysex", "timing", "active_sense"), &GodotRtMidiIn::ignore_types);
+    ClassDB::bind_method(D_METHOD("set_message_filter", "types", "channel_mask", "note_low", "note_high"), &GodotRtMidiIn::set_message_filter, DEFVAL(0xFFFF), DEFVAL(0), DEFVAL(127));
+    ClassDB::bind_method(D_METHOD("get_message_filter"), &GodotRtMidiIn::get_message_filter);
+    ClassDB::bind_method(D_METHOD("set_clock_while_stopped", "enabled"), &GodotRtMidiIn::set_clock_while_stopped);
+    ClassDB::bind_method(D_METHOD("get_clock_while_stopped"), &GodotRtMidiIn::get_clock_while_stopped);
+
+    BIND_ENUM_CONSTANT(FILTER_NOTE_OFF);
+    BIND_ENUM_CONSTANT(FILTER_NOTE_ON);
+    BIND_ENUM_CONSTANT(FILTER_POLY_PRESSURE);
+    BIND_ENUM_CONSTANT(FILTER_CONTROL_CHANGE);
+    BIND_ENUM_CONSTANT(FILTER_PROGRAM_CHANGE);
+    BIND_ENUM_CONSTANT(FILTER_CHANNEL_PRESSURE);
+    BIND_ENUM_CONSTANT(FILTER_PITCH_BEND);
+    BIND_ENUM_CONSTANT(FILTER_SYSEX);
+    BIND_ENUM_CONSTANT(FILTER_TIME_CODE);
+    BIND_ENUM_CONSTANT(FILTER_SONG_POSITION);
+    BIND_ENUM_CONSTANT(FILTER_SONG_SELECT);
+    BIND_ENUM_CONSTANT(FILTER_TUNE_REQUEST);
+    BIND_ENUM_CONSTANT(FILTER_CLOCK);
+    BIND_ENUM_CONSTANT(FILTER_TICK);
+    BIND_ENUM_CONSTANT(FILTER_START);
+    BIND_ENUM_CONSTANT(FILTER_CONTINUE);
+    BIND_ENUM_CONSTANT(FILTER_STOP);
+    BIND_ENUM_CONSTANT(FILTER_ACTIVE_SENSING);
+    BIND_ENUM_CONSTANT(FILTER_RESET);
+    BIND_ENUM_CONSTANT(FILTER_ALL);
+
+    // Realtime thread and memory
+    ClassDB::bind_method(D_METHOD("set_thread_priority", "policy", "priority"), &GodotRtMidiIn::set_thread_priority);
+    ClassDB::bind_method(D_METHOD("set_thread_affinity", "cpus"), &GodotRtMidiIn::set_thread_affinity);
+    ClassDB::bind_method(D_METHOD("set_memory_locked", "locked"), &GodotRtMidiIn::set_memory_locked);
+    ClassDB::bind_method(D_METHOD("is_memory_locked"), &GodotRtMidiIn::is_memory_locked);
+    ClassDB::bind_method(D_METHOD("get_realtime_status"), &GodotRtMidiIn::get_realtime_status);
+
+    BIND_ENUM_CONSTANT(THREAD_NORMAL);
+    BIND_ENUM_CONSTANT(THREAD_FIFO);
+    BIND_ENUM_CONSTANT(THREAD_ROUND_ROBIN);
+
+    // Session recording
+    ClassDB::bind_method(D_METHOD("start_recording", "path", "max_records"), &GodotRtMidiIn::start_recording, DEFVAL(1 << 20));
+    ClassDB::bind_method(D_METHOD("stop_recording"), &GodotRtMidiIn::stop_recording);
+    ClassDB::bind_method(D_METHOD("is_recording"), &GodotRtMidiIn::is_recording);
+    ClassDB::bind_method(D_METHOD("get_recorded_count"), &GodotRtMidiIn::get_recorded_count);
+    ClassDB::bind_method(D_METHOD("get_recording_dropped_count"), &GodotRtMidiIn::get_recording_dropped_count);
+
+    // Queue configuration
+    ClassDB::bind_method(D_METHOD("set_queue_capacity", "capacity"), &GodotRtMidiIn::set_queue_capacity);
+    ClassDB::bind_method(D_METHOD("get_queue_capacity"), &GodotRtMidiIn::get_queue_capacity);
+    ClassDB::bind_method(D_METHOD("set_lane_capacity", "lane", "capacity"), &GodotRtMidiIn::set_lane_capacity);
+    ClassDB::bind_method(D_METHOD("get_lane_capacity", "lane"), &GodotRtMidiIn::get_lane_capacity);
+    ClassDB::bind_method(D_METHOD("set_overflow_policy", "policy"), &GodotRtMidiIn::set_overflow_policy);
+    ClassDB::bind_method(D_METHOD("get_overflow_policy"), &GodotRtMidiIn::get_overflow_policy);
+    ClassDB::bind_method(D_METHOD("get_dropped_count"), &GodotRtMidiIn::get_dropped_count);
+    ClassDB::bind_method(D_METHOD("get_lane_dropped_count", "lane"), &GodotRtMidiIn::get_lane_dropped_count);
+    ClassDB::bind_method(D_METHOD("set_cc_coalescing", "enabled"), &GodotRtMidiIn::set_cc_coalescing);
+    ClassDB::bind_method(D_METHOD("get_cc_coalescing"), &GodotRtMidiIn::get_cc_coalescing);
+    ClassDB::bind_method(D_METHOD("get_coalesced_count"), &GodotRtMidiIn::get_coalesced_count);
+
+    BIND_ENUM_CONSTANT(OVERFLOW_DROP_OLDEST);
+    BIND_ENUM_CONSTANT(OVERFLOW_DROP_NEWEST);
+    BIND_ENUM_CONSTANT(OVERFLOW_COALESCE);
+
+    BIND_ENUM_CONSTANT(LANE_REALTIME);
+    BIND_ENUM_CONSTANT(LANE_NOTES);
+    BIND_ENUM_CONSTANT(LANE_CONTROLLERS);
+    BIND_ENUM_CONSTANT(LANE_SYSTEM);
+    BIND_ENUM_CONSTANT(LANE_COUNT);
+
+    // 14-bit controller decoding
+    ClassDB::bind_method(D_METHOD("set_cc14_pairing", "msb_controller", "enabled"), &GodotRtMidiIn::set_cc14_pairing);
+    ClassDB::bind_method(D_METHOD("get_cc14_pairing", "msb_controller"), &GodotRtMidiIn::get_cc14_pairing);
+    ClassDB::bind_method(D_METHOD("set_nrpn_decoding", "enabled"), &GodotRtMidiIn::set_nrpn_decoding);
+    ClassDB::bind_method(D_METHOD("is_nrpn_decoding"), &GodotRtMidiIn::is_nrpn_decoding);
+    ClassDB::bind_method(D_METHOD("set_data_entry_waits_for_lsb", "wait"), &GodotRtMidiIn::set_data_entry_waits_for_lsb);
+    ClassDB::bind_method(D_METHOD("get_data_entry_waits_for_lsb"), &GodotRtMidiIn::get_data_entry_waits_for_lsb);
+
+    BIND_ENUM_CONSTANT(MESSAGE_MIDI);
+    BIND_ENUM_CONSTANT(MESSAGE_CC14);
+    BIND_ENUM_CONSTANT(MESSAGE_NRPN);
+    BIND_ENUM_CONSTANT(MESSAGE_RPN);
 
     // Message polling
     ClassDB::bind_method(D_METHOD("has_message"), &GodotRtMidiIn::has_message);
     ClassDB::bind_method(D_METHOD("poll_message"), &GodotRtMidiIn::poll_message);
+    ClassDB::bind_method(D_METHOD("drain_messages"), &GodotRtMidiIn::drain_messages);
+
+    // Clock tracking
+    ClassDB::bind_method(D_METHOD("get_time"), &GodotRtMidiIn::get_time);
+    ClassDB::bind_method(D_METHOD("get_driver_time"), &GodotRtMidiIn::get_driver_time);
+    ClassDB::bind_method(D_METHOD("get_bpm"), &GodotRtMidiIn::get_bpm);
+    ClassDB::bind_method(D_METHOD("get_beat_position", "at_time"), &GodotRtMidiIn::get_beat_position, DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("get_beat_phase", "at_time"), &GodotRtMidiIn::get_beat_phase, DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("get_clock_jitter"), &GodotRtMidiIn::get_clock_jitter);
+    ClassDB::bind_method(D_METHOD("get_clock_drift"), &GodotRtMidiIn::get_clock_drift);
+    ClassDB::bind_method(D_METHOD("is_clock_locked"), &GodotRtMidiIn::is_clock_locked);
+    ClassDB::bind_method(D_METHOD("is_clock_playing"), &GodotRtMidiIn::is_clock_playing);
+
+    // Controller/note state
+    ClassDB::bind_method(D_METHOD("get_cc", "channel", "control"), &GodotRtMidiIn::get_cc);
+    ClassDB::bind_method(D_METHOD("get_note_velocity", "channel", "note"), &GodotRtMidiIn::get_note_velocity);
+    ClassDB::bind_method(D_METHOD("get_state_sequence"), &GodotRtMidiIn::get_state_sequence);
+    ClassDB::bind_method(D_METHOD("get_changed_ccs", "since_seq"), &GodotRtMidiIn::get_changed_ccs);
+    ClassDB::bind_method(D_METHOD("get_cc_snapshot"), &GodotRtMidiIn::get_cc_snapshot);
+    ClassDB::bind_method(D_METHOD("get_note_snapshot"), &GodotRtMidiIn::get_note_snapshot);
+    ClassDB::bind_method(D_METHOD("get_nrpn", "channel", "parameter"), &GodotRtMidiIn::get_nrpn);
+    ClassDB::bind_method(D_METHOD("get_rpn", "channel", "parameter"), &GodotRtMidiIn::get_rpn);
+}
+
+void GodotRtMidiIn::midi_batch_callback(const RtMidiEvent* events, unsigned int count, void* userData) {
+    GodotRtMidiIn* self = static_cast<GodotRtMidiIn*>(userData);
+    if (!self) return;
+
+    self->recorder_busy.store(true);
+    if (self->recording.load()) {
+        for (unsigned int i = 0; i < count; i++) {
+            self->recorder.append(events[i]);
+        }
+        self->recorder.commit();
+    }
+    self->recorder_busy.store(false, std::memory_order_release);
+
+    for (unsigned int i = 0; i < count; i++) {
+        self->process_event(events[i]);
+    }
+    self->flush_decoders();
+    self->commit_staged();
 }
 
-void GodotRtMidiIn::midi_callback(double timestamp, std::vector<unsigned char>* message, void* userData) {
+// Runs on the MIDI thread: hand the change to the main thread. Bursts (a
+// device with several ports) share one deferred flush.
+void GodotRtMidiIn::midi_port_callback(int change, const RtMidiPortInfo &port, void* userData) {
     GodotRtMidiIn* self = static_cast<GodotRtMidiIn*>(userData);
-    if (!self || message->empty()) return;
+    if (!self) return;
+
+    PortEvent event;
+    event.change = change;
+    event.client = port.client;
+    event.port = port.port;
+    event.capabilities = port.capabilities;
+    size_t length = std::min(port.name.size(), size_t(PORT_NAME_SIZE - 1));
+    memcpy(event.name, port.name.data(), length);
+    event.name[length] = '\0';
+
+    if (!self->port_events.push(event)) {
+        self->port_events_lost.store(true, std::memory_order_release);
+    }
+    if (!self->port_flush_pending.exchange(true, std::memory_order_acq_rel)) {
+        self->call_deferred("_flush_port_events");
+    }
+}
+
+// Runs on the MIDI thread: update clock/state and stage the message.
+void GodotRtMidiIn::process_event(const RtMidiEvent &event) {
+    if (event.size == 0) return;
 
+    const unsigned char* bytes = event.data();
     MidiMessage msg;
-    msg.timestamp = timestamp;
-    msg.status = (*message)[0];
-    msg.data1 = message->size() > 1 ? (*message)[1] : 0;
-    msg.data2 = message->size() > 2 ? (*message)[2] : 0;
+    msg.timestamp = event.timeNs / 1000000000.0;
+    msg.delta = event.deltaTime;
+    msg.status = bytes[0];
+    msg.data1 = event.size > 1 ? bytes[1] : 0;
+    msg.data2 = event.size > 2 ? bytes[2] : 0;
+    msg.kind = MESSAGE_MIDI;
+    msg.source = event.source;
+    msg.param = 0;
+    msg.value = 0;
+
+    if (msg.status < 0xF0) {
+        int decoder_index = std::min<int>(event.source, SOURCE_UNKNOWN);
+        MidiParamDecoder &decoder = decoders[decoder_index];
+        bool consumed = decoder.process(msg.status, msg.data1, msg.data2, msg.timestamp);
+        const MidiParamDecoder::Event *events = decoder.get_events();
+        for (int i = 0; i < decoder.get_event_count(); i++) {
+            enqueue_param(events[i], msg);
+        }
+        if (consumed) {
+            // May hold an MSB until the end of the batch
+            decoders_holding |= 1u << decoder_index;
+            return;
+        }
+    }
+
+    switch (msg.status & 0xF0) {
+        case 0x80:
+            state.set_note(msg.status & 0x0F, msg.data1, 0);
+            break;
+        case 0x90:
+            state.set_note(msg.status & 0x0F, msg.data1, msg.data2);
+            break;
+        case 0xB0:
+            state.set_cc(msg.status & 0x0F, msg.data1, MidiState::scale7(msg.data2));
+            break;
+        case 0xF0:
+            if (msg.status >= 0xF8) {
+                clock.process(msg.status, msg.timestamp);
+            }
+            break;
+    }
+
+    enqueue(msg);
+}
+
+// Publish a merged 14-bit event, timed like the message that carried its
+// value.
+void GodotRtMidiIn::enqueue_param(const MidiParamDecoder::Event &event, const MidiMessage &source) {
+    MidiMessage msg = source;
+    msg.timestamp = event.time;
+    msg.kind = event.kind;
+    msg.param = event.param;
+    msg.value = event.value;
+    msg.status = 0xB0 | event.channel;
+    // 7-bit view: the MSB controller, or Data Entry for parameters
+    msg.data1 = event.kind == MESSAGE_CC14 ? uint8_t(event.param) : 6;
+    msg.data2 = uint8_t(event.value >> 7);
+
+    if (event.kind == MESSAGE_CC14) {
+        state.set_cc(event.channel, event.param, event.value);
+    } else {
+        state.set_param(event.kind == MESSAGE_RPN, event.channel, event.param, event.value);
+    }
+
+    enqueue(msg);
+}
+
+// End of a driver batch: publish the MSBs still waiting for an LSB that
+// didn't come with them, at their own arrival time.
+void GodotRtMidiIn::flush_decoders() {
+    uint32_t holding = decoders_holding;
+    decoders_holding = 0;
+    for (int index = 0; holding; index++, holding >>= 1) {
+        if (!(holding & 1)) continue;
+
+        MidiMessage source = {};
+        source.source = uint8_t(index);
+        MidiParamDecoder &decoder = decoders[index];
+        for (int channel = 0; channel < 16; channel++) {
+            if (!decoder.flush_channel(channel)) continue;
+            const MidiParamDecoder::Event *events = decoder.get_events();
+            for (int i = 0; i < decoder.get_event_count(); i++) {
+                enqueue_param(events[i], source);
+            }
+        }
+    }
+}
+
+// Runs on the MIDI thread; never blocks or allocates.
+void GodotRtMidiIn::enqueue(const MidiMessage &msg) {
+    staged[staged_count++] = msg;
+    if (staged_count == STAGING_SIZE) {
+        commit_staged();
+    }
+}
+
+// Publish every staged message with one commit per lane. Broadcast readers
+// get them in arrival order; lanes, overflow policy and coalescing don't
+// apply to them, and their setters refuse a broadcast input.
+void GodotRtMidiIn::commit_staged() {
+    int count = staged_count;
+    staged_count = 0;
+    if (count == 0) return;
+
+    // Broadcast readers each track their own overflow
+    if (broadcast) {
+        broadcast->publish(staged, count);
+        return;
+    }
+
+    // Most batches are a single lane (a CC sweep, a run of clock ticks)
+    MessageLane first = message_lane(staged[0]);
+    int same = 1;
+    while (same < count && message_lane(staged[same]) == first) {
+        same++;
+    }
+    if (same == count) {
+        commit_lane(first, staged, count);
+        return;
+    }
+
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        int lane_count = 0;
+        for (int i = 0; i < count; i++) {
+            if (message_lane(staged[i]) == lane) {
+                lane_staged[lane_count++] = staged[i];
+            }
+        }
+        if (lane_count > 0) {
+            commit_lane(lane, lane_staged, lane_count);
+        }
+    }
+}
+
+// Push one lane's messages with a single ring commit, applying the overflow
+// policy to whatever doesn't fit. May compact messages in place.
+void GodotRtMidiIn::commit_lane(int lane, MidiMessage *messages, int count) {
+    int policy = overflow_policy.load(std::memory_order_relaxed);
+    MidiRing<MidiMessage> &queue = message_queues[lane];
+
+    bool coalescing = lane == LANE_CONTROLLERS && cc_coalescing.load(std::memory_order_relaxed);
+    if (coalescing) {
+        // Drop what the ring could never hold first, so every entry
+        // indexed below really gets written
+        if (policy == OVERFLOW_DROP_OLDEST && count > (int)queue.capacity()) {
+            int skip = count - (int)queue.capacity();
+            dropped_counts[lane].fetch_add(skip, std::memory_order_relaxed);
+            messages += skip;
+            count -= skip;
+        }
+        count = coalesce_unread_ccs(messages, count);
+        if (count == 0) return;
+    }
+
+    if (policy == OVERFLOW_DROP_OLDEST) {
+        size_t dropped = queue.push_batch_overwrite(messages, count);
+        if (dropped > 0) {
+            dropped_counts[lane].fetch_add(dropped, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    if (policy == OVERFLOW_COALESCE && coalesced_pending.load(std::memory_order_acquire) > 0) {
+        // A newer value supersedes any coalesced one; clear it before publishing
+        for (int i = 0; i < count; i++) {
+            if (!is_plain_cc(messages[i])) continue;
+            int slot = (messages[i].status & 0x0F) * 128 + (messages[i].data1 & 0x7F);
+            if (coalesced_cc[slot].exchange(0, std::memory_order_acq_rel) & CC_PENDING) {
+                coalesced_pending.fetch_sub(1, std::memory_order_release);
+                dropped_counts[lane].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    int pushed = (int)queue.push_batch(messages, count);
+    if (pushed == count) return;
+
+    uint64_t dropped = 0;
+    for (int i = pushed; i < count; i++) {
+        MidiMessage &msg = messages[i];
+        // This entry never reached the ring: take back the latest value
+        // that was coalesced into it
+        if (coalescing && is_plain_cc(msg) && !take_unread_cc(msg)) {
+            continue;
+        }
+        if (policy == OVERFLOW_COALESCE && is_plain_cc(msg)) {
+            int slot = (msg.status & 0x0F) * 128 + (msg.data1 & 0x7F);
+            uint64_t time_ns = (uint64_t)std::llround(msg.timestamp * 1000000000.0);
+            uint64_t packed = (time_ns << 8) | CC_PENDING | (msg.data2 & 0x7F);
+            if (coalesced_cc[slot].exchange(packed, std::memory_order_acq_rel) & CC_PENDING) {
+                dropped++;
+            } else {
+                coalesced_pending.fetch_add(1, std::memory_order_release);
+            }
+        } else {
+            dropped++;
+        }
+    }
+    if (dropped > 0) {
+        dropped_counts[lane].fetch_add(dropped, std::memory_order_relaxed);
+    }
+}
+
+// MIDI thread: fold each CC whose controller still has an unread entry in
+// the controller lane into that entry, compacting messages in place.
+// Returns how many messages are left to push.
+int GodotRtMidiIn::coalesce_unread_ccs(MidiMessage *messages, int count) {
+    MidiRing<MidiMessage> &queue = message_queues[LANE_CONTROLLERS];
+    uint64_t next_index = queue.write_index();
+    uint64_t read_index = queue.read_index();
+    uint64_t coalesced = 0;
+    int kept = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (is_plain_cc(messages[i])) {
+            const MidiMessage &msg = messages[i];
+            int slot = (msg.status & 0x0F) * 128 + (msg.data1 & 0x7F);
+            uint64_t time_ns = (uint64_t)std::llround(msg.timestamp * 1000000000.0);
+            uint64_t packed = (time_ns << 8) | CC_PENDING | (msg.data2 & 0x7F);
+            uint64_t previous = unread_cc[slot].exchange(packed, std::memory_order_acq_rel);
+            // Still pending but below the read index means the entry was
+            // discarded by an overflow: queue a new one
+            if ((previous & CC_PENDING) && unread_cc_index[slot] >= read_index) {
+                coalesced++;
+                continue;
+            }
+            unread_cc_index[slot] = next_index;
+        }
+        if (kept != i) {
+            messages[kept] = messages[i];
+        }
+        kept++;
+        next_index++;
+    }
+
+    if (coalesced > 0) {
+        coalesced_count.fetch_add(coalesced, std::memory_order_relaxed);
+    }
+    return kept;
+}
+
+// Fill in the latest value of a CC entry under per-frame coalescing.
+// Returns false if that value was already delivered with an earlier entry.
+bool GodotRtMidiIn::take_unread_cc(MidiMessage &msg) {
+    int slot = (msg.status & 0x0F) * 128 + (msg.data1 & 0x7F);
+    uint64_t packed = unread_cc[slot].exchange(0, std::memory_order_acq_rel);
+    if (!(packed & CC_PENDING)) {
+        return false;
+    }
+    msg.data2 = packed & 0x7F;
+    msg.timestamp = (packed >> 8) / 1000000000.0;
+    return true;
+}
+
+// Main thread: deliver the next coalesced CC once the queue has drained.
+bool GodotRtMidiIn::take_coalesced(MidiMessage &msg) {
+    if (coalesced_pending.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+
+    for (int i = 0; i < CC_SLOTS; i++) {
+        int slot = (coalesce_scan + i) % CC_SLOTS;
+        uint64_t packed = coalesced_cc[slot].exchange(0, std::memory_order_acq_rel);
+        if (!(packed & CC_PENDING)) {
+            continue;
+        }
+        coalesced_pending.fetch_sub(1, std::memory_order_release);
+        coalesce_scan = (slot + 1) % CC_SLOTS;
+
+        msg.status = 0xB0 | (slot / 128);
+        msg.data1 = slot % 128;
+        msg.data2 = packed & 0x7F;
+        msg.timestamp = (packed >> 8) / 1000000000.0;
+        msg.delta = 0.0;
+        msg.kind = MESSAGE_MIDI;
+        msg.source = SOURCE_UNKNOWN;  // The slot merges every source
+        msg.param = 0;
+        msg.value = 0;
+        return true;
+    }
+
+    return false;
+}
+
+GodotRtMidiIn::MessageLane GodotRtMidiIn::message_lane(const MidiMessage &msg) {
+    if (msg.status >= 0xF8) {
+        return LANE_REALTIME;
+    }
+    if (msg.status >= 0xF0) {
+        return LANE_SYSTEM;
+    }
+    if (msg.kind != MESSAGE_MIDI) {
+        return LANE_CONTROLLERS;
+    }
+    switch (msg.status & 0xF0) {
+        case 0x80:
+        case 0x90:
+        case 0xA0:
+        case 0xC0:
+            return LANE_NOTES;
+        default:
+            return LANE_CONTROLLERS;
+    }
+}
+
+// Main thread: the next message from the highest-priority non-empty lane.
+bool GodotRtMidiIn::pop_message(MidiMessage &msg) {
+    bool coalescing = cc_coalescing.load(std::memory_order_relaxed);
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        while (message_queues[lane].pop(msg)) {
+            if (coalescing && lane == LANE_CONTROLLERS && is_plain_cc(msg) && !take_unread_cc(msg)) {
+                continue;
+            }
+            return true;
+        }
+    }
+    return false;
+}
 
-    std::lock_guard<std::mutex> lock(self->queue_mutex);
-    self->message_queue.push(msg);
+void GodotRtMidiIn::clear_queue() {
+    for (MidiRing<MidiMessage> &queue : message_queues) {
+        queue.clear();
+    }
+    for (int i = 0; i < CC_SLOTS; i++) {
+        coalesced_cc[i].store(0, std::memory_order_relaxed);
+        unread_cc[i].store(0, std::memory_order_relaxed);
+    }
+    coalesced_pending.store(0, std::memory_order_release);
+    coalesce_scan = 0;
 }
 
 GodotRtMidiIn::GodotRtMidiIn() {
-    midi_in = new RtMidiIn(RtMidi::UNSPECIFIED, "Godot Visualizer");
+    message_queues[LANE_REALTIME].reset(DEFAULT_LANE_CAPACITY);
+    message_queues[LANE_NOTES].reset(DEFAULT_LANE_CAPACITY);
+    message_queues[LANE_CONTROLLERS].reset(DEFAULT_QUEUE_CAPACITY);
+    message_queues[LANE_SYSTEM].reset(DEFAULT_LANE_CAPACITY);
+    for (std::atomic<uint64_t> &dropped : dropped_counts) {
+        dropped.store(0, std::memory_order_relaxed);
+    }
+    port_events.reset(PORT_EVENT_CAPACITY);
+    for (int i = 0; i < CC_SLOTS; i++) {
+        coalesced_cc[i].store(0, std::memory_order_relaxed);
+        unread_cc[i].store(0, std::memory_order_relaxed);
+        unread_cc_index[i] = 0;
+    }
+
+    create_input(RtMidi::UNSPECIFIED);
+}
+
+GodotRtMidiIn::~GodotRtMidiIn() {
+    destroy_input();
+    stop_recording();
+    if (memory_locked) {
+        lock_buffers(false);
+    }
+}
+
+void GodotRtMidiIn::create_input(RtMidi::Api api) {
+    midi_in = new RtMidiIn(api, "Godot Visualizer");
     if (midi_in) {
         // Don't ignore timing messages (needed for MIDI clock)
         midi_in->ignoreTypes(true, false, true);
-        midi_in->setCallback(&GodotRtMidiIn::midi_callback, this);
+        midi_in->setBatchCallback(&GodotRtMidiIn::midi_batch_callback, this);
+        // Before the watcher below starts the input thread
+        midi_in->setThreadOptions(thread_options);
+
+        // Take the one full snapshot after watching starts; changes that
+        // race with it are applied idempotently on the first flush
+        watching_ports = midi_in->setPortCallback(&GodotRtMidiIn::midi_port_callback, this);
+        if (watching_ports) {
+            port_table = midi_in->getPorts();
+        }
     }
 }
 
-GodotRtMidiIn::~GodotRtMidiIn() {
+void GodotRtMidiIn::destroy_input() {
     if (midi_in) {
+        if (watching_ports) {
+            midi_in->setPortCallback(nullptr);
+        }
         close_port();
         delete midi_in;
         midi_in = nullptr;
     }
+    watching_ports = false;
+    port_table.clear();
+}
+
+// The live table when the backend reports changes, a fresh snapshot
+// otherwise. Every index-based call goes through here so indices agree.
+const std::vector<RtMidiPortInfo> &GodotRtMidiIn::get_input_ports() {
+    if (!watching_ports && midi_in) {
+        port_table = midi_in->getPorts();
+    }
+    return port_table;
 }
 
 PackedStringArray GodotRtMidiIn::get_port_names() {
     PackedStringArray names;
     if (!midi_in) return names;
 
-    unsigned int count = midi_in->getPortCount();
-    for (unsigned int i = 0; i < count; i++) {
-        names.push_back(String(midi_in->getPortName(i).c_str()));
+    for (const RtMidiPortInfo &info : get_input_ports()) {
+        names.push_back(String(info.name.c_str()));
     }
 
     return names;
@@ -66,24 +622,64 @@ PackedStringArray GodotRtMidiIn::get_port_names() {
 
 int GodotRtMidiIn::get_port_count() {
     if (!midi_in) return 0;
-    return midi_in->getPortCount();
+    return (int)get_input_ports().size();
 }
 
-Error GodotRtMidiIn::open_port(int port_number) {
-    if (!midi_in) return ERR_UNCONFIGURED;
+Dictionary GodotRtMidiIn::get_ports() {
+    Dictionary result;
+    PackedStringArray names;
+    PackedInt32Array clients;
+    PackedInt32Array ports;
+    PackedInt32Array capabilities;
 
-    if (port_open) {
-        midi_in->closePort();
+    if (midi_in) {
+        const std::vector<RtMidiPortInfo> &infos = get_input_ports();
+        int64_t count = (int64_t)infos.size();
+        clients.resize(count);
+        ports.resize(count);
+        capabilities.resize(count);
+        for (int64_t i = 0; i < count; i++) {
+            names.push_back(String(infos[i].name.c_str()));
+            clients.set(i, infos[i].client);
+            ports.set(i, infos[i].port);
+            capabilities.set(i, (int32_t)infos[i].capabilities);
+        }
     }
 
-    // Validate port number
-    if (port_number < 0 || (unsigned int)port_number >= midi_in->getPortCount()) {
+    result["names"] = names;
+    result["clients"] = clients;
+    result["ports"] = ports;
+    result["capabilities"] = capabilities;
+    return result;
+}
+
+Error GodotRtMidiIn::open_port(int port_number) {
+    if (!midi_in) return ERR_UNCONFIGURED;
+
+    // One lookup both validates the index and resolves its address
+    const std::vector<RtMidiPortInfo> &ports = get_input_ports();
+    if (port_number < 0 || (size_t)port_number >= ports.size()) {
         UtilityFunctions::printerr("RtMidi Error: Invalid port number");
-        port_open = false;
+        if (port_open) {
+            close_port();
+        }
         return ERR_CANT_OPEN;
     }
 
-    midi_in->openPort(port_number, "Godot MIDI In");
+    RtMidiPortInfo info = ports[port_number];
+    return open_port_address(info.client, info.port);
+}
+
+Error GodotRtMidiIn::open_port_address(int client, int port) {
+    if (!midi_in) return ERR_UNCONFIGURED;
+
+    if (port_open) {
+        midi_in->closePort();
+    }
+    sources.clear();
+    virtual_port = false;
+
+    midi_in->openPortAddress(client, port, "Godot MIDI In");
     port_open = midi_in->isPortOpen();
 
     if (!port_open) {
@@ -91,6 +687,7 @@ Error GodotRtMidiIn::open_port(int port_number) {
         return ERR_CANT_OPEN;
     }
 
+    sources.push_back({ 0, client, port, find_port_name(client, port) });
     return OK;
 }
 
@@ -100,9 +697,11 @@ Error GodotRtMidiIn::open_virtual_port(const String &name) {
     if (port_open) {
         midi_in->closePort();
     }
+    sources.clear();
 
     midi_in->openVirtualPort(name.utf8().get_data());
     port_open = midi_in->isPortOpen();
+    virtual_port = port_open;
 
     if (!port_open) {
         UtilityFunctions::printerr("RtMidi Error: Failed to open virtual port");
@@ -113,47 +712,815 @@ Error GodotRtMidiIn::open_virtual_port(const String &name) {
 }
 
 void GodotRtMidiIn::close_port() {
+    release_port();
+    // Closed on purpose: don't reopen anything when it reappears
+    sources.clear();
+    virtual_port = false;
+}
+
+// Close the port but remember the sources for auto-reconnect.
+void GodotRtMidiIn::release_port() {
     if (!midi_in) return;
 
     midi_in->closePort();
     port_open = false;
+    for (SourceEntry &source : sources) {
+        source.client = -1;
+        source.port = -1;
+    }
 
-    // Clear message queue
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    while (!message_queue.empty()) {
-        message_queue.pop();
+    // The input thread no longer delivers messages (it only keeps running
+    // for port changes), so the queue can be reset safely
+    clear_queue();
+    staged_count = 0;
+    for (MidiParamDecoder &decoder : decoders) {
+        decoder.reset();
     }
+    decoders_holding = 0;
+    clock.reset();
+    state.clear_notes();
+}
+
+std::string GodotRtMidiIn::find_port_name(int client, int port) {
+    for (const RtMidiPortInfo &info : get_input_ports()) {
+        if (info.client == client && info.port == port) {
+            return info.name;
+        }
+    }
+    return std::string();
+}
+
+Error GodotRtMidiIn::set_api(const String &name) {
+    ERR_FAIL_COND_V(port_open || virtual_port, ERR_ALREADY_IN_USE);
+
+    RtMidi::Api api = RtMidi::UNSPECIFIED;
+    if (!name.is_empty()) {
+        api = RtMidi::getCompiledApiByName(name.utf8().get_data());
+        if (api == RtMidi::UNSPECIFIED) {
+            UtilityFunctions::printerr("RtMidi Error: API '", name, "' is not compiled in");
+            return ERR_UNAVAILABLE;
+        }
+    }
+
+    RtMidiFilter filter;
+    if (midi_in) {
+        filter = midi_in->getFilter();
+    }
+    destroy_input();
+    // The watcher thread is gone, so nothing can still be queued for it
+    port_events.clear();
+    port_events_lost.store(false, std::memory_order_relaxed);
+    create_input(api);
+    if (!midi_in || midi_in->getCurrentApi() == RtMidi::UNSPECIFIED) return ERR_CANT_CREATE;
+    midi_in->setFilter(filter);
+    emit_signal("ports_changed");
+    return OK;
+}
+
+String GodotRtMidiIn::get_api() const {
+    if (!midi_in) return String();
+    return String(RtMidi::getApiName(midi_in->getCurrentApi()).c_str());
 }
 
 bool GodotRtMidiIn::is_port_open() const {
     return port_open && midi_in != nullptr;
 }
 
+void GodotRtMidiIn::set_auto_reconnect(bool enabled) {
+    auto_reconnect = enabled;
+}
+
+bool GodotRtMidiIn::get_auto_reconnect() const {
+    return auto_reconnect;
+}
+
+String GodotRtMidiIn::get_open_port_name() const {
+    for (const SourceEntry &source : sources) {
+        if (source.id == 0) {
+            return String(source.name.c_str());
+        }
+    }
+    return String();
+}
+
+int GodotRtMidiIn::add_source(int port_number) {
+    if (!midi_in) return -1;
+
+    const std::vector<RtMidiPortInfo> &ports = get_input_ports();
+    if (port_number < 0 || (size_t)port_number >= ports.size()) {
+        UtilityFunctions::printerr("RtMidi Error: Invalid port number");
+        return -1;
+    }
+
+    RtMidiPortInfo info = ports[port_number];
+    return add_source_address(info.client, info.port);
+}
+
+int GodotRtMidiIn::add_source_address(int client, int port) {
+    if (!midi_in) return -1;
+
+    // Ids of disconnected sources stay reserved for their reconnect
+    int id = -1;
+    for (int i = 0; i < MAX_SOURCES && id < 0; i++) {
+        id = i;
+        for (const SourceEntry &source : sources) {
+            if (source.id == i) {
+                id = -1;
+                break;
+            }
+        }
+    }
+    if (id < 0) {
+        UtilityFunctions::printerr("RtMidi Error: Too many sources");
+        return -1;
+    }
+
+    if (midi_in->addSource(client, port, id, "Godot MIDI In") != id) {
+        UtilityFunctions::printerr("RtMidi Error: Failed to add source");
+        return -1;
+    }
+    port_open = midi_in->isPortOpen();
+    sources.push_back({ id, client, port, find_port_name(client, port) });
+    return id;
+}
+
+Error GodotRtMidiIn::remove_source(int source) {
+    if (!midi_in) return ERR_UNCONFIGURED;
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].id != source) continue;
+        if (sources[i].client >= 0) {
+            midi_in->removeSource(source);
+        }
+        sources.erase(sources.begin() + i);
+        return OK;
+    }
+
+    UtilityFunctions::printerr("RtMidi Error: No such source");
+    return ERR_DOES_NOT_EXIST;
+}
+
+Dictionary GodotRtMidiIn::get_sources() const {
+    PackedInt32Array ids;
+    PackedStringArray names;
+    PackedInt32Array clients;
+    PackedInt32Array ports;
+    for (const SourceEntry &source : sources) {
+        ids.push_back(source.id);
+        names.push_back(String(source.name.c_str()));
+        clients.push_back(source.client);
+        ports.push_back(source.port);
+    }
+
+    Dictionary result;
+    result["ids"] = ids;
+    result["names"] = names;
+    result["clients"] = clients;
+    result["ports"] = ports;
+    return result;
+}
+
+// Main thread, deferred from midi_port_callback().
+void GodotRtMidiIn::_flush_port_events() {
+    // Cleared first so a change arriving while we drain schedules another flush
+    port_flush_pending.store(false, std::memory_order_release);
+
+    bool changed = false;
+    if (port_events_lost.exchange(false, std::memory_order_acq_rel)) {
+        changed = resync_ports();
+    }
+
+    PortEvent event;
+    while (port_events.pop(event)) {
+        RtMidiPortInfo info;
+        info.name = event.name;
+        info.client = event.client;
+        info.port = event.port;
+        info.capabilities = event.capabilities;
+        changed = apply_port_change(event.change, info) || changed;
+    }
+
+    if (changed) {
+        emit_signal("ports_changed");
+    }
+}
+
+// Idempotent, so events that raced with a snapshot can be replayed on it.
+// Returns true if the table changed.
+bool GodotRtMidiIn::apply_port_change(int change, const RtMidiPortInfo &port) {
+    auto same_address = [&port](const RtMidiPortInfo &info) {
+        return info.client == port.client && info.port == port.port;
+    };
+    auto it = std::find_if(port_table.begin(), port_table.end(), same_address);
+
+    // A port that can no longer be read from is gone as far as input goes
+    bool present = change != RtMidiPortInfo::REMOVED && (port.capabilities & RtMidiPortInfo::INPUT);
+    if (!present) {
+        if (it == port_table.end()) return false;
+        RtMidiPortInfo removed = *it;
+        port_table.erase(it);
+        on_port_removed(removed);
+        return true;
+    }
+
+    if (it != port_table.end()) {
+        if (it->name == port.name && it->capabilities == port.capabilities) return false;
+        *it = port;
+        return true;
+    }
+
+    // Keep enumeration order (client, then port) so indices match a fresh listing
+    auto pos = std::find_if(port_table.begin(), port_table.end(), [&port](const RtMidiPortInfo &info) {
+        return info.client > port.client || (info.client == port.client && info.port > port.port);
+    });
+    port_table.insert(pos, port);
+    on_port_added(port);
+    return true;
+}
+
+// Rebuild port_table after port events were lost, reporting the difference.
+bool GodotRtMidiIn::resync_ports() {
+    std::vector<RtMidiPortInfo> previous;
+    previous.swap(port_table);
+    port_table = midi_in->getPorts();
+
+    auto contains = [](const std::vector<RtMidiPortInfo> &ports, const RtMidiPortInfo &port) {
+        for (const RtMidiPortInfo &info : ports) {
+            if (info.client == port.client && info.port == port.port && info.name == port.name) return true;
+        }
+        return false;
+    };
+
+    bool changed = previous.size() != port_table.size();
+    for (const RtMidiPortInfo &info : previous) {
+        if (!contains(port_table, info)) {
+            on_port_removed(info);
+            changed = true;
+        }
+    }
+    for (const RtMidiPortInfo &info : port_table) {
+        if (!contains(previous, info)) {
+            on_port_added(info);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Resubscribe a disconnected source with the same name, under its old id.
+// Reopens the input if it was closed because every source was lost.
+void GodotRtMidiIn::on_port_added(const RtMidiPortInfo &port) {
+    if (auto_reconnect && !port.name.empty()) {
+        for (SourceEntry &source : sources) {
+            if (source.client >= 0 || source.name != port.name) continue;
+            if (midi_in->addSource(port.client, port.port, source.id, "Godot MIDI In") == source.id) {
+                source.client = port.client;
+                source.port = port.port;
+                port_open = midi_in->isPortOpen();
+                UtilityFunctions::print("RtMidi: Reconnected to ", String(port.name.c_str()));
+            }
+            break;
+        }
+    }
+    emit_signal("port_added", String(port.name.c_str()), port.client, port.port);
+}
+
+void GodotRtMidiIn::on_port_removed(const RtMidiPortInfo &port) {
+    bool lost = false;
+    bool any_connected = false;
+    for (SourceEntry &source : sources) {
+        if (source.client == port.client && source.port == port.port) {
+            midi_in->removeSource(source.id);
+            source.client = -1;
+            source.port = -1;
+            lost = true;
+        } else if (source.client >= 0) {
+            any_connected = true;
+        }
+    }
+
+    if (lost) {
+        UtilityFunctions::printerr("RtMidi Error: Port disconnected: ", String(port.name.c_str()));
+        // Nothing left to listen to
+        if (port_open && !any_connected && !virtual_port) {
+            release_port();
+        }
+    }
+    emit_signal("port_removed", String(port.name.c_str()), port.client, port.port);
+}
+
 void GodotRtMidiIn::ignore_types(bool sysex, bool timing, bool active_sense) {
     if (!midi_in) return;
     midi_in->ignoreTypes(sysex, timing, active_sense);
 }
 
+void GodotRtMidiIn::set_message_filter(int64_t types, int channel_mask, int note_low, int note_high) {
+    if (!midi_in) return;
+    ERR_FAIL_COND(note_low < 0 || note_high > 127 || note_low > note_high);
+
+    RtMidiFilter filter = midi_in->getFilter();
+    filter.types = (unsigned int)(types & FILTER_ALL);
+    filter.channels = (unsigned short)(channel_mask & 0xFFFF);
+    filter.noteLow = (unsigned char)note_low;
+    filter.noteHigh = (unsigned char)note_high;
+    midi_in->setFilter(filter);
+}
+
+int64_t GodotRtMidiIn::get_message_filter() const {
+    if (!midi_in) return FILTER_ALL;
+    return midi_in->getFilter().types;
+}
+
+void GodotRtMidiIn::set_clock_while_stopped(bool enabled) {
+    if (!midi_in) return;
+    RtMidiFilter filter = midi_in->getFilter();
+    filter.clockWhileStopped = enabled;
+    midi_in->setFilter(filter);
+}
+
+bool GodotRtMidiIn::get_clock_while_stopped() const {
+    if (!midi_in) return true;
+    return midi_in->getFilter().clockWhileStopped;
+}
+
+Error GodotRtMidiIn::set_thread_priority(ThreadPolicy policy, int priority) {
+    ERR_FAIL_COND_V(policy < THREAD_NORMAL || policy > THREAD_ROUND_ROBIN, ERR_INVALID_PARAMETER);
+    ERR_FAIL_COND_V(priority < 0 || priority > 99, ERR_INVALID_PARAMETER);
+    thread_options.policy = (RtMidiThreadOptions::Policy)policy;
+    thread_options.priority = priority;
+    return apply_thread_options();
+}
+
+Error GodotRtMidiIn::set_thread_affinity(const PackedInt32Array &cpus) {
+    uint64_t mask = 0;
+    for (int i = 0; i < cpus.size(); i++) {
+        ERR_FAIL_COND_V(cpus[i] < 0 || cpus[i] > 63, ERR_INVALID_PARAMETER);
+        mask |= uint64_t(1) << cpus[i];
+    }
+    thread_options.cpus = mask;
+    return apply_thread_options();
+}
+
+// The backend restarts its input thread with the new settings; the outcome
+// shows up in get_realtime_status()
+Error GodotRtMidiIn::apply_thread_options() {
+    if (!midi_in) return ERR_UNCONFIGURED;
+    if (!midi_in->setThreadOptions(thread_options)) {
+        UtilityFunctions::printerr("RtMidi Error: Thread scheduling is not supported by this MIDI API");
+        return ERR_UNAVAILABLE;
+    }
+    return OK;
+}
+
+// Lock or unlock everything the MIDI thread writes per message: this object
+// (staging area, decoders, clock, state table) and the rings it publishes to.
+bool GodotRtMidiIn::lock_buffers(bool lock) {
+    const void *regions[] = {
+        this,
+        message_queues[LANE_REALTIME].storage(),
+        message_queues[LANE_NOTES].storage(),
+        message_queues[LANE_CONTROLLERS].storage(),
+        message_queues[LANE_SYSTEM].storage(),
+        broadcast ? broadcast->storage() : nullptr,
+    };
+    size_t sizes[] = {
+        sizeof(*this),
+        message_queues[LANE_REALTIME].storage_size(),
+        message_queues[LANE_NOTES].storage_size(),
+        message_queues[LANE_CONTROLLERS].storage_size(),
+        message_queues[LANE_SYSTEM].storage_size(),
+        broadcast ? broadcast->storage_size() : 0,
+    };
+    bool locked = true;
+    for (int i = 0; i < 6; i++) {
+        if (lock) {
+            locked = midi_lock_memory(regions[i], sizes[i]) && locked;
+        } else {
+            midi_unlock_memory(regions[i], sizes[i]);
+        }
+    }
+    return locked;
+}
+
+Error GodotRtMidiIn::set_memory_locked(bool locked) {
+    if (locked == memory_locked) return OK;
+    if (!locked) {
+        lock_buffers(false);
+        memory_locked = false;
+        return OK;
+    }
+    if (!lock_buffers(true)) {
+        lock_buffers(false);
+        UtilityFunctions::printerr("RtMidi Error: Could not lock MIDI buffers in memory (memlock limit too low?)");
+        return ERR_UNAUTHORIZED;
+    }
+    memory_locked = true;
+    return OK;
+}
+
+bool GodotRtMidiIn::is_memory_locked() const {
+    return memory_locked;
+}
+
+Dictionary GodotRtMidiIn::get_realtime_status() const {
+    unsigned int status = midi_in ? midi_in->getThreadStatus() : 0;
+    Dictionary result;
+    result["priority"] = (status & RtMidiThreadOptions::PRIORITY_APPLIED) != 0;
+    result["priority_failed"] = (status & RtMidiThreadOptions::PRIORITY_FAILED) != 0;
+    result["affinity"] = (status & RtMidiThreadOptions::AFFINITY_APPLIED) != 0;
+    result["affinity_failed"] = (status & RtMidiThreadOptions::AFFINITY_FAILED) != 0;
+    result["memory_locked"] = memory_locked;
+    return result;
+}
+
+Error GodotRtMidiIn::start_recording(const String &path, int64_t max_records) {
+    ERR_FAIL_COND_V(max_records < 1, ERR_INVALID_PARAMETER);
+    stop_recording();
+
+    String file_path = ProjectSettings::get_singleton()->globalize_path(path);
+    uint64_t now_ns = uint64_t(get_time() * 1000000000.0);
+    if (!recorder.open(file_path.utf8().get_data(), uint64_t(max_records), now_ns, memory_locked)) {
+        UtilityFunctions::printerr("RtMidi Error: Could not create MIDI log '", path, "'");
+        return ERR_CANT_CREATE;
+    }
+    if (memory_locked && !recorder.is_locked()) {
+        UtilityFunctions::printerr("RtMidi Error: Could not lock the MIDI log in memory (memlock limit too low?)");
+    }
+    recording.store(true);
+    return OK;
+}
+
+void GodotRtMidiIn::stop_recording() {
+    if (!recorder.is_open()) return;
+
+    // Pairs with the MIDI thread's busy-then-check: once it is seen idle
+    // here, it won't touch the log again
+    recording.store(false);
+    while (recorder_busy.load()) {
+        std::this_thread::yield();
+    }
+    recorder.close();
+}
+
+bool GodotRtMidiIn::is_recording() const {
+    return recording.load(std::memory_order_relaxed);
+}
+
+int64_t GodotRtMidiIn::get_recorded_count() const {
+    return (int64_t)recorder.get_count();
+}
+
+int64_t GodotRtMidiIn::get_recording_dropped_count() const {
+    return (int64_t)recorder.get_dropped();
+}
+
+Error GodotRtMidiIn::set_queue_capacity(int capacity) {
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        Error err = set_lane_capacity((MessageLane)lane, capacity);
+        if (err != OK) return err;
+    }
+    return OK;
+}
+
+int GodotRtMidiIn::get_queue_capacity() const {
+    int total = 0;
+    for (const MidiRing<MidiMessage> &queue : message_queues) {
+        total += (int)queue.capacity();
+    }
+    return total;
+}
+
+Error GodotRtMidiIn::set_lane_capacity(MessageLane lane, int capacity) {
+    ERR_FAIL_INDEX_V(lane, LANE_COUNT, ERR_INVALID_PARAMETER);
+    if (capacity < 1) return ERR_INVALID_PARAMETER;
+    if (broadcast) {
+        UtilityFunctions::printerr("RtMidi Error: A shared input has no lanes; each subscriber reads the broadcast ring");
+        return ERR_UNAVAILABLE;
+    }
+    if (port_open) {
+        UtilityFunctions::printerr("RtMidi Error: Queue capacity can only be changed while the port is closed");
+        return ERR_ALREADY_IN_USE;
+    }
+
+    if (memory_locked) {
+        lock_buffers(false);
+    }
+    message_queues[lane].reset(capacity);
+    if (memory_locked && !lock_buffers(true)) {
+        lock_buffers(false);
+        memory_locked = false;
+        UtilityFunctions::printerr("RtMidi Error: Could not lock the resized queue in memory");
+    }
+    return OK;
+}
+
+int GodotRtMidiIn::get_lane_capacity(MessageLane lane) const {
+    ERR_FAIL_INDEX_V(lane, LANE_COUNT, 0);
+    return (int)message_queues[lane].capacity();
+}
+
+void GodotRtMidiIn::set_overflow_policy(OverflowPolicy policy) {
+    if (broadcast) {
+        UtilityFunctions::printerr("RtMidi Error: A shared input has no lanes; each subscriber tracks its own overflow");
+        return;
+    }
+    overflow_policy.store(policy, std::memory_order_relaxed);
+}
+
+GodotRtMidiIn::OverflowPolicy GodotRtMidiIn::get_overflow_policy() const {
+    return (OverflowPolicy)overflow_policy.load(std::memory_order_relaxed);
+}
+
+int64_t GodotRtMidiIn::get_dropped_count() const {
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t> &dropped : dropped_counts) {
+        total += dropped.load(std::memory_order_relaxed);
+    }
+    return (int64_t)total;
+}
+
+int64_t GodotRtMidiIn::get_lane_dropped_count(MessageLane lane) const {
+    ERR_FAIL_INDEX_V(lane, LANE_COUNT, 0);
+    return (int64_t)dropped_counts[lane].load(std::memory_order_relaxed);
+}
+
+Error GodotRtMidiIn::set_cc_coalescing(bool enabled) {
+    if (broadcast) {
+        UtilityFunctions::printerr("RtMidi Error: CC coalescing needs the controller lane, which a shared input doesn't use");
+        return ERR_UNAVAILABLE;
+    }
+    if (port_open) {
+        UtilityFunctions::printerr("RtMidi Error: CC coalescing can only be changed while the port is closed");
+        return ERR_ALREADY_IN_USE;
+    }
+    // Nothing is queued while the port is closed, so no entry can refer
+    // to the table
+    for (int i = 0; i < CC_SLOTS; i++) {
+        unread_cc[i].store(0, std::memory_order_relaxed);
+    }
+    cc_coalescing.store(enabled, std::memory_order_release);
+    return OK;
+}
+
+bool GodotRtMidiIn::get_cc_coalescing() const {
+    return cc_coalescing.load(std::memory_order_relaxed);
+}
+
+int64_t GodotRtMidiIn::get_coalesced_count() const {
+    return (int64_t)coalesced_count.load(std::memory_order_relaxed);
+}
+
+void GodotRtMidiIn::set_cc14_pairing(int msb_controller, bool enabled) {
+    ERR_FAIL_INDEX(msb_controller, 32);
+    for (MidiParamDecoder &decoder : decoders) {
+        decoder.set_cc14_pairing(msb_controller, enabled);
+    }
+}
+
+bool GodotRtMidiIn::get_cc14_pairing(int msb_controller) const {
+    ERR_FAIL_INDEX_V(msb_controller, 32, false);
+    return decoders[0].get_cc14_pairing(msb_controller);
+}
+
+void GodotRtMidiIn::set_nrpn_decoding(bool enabled) {
+    for (MidiParamDecoder &decoder : decoders) {
+        decoder.set_nrpn_enabled(enabled);
+    }
+}
+
+bool GodotRtMidiIn::is_nrpn_decoding() const {
+    return decoders[0].is_nrpn_enabled();
+}
+
+void GodotRtMidiIn::set_data_entry_waits_for_lsb(bool wait) {
+    for (MidiParamDecoder &decoder : decoders) {
+        decoder.set_data_entry_waits_for_lsb(wait);
+    }
+}
+
+bool GodotRtMidiIn::get_data_entry_waits_for_lsb() const {
+    return decoders[0].get_data_entry_waits_for_lsb();
+}
+
 bool GodotRtMidiIn::has_message() {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    return !message_queue.empty();
+    for (const MidiRing<MidiMessage> &queue : message_queues) {
+        if (!queue.empty()) return true;
+    }
+    return coalesced_pending.load(std::memory_order_acquire) > 0;
 }
 
 Dictionary GodotRtMidiIn::poll_message() {
-    Dictionary result;
+    MidiMessage msg;
+    if (!pop_message(msg) && !take_coalesced(msg)) {
+        return Dictionary();
+    }
+    return message_to_dictionary(msg);
+}
+
+Dictionary GodotRtMidiIn::drain_messages() {
+    drain_buffer.clear();
 
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    if (message_queue.empty()) {
-        return result;
+    // Lane by lane: everything timing-critical comes before the first CC.
+    // Each lane is taken with one index update; anything arriving meanwhile
+    // waits for the next drain.
+    bool coalescing = cc_coalescing.load(std::memory_order_relaxed);
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        MidiRing<MidiMessage> &queue = message_queues[lane];
+        size_t start = drain_buffer.size();
+        drain_buffer.resize(start + queue.size());
+        size_t end = start + queue.pop_batch(drain_buffer.data() + start, drain_buffer.size() - start);
+        if (coalescing && lane == LANE_CONTROLLERS) {
+            // Same filter as pop_message(): a CC already delivered with
+            // its latest value is skipped
+            size_t kept = start;
+            for (size_t i = start; i < end; i++) {
+                if (is_plain_cc(drain_buffer[i]) && !take_unread_cc(drain_buffer[i])) {
+                    continue;
+                }
+                drain_buffer[kept++] = drain_buffer[i];
+            }
+            end = kept;
+        }
+        drain_buffer.resize(end);
+    }
+    MidiMessage msg;
+    while (take_coalesced(msg)) {
+        drain_buffer.push_back(msg);
     }
 
-    MidiMessage msg = message_queue.front();
-    message_queue.pop();
+    return messages_to_dictionary(drain_buffer);
+}
 
+Dictionary GodotRtMidiIn::message_to_dictionary(const MidiMessage &msg) {
+    Dictionary result;
     result["status"] = msg.status;
     result["data1"] = msg.data1;
     result["data2"] = msg.data2;
     result["timestamp"] = msg.timestamp;
+    result["delta"] = msg.delta;
+    result["source"] = msg.source;
+    if (msg.kind != MESSAGE_MIDI) {
+        result["kind"] = msg.kind;
+        result["param"] = msg.param;
+        result["value"] = msg.value;
+    }
+    return result;
+}
+
+Dictionary GodotRtMidiIn::messages_to_dictionary(const std::vector<MidiMessage> &messages) {
+    int64_t count = (int64_t)messages.size();
+    PackedByteArray bytes;
+    PackedFloat64Array timestamps;
+    PackedByteArray source_ids;
+    PackedByteArray kinds;
+    PackedInt32Array params;
+    PackedInt32Array values;
+    bytes.resize(count * 3);
+    timestamps.resize(count);
+    source_ids.resize(count);
+    kinds.resize(count);
+    params.resize(count);
+    values.resize(count);
 
+    uint8_t *bytes_ptr = bytes.ptrw();
+    double *times_ptr = timestamps.ptrw();
+    uint8_t *sources_ptr = source_ids.ptrw();
+    uint8_t *kinds_ptr = kinds.ptrw();
+    int32_t *params_ptr = params.ptrw();
+    int32_t *values_ptr = values.ptrw();
+    for (int64_t i = 0; i < count; i++) {
+        const MidiMessage &m = messages[i];
+        bytes_ptr[i * 3] = m.status;
+        bytes_ptr[i * 3 + 1] = m.data1;
+        bytes_ptr[i * 3 + 2] = m.data2;
+        times_ptr[i] = m.timestamp;
+        sources_ptr[i] = m.source;
+        kinds_ptr[i] = m.kind;
+        params_ptr[i] = m.param;
+        values_ptr[i] = m.value;
+    }
+
+    Dictionary result;
+    result["count"] = count;
+    result["bytes"] = bytes;
+    result["timestamps"] = timestamps;
+    result["sources"] = source_ids;
+    result["kinds"] = kinds;
+    result["params"] = params;
+    result["values"] = values;
     return result;
 }
+
+void GodotRtMidiIn::set_broadcast(const std::shared_ptr<Broadcast> &ring) {
+    ERR_FAIL_COND(port_open);
+    if (memory_locked) {
+        lock_buffers(false);
+    }
+    broadcast = ring;
+    if (memory_locked && !lock_buffers(true)) {
+        lock_buffers(false);
+        memory_locked = false;
+        UtilityFunctions::printerr("RtMidi Error: Could not lock the broadcast ring in memory");
+    }
+}
+
+double GodotRtMidiIn::get_time() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double GodotRtMidiIn::get_driver_time() const {
+    if (!midi_in) return get_time();
+    return midi_in->getDriverTimeNs() / 1000000000.0;
+}
+
+double GodotRtMidiIn::get_bpm() const {
+    return clock.get_bpm();
+}
+
+double GodotRtMidiIn::get_beat_position(double at_time) const {
+    return clock.get_beat_position(at_time < 0.0 ? get_time() : at_time);
+}
+
+double GodotRtMidiIn::get_beat_phase(double at_time) const {
+    double position = get_beat_position(at_time);
+    return position - std::floor(position);
+}
+
+double GodotRtMidiIn::get_clock_jitter() const {
+    return clock.get_state().jitter;
+}
+
+double GodotRtMidiIn::get_clock_drift() const {
+    return clock.get_state().drift;
+}
+
+bool GodotRtMidiIn::is_clock_locked() const {
+    return clock.get_state().locked;
+}
+
+bool GodotRtMidiIn::is_clock_playing() const {
+    return clock.get_state().playing;
+}
+
+float GodotRtMidiIn::get_cc(int channel, int control) const {
+    ERR_FAIL_INDEX_V(channel, MidiState::CHANNELS, 0.0f);
+    ERR_FAIL_INDEX_V(control, 128, 0.0f);
+    return state.get_cc(channel, control) / float(MidiState::MAX_VALUE);
+}
+
+float GodotRtMidiIn::get_note_velocity(int channel, int note) const {
+    ERR_FAIL_INDEX_V(channel, MidiState::CHANNELS, 0.0f);
+    ERR_FAIL_INDEX_V(note, 128, 0.0f);
+    return state.get_note(channel, note) / float(MidiState::MAX_VALUE);
+}
+
+int64_t GodotRtMidiIn::get_state_sequence() const {
+    return (int64_t)state.get_sequence();
+}
+
+PackedInt32Array GodotRtMidiIn::get_changed_ccs(int64_t since_seq) const {
+    int32_t slots[MidiState::SLOTS];
+    int count = state.get_changed_ccs(since_seq < 0 ? 0 : (uint64_t)since_seq, slots, MidiState::SLOTS);
+
+    PackedInt32Array result;
+    result.resize(count);
+    int32_t *ptr = result.ptrw();
+    for (int i = 0; i < count; i++) {
+        ptr[i] = slots[i];
+    }
+    return result;
+}
+
+PackedFloat32Array GodotRtMidiIn::get_cc_snapshot() const {
+    PackedFloat32Array result;
+    result.resize(MidiState::SLOTS);
+    float *ptr = result.ptrw();
+    for (int i = 0; i < MidiState::SLOTS; i++) {
+        ptr[i] = state.get_cc(i >> 7, i & 0x7F) / float(MidiState::MAX_VALUE);
+    }
+    return result;
+}
+
+PackedFloat32Array GodotRtMidiIn::get_note_snapshot() const {
+    PackedFloat32Array result;
+    result.resize(MidiState::SLOTS);
+    float *ptr = result.ptrw();
+    for (int i = 0; i < MidiState::SLOTS; i++) {
+        ptr[i] = state.get_note(i >> 7, i & 0x7F) / float(MidiState::MAX_VALUE);
+    }
+    return result;
+}
+
+float GodotRtMidiIn::get_nrpn(int channel, int parameter) const {
+    ERR_FAIL_INDEX_V(channel, MidiState::CHANNELS, -1.0f);
+    ERR_FAIL_INDEX_V(parameter, 16384, -1.0f);
+    int32_t value = state.get_param(false, channel, parameter);
+    return value < 0 ? -1.0f : value / float(MidiState::MAX_VALUE);
+}
+
+float GodotRtMidiIn::get_rpn(int channel, int parameter) const {
+    ERR_FAIL_INDEX_V(channel, MidiState::CHANNELS, -1.0f);
+    ERR_FAIL_INDEX_V(parameter, 16384, -1.0f);
+    int32_t value = state.get_param(true, channel, parameter);
+    return value < 0 ? -1.0f : value / float(MidiState::MAX_VALUE);
+}
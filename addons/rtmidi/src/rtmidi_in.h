@@ -5,31 +5,242 @@
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/packed_string_array.hpp>
 #include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_float32_array.hpp>
+#include <godot_cpp/variant/packed_float64_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 #include <RtMidi.h>
-#include <mutex>
-#include <queue>
+#include "midi_broadcast.h"
+#include "midi_clock.h"
+#include "midi_log.h"
+#include "midi_param_decoder.h"
+#include "midi_ring.h"
+#include "midi_state.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace godot {
 
 class GodotRtMidiIn : public RefCounted {
     GDCLASS(GodotRtMidiIn, RefCounted)
 
-private:
-    ::RtMidiIn *midi_in = nullptr;
-    std::mutex queue_mutex;
+public:
+    // What the MIDI thread does when the message queue is full
+    enum OverflowPolicy {
+        OVERFLOW_DROP_OLDEST,
+        OVERFLOW_DROP_NEWEST,
+        OVERFLOW_COALESCE,  // Keep only the latest value per CC, drop other messages
+    };
+
+    // Capability bits reported by get_ports()
+    enum PortCapability {
+        PORT_INPUT = RtMidiPortInfo::INPUT,
+        PORT_OUTPUT = RtMidiPortInfo::OUTPUT,
+        PORT_HARDWARE = RtMidiPortInfo::HARDWARE,
+        PORT_SOFTWARE = RtMidiPortInfo::SOFTWARE,
+    };
+
+    // Message kinds reported by poll_message()/drain_messages()
+    enum MessageKind {
+        MESSAGE_MIDI = MidiParamDecoder::KIND_MIDI,
+        MESSAGE_CC14 = MidiParamDecoder::KIND_CC14,
+        MESSAGE_NRPN = MidiParamDecoder::KIND_NRPN,
+        MESSAGE_RPN = MidiParamDecoder::KIND_RPN,
+    };
+
+    // Priority lanes. Each has its own ring, and draining empties them in
+    // this order, so clock and transport never wait behind a CC backlog,
+    // and a SysEx dump or MTC stream can't crowd out clock ticks.
+    enum MessageLane {
+        LANE_REALTIME,     // System realtime (0xF8-0xFF): clock, transport
+        LANE_NOTES,        // Notes, poly pressure, program change
+        LANE_CONTROLLERS,  // CC, channel pressure, pitch bend, merged 14-bit
+        LANE_SYSTEM,       // SysEx and system common: MTC, song position/select
+        LANE_COUNT,
+    };
+
+    // Source ids tagged on messages (see add_source())
+    enum SourceLimits {
+        MAX_SOURCES = RtMidiIn::MAX_SOURCES,
+        SOURCE_UNKNOWN = RtMidiIn::UNKNOWN_SOURCE,  // Virtual port writers, coalesced CCs
+    };
+
+    // Scheduling policies for set_thread_priority()
+    enum ThreadPolicy {
+        THREAD_NORMAL = RtMidiThreadOptions::NORMAL,
+        THREAD_FIFO = RtMidiThreadOptions::FIFO,
+        THREAD_ROUND_ROBIN = RtMidiThreadOptions::ROUND_ROBIN,
+    };
+
+    // Message type bits for set_message_filter()
+    enum MessageFilter {
+        FILTER_NOTE_OFF = RtMidiFilter::NOTE_OFF,
+        FILTER_NOTE_ON = RtMidiFilter::NOTE_ON,
+        FILTER_POLY_PRESSURE = RtMidiFilter::POLY_PRESSURE,
+        FILTER_CONTROL_CHANGE = RtMidiFilter::CONTROL_CHANGE,
+        FILTER_PROGRAM_CHANGE = RtMidiFilter::PROGRAM_CHANGE,
+        FILTER_CHANNEL_PRESSURE = RtMidiFilter::CHANNEL_PRESSURE,
+        FILTER_PITCH_BEND = RtMidiFilter::PITCH_BEND,
+        FILTER_SYSEX = RtMidiFilter::SYSEX,
+        FILTER_TIME_CODE = RtMidiFilter::TIME_CODE,
+        FILTER_SONG_POSITION = RtMidiFilter::SONG_POSITION,
+        FILTER_SONG_SELECT = RtMidiFilter::SONG_SELECT,
+        FILTER_TUNE_REQUEST = RtMidiFilter::TUNE_REQUEST,
+        FILTER_CLOCK = RtMidiFilter::CLOCK,
+        FILTER_TICK = RtMidiFilter::TICK,
+        FILTER_START = RtMidiFilter::START,
+        FILTER_CONTINUE = RtMidiFilter::CONTINUE,
+        FILTER_STOP = RtMidiFilter::STOP,
+        FILTER_ACTIVE_SENSING = RtMidiFilter::ACTIVE_SENSING,
+        FILTER_RESET = RtMidiFilter::RESET,
+        FILTER_ALL = RtMidiFilter::ALL_TYPES,
+    };
+
+    static const int DEFAULT_QUEUE_CAPACITY = 4096;  // Controller lane
+    static const int DEFAULT_LANE_CAPACITY = 1024;   // Realtime, note and system lanes
 
     struct MidiMessage {
         unsigned char status;
         unsigned char data1;
         unsigned char data2;
-        double timestamp;
+        double timestamp;  // Absolute monotonic driver time, seconds
+        double delta;      // Seconds since the previous message
+        // Merged 14-bit events (kind != MESSAGE_MIDI) keep a 7-bit view in
+        // status/data1/data2 and carry the full value here
+        uint8_t kind;
+        uint8_t source;    // Source id from add_source(), 0 for open_port()
+        uint16_t param;
+        uint16_t value;
     };
 
-    std::queue<MidiMessage> message_queue;
+    typedef MidiBroadcast<MidiMessage> Broadcast;
+
+private:
+    ::RtMidiIn *midi_in = nullptr;
+
+    // Written only by the MIDI thread, read only by the main thread. One
+    // ring per MessageLane.
+    MidiRing<MidiMessage> message_queues[LANE_COUNT];
+    std::atomic<int> overflow_policy{ OVERFLOW_DROP_OLDEST };
+    std::atomic<uint64_t> dropped_counts[LANE_COUNT];
+
+    // When set, messages are published here for any number of readers
+    // instead of going to message_queues
+    std::shared_ptr<Broadcast> broadcast;
+
+    // Latest value of each (channel, controller) that overflowed the queue
+    // under OVERFLOW_COALESCE. Packed as time_ns << 8 | pending << 7 | value.
+    static const int CC_SLOTS = 16 * 128;
+    static const uint64_t CC_PENDING = 0x80;
+    std::atomic<uint64_t> coalesced_cc[CC_SLOTS];
+    std::atomic<int> coalesced_pending{ 0 };
+    int coalesce_scan = 0;
+
+    // Per-frame CC coalescing (set_cc_coalescing()). The controller lane
+    // holds at most one unread entry per (channel, controller); a newer
+    // value lands in unread_cc instead, packed like coalesced_cc, and the
+    // main thread picks up the latest one when it pops the entry.
+    // unread_cc_index is the ring index of that entry (MIDI thread only).
+    std::atomic<bool> cc_coalescing{ false };
+    std::atomic<uint64_t> unread_cc[CC_SLOTS];
+    uint64_t unread_cc_index[CC_SLOTS];
+    std::atomic<uint64_t> coalesced_count{ 0 };
+
+    // Merge 14-bit CC pairs and NRPN/RPN sequences on the MIDI thread. One
+    // per source, so interleaved sequences from two devices don't mix;
+    // configuration is applied to all of them.
+    MidiParamDecoder decoders[MAX_SOURCES + 1];
+    uint32_t decoders_holding = 0;  // Bit per decoder that consumed a message this batch
+
+    // Fed with clock/transport messages on the MIDI thread
+    MidiClock clock;
+
+    // Latest CC and note values, updated on the MIDI thread
+    MidiState state;
+
+    // MIDI thread: messages decoded from the current driver batch, published
+    // with one commit per lane
+    static const int STAGING_SIZE = 512;
+    MidiMessage staged[STAGING_SIZE];
+    int staged_count = 0;
+    MidiMessage lane_staged[STAGING_SIZE];
+
+    // Reused by drain_messages() so draining doesn't allocate per frame
+    std::vector<MidiMessage> drain_buffer;
+
     bool port_open = false;
 
-    static void midi_callback(double timestamp, std::vector<unsigned char>* message, void* userData);
+    // Port hotplug. The MIDI thread forwards announce events through
+    // port_events and schedules one _flush_port_events() per burst; the
+    // main thread applies them to port_table, which then serves every port
+    // listing without enumerating the driver again.
+    static const int PORT_NAME_SIZE = 160;
+    static const int PORT_EVENT_CAPACITY = 64;
+    struct PortEvent {
+        int32_t change;  // RtMidiPortInfo::Change
+        int32_t client;
+        int32_t port;
+        uint32_t capabilities;
+        char name[PORT_NAME_SIZE];
+    };
+    MidiRing<PortEvent> port_events;
+    std::atomic<bool> port_events_lost{ false };  // ring was full, resync
+    std::atomic<bool> port_flush_pending{ false };
+    bool watching_ports = false;  // backend reports changes, port_table is live
+
+    // Main thread: input ports in enumeration order
+    std::vector<RtMidiPortInfo> port_table;
+    // Subscribed sources, source 0 first. A source whose device disappears
+    // keeps its id and name (client = -1) so it can be resubscribed when
+    // the device comes back.
+    struct SourceEntry {
+        int id;
+        int client;
+        int port;
+        std::string name;
+    };
+    std::vector<SourceEntry> sources;
+    bool virtual_port = false;
+    bool auto_reconnect = true;
+
+    // Session recording. The MIDI thread appends only while recording is
+    // set and holds recorder_busy meanwhile, so stop_recording() can wait
+    // it out before unmapping the log; the MIDI thread never waits.
+    MidiLogWriter recorder;
+    std::atomic<bool> recording{ false };
+    std::atomic<bool> recorder_busy{ false };
+
+    // Input thread scheduling, reapplied when the input is recreated
+    RtMidiThreadOptions thread_options;
+    bool memory_locked = false;
+
+    static void midi_batch_callback(const RtMidiEvent* events, unsigned int count, void* userData);
+    static void midi_port_callback(int change, const RtMidiPortInfo &port, void* userData);
+    const std::vector<RtMidiPortInfo> &get_input_ports();
+    bool apply_port_change(int change, const RtMidiPortInfo &port);
+    bool resync_ports();
+    void on_port_added(const RtMidiPortInfo &port);
+    void on_port_removed(const RtMidiPortInfo &port);
+    void release_port();
+    std::string find_port_name(int client, int port);
+    void process_event(const RtMidiEvent &event);
+    void enqueue(const MidiMessage &msg);
+    void commit_staged();
+    void commit_lane(int lane, MidiMessage *messages, int count);
+    int coalesce_unread_ccs(MidiMessage *messages, int count);
+    bool take_unread_cc(MidiMessage &msg);
+    bool pop_message(MidiMessage &msg);
+    void enqueue_param(const MidiParamDecoder::Event &event, const MidiMessage &source);
+    void flush_decoders();
+    bool take_coalesced(MidiMessage &msg);
+    void clear_queue();
+    void create_input(RtMidi::Api api);
+    void destroy_input();
+    Error apply_thread_options();
+    bool lock_buffers(bool lock);
 
 protected:
     static void _bind_methods();
@@ -41,19 +252,164 @@ public:
     // Device management
     PackedStringArray get_port_names();
     int get_port_count();
+    // Single-pass snapshot: {"names", "clients", "ports", "capabilities"},
+    // indexed like get_port_names(). (client, port) is a stable address.
+    Dictionary get_ports();
     Error open_port(int port_number);
+    Error open_port_address(int client, int port);
     Error open_virtual_port(const String &name);
     void close_port();
     bool is_port_open() const;
+    // Backend by RtMidi API name: "alsa", "rawmidi", "core", "winmm", or
+    // "dummy" for the in-process loopback fed by an RtMidiOut; "" picks
+    // the default.
+    // Recreates the input, so the port must be closed. Filters carry over,
+    // ignore_types() is reset.
+    Error set_api(const String &name);
+    String get_api() const;
+
+    // Multiple sources on one input: one sequencer client, one thread, one
+    // queue and one clock. Returns the source id tagged on messages, or -1.
+    // Opens the input if no port is open yet.
+    int add_source(int port_number);
+    int add_source_address(int client, int port);
+    Error remove_source(int source);
+    // {"ids", "names", "clients", "ports"}; client is -1 while disconnected
+    Dictionary get_sources() const;
+
+    // Hotplug: reopen the last opened port by name when it reappears.
+    // Port signals are emitted from the main thread.
+    void set_auto_reconnect(bool enabled);
+    bool get_auto_reconnect() const;
+    // Name of source 0, or of the port waiting to be reconnected
+    String get_open_port_name() const;
+    void _flush_port_events();
 
     // Configure message filtering
     void ignore_types(bool sysex, bool timing, bool active_sense);
+    // Finer filter on top of ignore_types(): MessageFilter bits, a bit per
+    // channel, and the note range for note on/off and poly pressure.
+    // Applied in the kernel where the backend supports it.
+    void set_message_filter(int64_t types, int channel_mask = 0xFFFF, int note_low = 0, int note_high = 127);
+    int64_t get_message_filter() const;
+    // Drop clock/tick between Stop and the next Start/Continue
+    void set_clock_while_stopped(bool enabled);
+    bool get_clock_while_stopped() const;
+
+    // Realtime behaviour of the MIDI thread. Requests the OS refuses (no
+    // CAP_SYS_NICE, RLIMIT_RTPRIO or RLIMIT_MEMLOCK) are reported and leave
+    // the thread running as before; get_realtime_status() tells what took
+    // effect: {"priority", "priority_failed", "affinity", "affinity_failed",
+    // "memory_locked"}. Thread settings apply to ALSA and raw MIDI.
+    Error set_thread_priority(ThreadPolicy policy, int priority);
+    Error set_thread_affinity(const PackedInt32Array &cpus);
+    // Lock the queue, staging area and state tables in RAM
+    Error set_memory_locked(bool locked);
+    bool is_memory_locked() const;
+    Dictionary get_realtime_status() const;
+
+    // Session recording: every event the input delivers, before decoding,
+    // appended from the MIDI thread to a preallocated memory-mapped log
+    // (format in midi_log.h), locked in RAM too under set_memory_locked().
+    // Replay with GodotRtMidiOut::play_log().
+    Error start_recording(const String &path, int64_t max_records = 1 << 20);
+    void stop_recording();
+    bool is_recording() const;
+    // Records written (SysEx spans several) and events that didn't fit
+    int64_t get_recorded_count() const;
+    int64_t get_recording_dropped_count() const;
+
+    // Queue configuration (capacity can only change while no port is open).
+    // set_queue_capacity() sizes every lane; get_queue_capacity() and
+    // get_dropped_count() are totals over the lanes. The hub's shared input
+    // publishes to its subscribers instead and refuses these setters and
+    // set_cc_coalescing().
+    Error set_queue_capacity(int capacity);
+    int get_queue_capacity() const;
+    Error set_lane_capacity(MessageLane lane, int capacity);
+    int get_lane_capacity(MessageLane lane) const;
+    void set_overflow_policy(OverflowPolicy policy);
+    OverflowPolicy get_overflow_policy() const;
+    int64_t get_dropped_count() const;
+    int64_t get_lane_dropped_count(MessageLane lane) const;
+    // Per-frame CC coalescing: a CC whose (channel, controller) still has
+    // an unread message updates that message instead of queueing another,
+    // so the controller lane grows with the number of distinct controllers
+    // moved, not with message rate. Only while the port is closed.
+    Error set_cc_coalescing(bool enabled);
+    bool get_cc_coalescing() const;
+    // CC messages merged into an unread one
+    int64_t get_coalesced_count() const;
+    static MessageLane message_lane(const MidiMessage &msg);
+
+    // 14-bit controller decoding. CC pairing is off by default; enable it per
+    // MSB controller (0-31). NRPN/RPN decoding is on by default.
+    void set_cc14_pairing(int msb_controller, bool enabled);
+    bool get_cc14_pairing(int msb_controller) const;
+    void set_nrpn_decoding(bool enabled);
+    bool is_nrpn_decoding() const;
+    // Hold Data Entry MSB for its LSB (default). Only held until the end
+    // of the driver batch it arrived in; a later LSB refines the value.
+    void set_data_entry_waits_for_lsb(bool wait);
+    bool get_data_entry_waits_for_lsb() const;
 
-    // Message polling (call from _process)
+    // Message polling (call from _process). Lanes are emptied in priority
+    // order, each in arrival order.
     bool has_message();
     Dictionary poll_message();
+
+    // Drain every pending message at once: {"count", "bytes", "timestamps",
+    // "sources", "kinds", "params", "values"} where bytes holds
+    // status/data1/data2 triplets and the last three describe merged 14-bit
+    // events
+    Dictionary drain_messages();
+
+    // Dictionary layouts of poll_message() and drain_messages(), shared
+    // with GodotRtMidiSubscriber
+    static Dictionary message_to_dictionary(const MidiMessage &msg);
+    static Dictionary messages_to_dictionary(const std::vector<MidiMessage> &messages);
+
+    // Publish to a broadcast ring instead of the message queue (used by
+    // GodotRtMidiHub). Not bound; set before opening a port and before
+    // configuring lanes or coalescing.
+    void set_broadcast(const std::shared_ptr<Broadcast> &ring);
+
+    // MIDI clock tracking. Times are seconds on the same monotonic clock as
+    // message timestamps; pass a negative at_time to mean "now".
+    double get_time() const;
+    // Now on the clock the driver stamps messages with (the ALSA queue),
+    // nominally get_time() but free to drift from it; see
+    // GodotRtMidiTimeMap
+    double get_driver_time() const;
+    double get_bpm() const;
+    double get_beat_position(double at_time = -1.0) const;
+    double get_beat_phase(double at_time = -1.0) const;
+    double get_clock_jitter() const;
+    double get_clock_drift() const;
+    bool is_clock_locked() const;
+    bool is_clock_playing() const;
+
+    // Latest controller/note state, readable without draining the queue.
+    // Values are normalized to 0..1; CC slots are indexed channel * 128 + cc.
+    float get_cc(int channel, int control) const;
+    float get_note_velocity(int channel, int note) const;
+    int64_t get_state_sequence() const;
+    PackedInt32Array get_changed_ccs(int64_t since_seq) const;
+    PackedFloat32Array get_cc_snapshot() const;
+    PackedFloat32Array get_note_snapshot() const;
+    // Latest NRPN/RPN value normalized to 0..1, or -1 if never received
+    float get_nrpn(int channel, int parameter) const;
+    float get_rpn(int channel, int parameter) const;
 };
 
 }
 
+VARIANT_ENUM_CAST(GodotRtMidiIn::OverflowPolicy);
+VARIANT_ENUM_CAST(GodotRtMidiIn::PortCapability);
+VARIANT_ENUM_CAST(GodotRtMidiIn::MessageKind);
+VARIANT_ENUM_CAST(GodotRtMidiIn::MessageLane);
+VARIANT_ENUM_CAST(GodotRtMidiIn::SourceLimits);
+VARIANT_ENUM_CAST(GodotRtMidiIn::MessageFilter);
+VARIANT_ENUM_CAST(GodotRtMidiIn::ThreadPolicy);
+
 #endif // GODOT_RTMIDI_IN_H
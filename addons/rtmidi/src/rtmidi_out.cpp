@@ -0,0 +1,473 @@
+#include "rtmidi_out.h"
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+#include <algorithm>
+#include <chrono>
+
+using namespace godot;
+
+void GodotRtMidiOut::_bind_methods() {
+    // Device management
+    ClassDB::bind_method(D_METHOD("get_port_names"), &GodotRtMidiOut::get_port_names);
+    ClassDB::bind_method(D_METHOD("get_port_count"), &GodotRtMidiOut::get_port_count);
+    ClassDB::bind_method(D_METHOD("get_ports"), &GodotRtMidiOut::get_ports);
+    ClassDB::bind_method(D_METHOD("open_port", "port_number"), &GodotRtMidiOut::open_port);
+    ClassDB::bind_method(D_METHOD("open_port_address", "client", "port"), &GodotRtMidiOut::open_port_address);
+    ClassDB::bind_method(D_METHOD("open_virtual_port", "name"), &GodotRtMidiOut::open_virtual_port);
+    ClassDB::bind_method(D_METHOD("close_port"), &GodotRtMidiOut::close_port);
+    ClassDB::bind_method(D_METHOD("is_port_open"), &GodotRtMidiOut::is_port_open);
+    ClassDB::bind_method(D_METHOD("set_api", "name"), &GodotRtMidiOut::set_api);
+    ClassDB::bind_method(D_METHOD("get_api"), &GodotRtMidiOut::get_api);
+
+    // Sending
+    ClassDB::bind_method(D_METHOD("send_message", "message", "at_time"), &GodotRtMidiOut::send_message, DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("send_note_on", "channel", "note", "velocity", "at_time"), &GodotRtMidiOut::send_note_on, DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("send_note_off", "channel", "note", "velocity", "at_time"), &GodotRtMidiOut::send_note_off, DEFVAL(0), DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("send_control_change", "channel", "control", "value", "at_time"), &GodotRtMidiOut::send_control_change, DEFVAL(-1.0));
+
+    // Batching
+    ClassDB::bind_method(D_METHOD("flush"), &GodotRtMidiOut::flush);
+    ClassDB::bind_method(D_METHOD("get_pending_count"), &GodotRtMidiOut::get_pending_count);
+    ClassDB::bind_method(D_METHOD("set_auto_flush", "enabled"), &GodotRtMidiOut::set_auto_flush);
+    ClassDB::bind_method(D_METHOD("get_auto_flush"), &GodotRtMidiOut::get_auto_flush);
+    ClassDB::bind_method(D_METHOD("get_time"), &GodotRtMidiOut::get_time);
+
+    // Clock master
+    ClassDB::bind_method(D_METHOD("start_clock", "bpm"), &GodotRtMidiOut::start_clock, DEFVAL(120.0));
+    ClassDB::bind_method(D_METHOD("stop_clock"), &GodotRtMidiOut::stop_clock);
+    ClassDB::bind_method(D_METHOD("is_clock_running"), &GodotRtMidiOut::is_clock_running);
+    ClassDB::bind_method(D_METHOD("set_clock_bpm", "bpm"), &GodotRtMidiOut::set_clock_bpm);
+    ClassDB::bind_method(D_METHOD("get_clock_bpm"), &GodotRtMidiOut::get_clock_bpm);
+    ClassDB::bind_method(D_METHOD("clock_start"), &GodotRtMidiOut::clock_start);
+    ClassDB::bind_method(D_METHOD("clock_stop"), &GodotRtMidiOut::clock_stop);
+    ClassDB::bind_method(D_METHOD("clock_continue"), &GodotRtMidiOut::clock_continue);
+    ClassDB::bind_method(D_METHOD("set_song_position", "sixteenths"), &GodotRtMidiOut::set_song_position);
+    ClassDB::bind_method(D_METHOD("get_song_position"), &GodotRtMidiOut::get_song_position);
+    ClassDB::bind_method(D_METHOD("is_clock_playing"), &GodotRtMidiOut::is_clock_playing);
+    ClassDB::bind_method(D_METHOD("get_clock_stats"), &GodotRtMidiOut::get_clock_stats);
+
+    // Session log playback
+    ClassDB::bind_method(D_METHOD("play_log", "path", "realtime"), &GodotRtMidiOut::play_log, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("stop_log"), &GodotRtMidiOut::stop_log);
+    ClassDB::bind_method(D_METHOD("is_playing_log"), &GodotRtMidiOut::is_playing_log);
+    ClassDB::bind_method(D_METHOD("get_log_position"), &GodotRtMidiOut::get_log_position);
+    ClassDB::bind_method(D_METHOD("get_log_length"), &GodotRtMidiOut::get_log_length);
+
+    // MIDI file playback
+    ClassDB::bind_method(D_METHOD("open_file", "path"), &GodotRtMidiOut::open_file);
+    ClassDB::bind_method(D_METHOD("close_file"), &GodotRtMidiOut::close_file);
+    ClassDB::bind_method(D_METHOD("play_file"), &GodotRtMidiOut::play_file);
+    ClassDB::bind_method(D_METHOD("pause_file"), &GodotRtMidiOut::pause_file);
+    ClassDB::bind_method(D_METHOD("stop_file"), &GodotRtMidiOut::stop_file);
+    ClassDB::bind_method(D_METHOD("seek_file", "position"), &GodotRtMidiOut::seek_file);
+    ClassDB::bind_method(D_METHOD("is_playing_file"), &GodotRtMidiOut::is_playing_file);
+    ClassDB::bind_method(D_METHOD("get_file_position"), &GodotRtMidiOut::get_file_position);
+    ClassDB::bind_method(D_METHOD("get_file_length"), &GodotRtMidiOut::get_file_length);
+    ClassDB::bind_method(D_METHOD("set_file_clock", "enabled"), &GodotRtMidiOut::set_file_clock);
+    ClassDB::bind_method(D_METHOD("get_file_clock"), &GodotRtMidiOut::get_file_clock);
+}
+
+GodotRtMidiOut::GodotRtMidiOut() {
+    create_output(RtMidi::UNSPECIFIED);
+}
+
+GodotRtMidiOut::~GodotRtMidiOut() {
+    destroy_output();
+}
+
+void GodotRtMidiOut::create_output(RtMidi::Api api) {
+    midi_out = new RtMidiOut(api, "Godot Visualizer");
+}
+
+void GodotRtMidiOut::destroy_output() {
+    if (midi_out) {
+        close_port();
+        delete midi_out;
+        midi_out = nullptr;
+    }
+}
+
+PackedStringArray GodotRtMidiOut::get_port_names() {
+    PackedStringArray names;
+    if (!midi_out) return names;
+
+    for (const RtMidiPortInfo &info : midi_out->getPorts()) {
+        names.push_back(String(info.name.c_str()));
+    }
+
+    return names;
+}
+
+int GodotRtMidiOut::get_port_count() {
+    if (!midi_out) return 0;
+    return (int)midi_out->getPortCount();
+}
+
+Dictionary GodotRtMidiOut::get_ports() {
+    Dictionary result;
+    PackedStringArray names;
+    PackedInt32Array clients;
+    PackedInt32Array ports;
+    PackedInt32Array capabilities;
+
+    if (midi_out) {
+        std::vector<RtMidiPortInfo> infos = midi_out->getPorts();
+        int64_t count = (int64_t)infos.size();
+        clients.resize(count);
+        ports.resize(count);
+        capabilities.resize(count);
+        for (int64_t i = 0; i < count; i++) {
+            names.push_back(String(infos[i].name.c_str()));
+            clients.set(i, infos[i].client);
+            ports.set(i, infos[i].port);
+            capabilities.set(i, (int32_t)infos[i].capabilities);
+        }
+    }
+
+    result["names"] = names;
+    result["clients"] = clients;
+    result["ports"] = ports;
+    result["capabilities"] = capabilities;
+    return result;
+}
+
+Error GodotRtMidiOut::open_port(int port_number) {
+    if (!midi_out) return ERR_UNCONFIGURED;
+
+    std::vector<RtMidiPortInfo> ports = midi_out->getPorts();
+    if (port_number < 0 || (size_t)port_number >= ports.size()) {
+        UtilityFunctions::printerr("RtMidi Error: Invalid output port number");
+        return ERR_CANT_OPEN;
+    }
+
+    return open_port_address(ports[port_number].client, ports[port_number].port);
+}
+
+Error GodotRtMidiOut::open_port_address(int client, int port) {
+    if (!midi_out) return ERR_UNCONFIGURED;
+
+    close_port();
+    midi_out->openPortAddress(client, port, "Godot MIDI Out");
+    port_open = midi_out->isPortOpen();
+
+    if (!port_open) {
+        UtilityFunctions::printerr("RtMidi Error: Failed to open output port");
+        return ERR_CANT_OPEN;
+    }
+
+    return OK;
+}
+
+Error GodotRtMidiOut::open_virtual_port(const String &name) {
+    if (!midi_out) return ERR_UNCONFIGURED;
+
+    close_port();
+    midi_out->openVirtualPort(name.utf8().get_data());
+    port_open = midi_out->isPortOpen();
+
+    if (!port_open) {
+        UtilityFunctions::printerr("RtMidi Error: Failed to open virtual output port");
+        return ERR_CANT_OPEN;
+    }
+
+    return OK;
+}
+
+void GodotRtMidiOut::close_port() {
+    if (!midi_out) return;
+
+    // The clock and playback threads send through midi_out, so they go first
+    clock_generator.stop_clock();
+    log_player.stop();
+    file_player.pause();
+    // Whatever was queued for the old destination is dropped
+    pending.clear();
+    pending_bytes.clear();
+    midi_out->closePort();
+    port_open = false;
+}
+
+bool GodotRtMidiOut::is_port_open() const {
+    return port_open && midi_out != nullptr;
+}
+
+Error GodotRtMidiOut::set_api(const String &name) {
+    ERR_FAIL_COND_V(port_open, ERR_ALREADY_IN_USE);
+
+    RtMidi::Api api = RtMidi::UNSPECIFIED;
+    if (!name.is_empty()) {
+        api = RtMidi::getCompiledApiByName(name.utf8().get_data());
+        if (api == RtMidi::UNSPECIFIED) {
+            UtilityFunctions::printerr("RtMidi Error: API '", name, "' is not compiled in");
+            return ERR_UNAVAILABLE;
+        }
+    }
+
+    destroy_output();
+    create_output(api);
+    if (!midi_out || midi_out->getCurrentApi() == RtMidi::UNSPECIFIED) return ERR_CANT_CREATE;
+    return OK;
+}
+
+String GodotRtMidiOut::get_api() const {
+    if (!midi_out) return String();
+    return String(RtMidi::getApiName(midi_out->getCurrentApi()).c_str());
+}
+
+void GodotRtMidiOut::queue_message(const unsigned char *data, size_t size, double at_time) {
+    PendingMessage message;
+    message.time_ns = at_time > 0.0 ? (uint64_t)(at_time * 1000000000.0) : 0;
+    message.offset = (uint32_t)pending_bytes.size();
+    message.size = (uint32_t)size;
+    pending_bytes.insert(pending_bytes.end(), data, data + size);
+    pending.push_back(message);
+
+    // One deferred flush per frame, however many messages are queued
+    if (auto_flush && !flush_pending) {
+        flush_pending = true;
+        call_deferred("flush");
+    }
+}
+
+Error GodotRtMidiOut::send_message(const PackedByteArray &message, double at_time) {
+    ERR_FAIL_COND_V(message.is_empty() || message[0] < 0x80, ERR_INVALID_PARAMETER);
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+
+    queue_message(message.ptr(), (size_t)message.size(), at_time);
+    return OK;
+}
+
+Error GodotRtMidiOut::send_note_on(int channel, int note, int velocity, double at_time) {
+    ERR_FAIL_COND_V(channel < 0 || channel > 15, ERR_INVALID_PARAMETER);
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+
+    const unsigned char bytes[3] = { (unsigned char)(0x90 | channel), (unsigned char)(note & 0x7F), (unsigned char)(velocity & 0x7F) };
+    queue_message(bytes, 3, at_time);
+    return OK;
+}
+
+Error GodotRtMidiOut::send_note_off(int channel, int note, int velocity, double at_time) {
+    ERR_FAIL_COND_V(channel < 0 || channel > 15, ERR_INVALID_PARAMETER);
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+
+    const unsigned char bytes[3] = { (unsigned char)(0x80 | channel), (unsigned char)(note & 0x7F), (unsigned char)(velocity & 0x7F) };
+    queue_message(bytes, 3, at_time);
+    return OK;
+}
+
+Error GodotRtMidiOut::send_control_change(int channel, int control, int value, double at_time) {
+    ERR_FAIL_COND_V(channel < 0 || channel > 15, ERR_INVALID_PARAMETER);
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+
+    const unsigned char bytes[3] = { (unsigned char)(0xB0 | channel), (unsigned char)(control & 0x7F), (unsigned char)(value & 0x7F) };
+    queue_message(bytes, 3, at_time);
+    return OK;
+}
+
+void GodotRtMidiOut::flush() {
+    flush_pending = false;
+    if (pending.empty() || !is_port_open()) return;
+
+    // pending_bytes has stopped growing, so pointers into it stay valid
+    // for the duration of the send
+    flush_events.resize(pending.size());
+    for (size_t i = 0; i < pending.size(); i++) {
+        RtMidiEvent &event = flush_events[i];
+        const PendingMessage &message = pending[i];
+        event.timeNs = message.time_ns;
+        event.deltaTime = 0.0;
+        event.size = message.size;
+        event.source = RtMidiIn::UNKNOWN_SOURCE;
+        if (message.size <= 3) {
+            event.sysex = nullptr;
+            for (uint32_t b = 0; b < message.size; b++) {
+                event.bytes[b] = pending_bytes[message.offset + b];
+            }
+        } else {
+            event.sysex = pending_bytes.data() + message.offset;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        midi_out->sendEvents(flush_events.data(), (unsigned int)flush_events.size());
+    }
+    pending.clear();
+    pending_bytes.clear();
+}
+
+int GodotRtMidiOut::get_pending_count() const {
+    return (int)pending.size();
+}
+
+void GodotRtMidiOut::set_auto_flush(bool enabled) {
+    auto_flush = enabled;
+}
+
+bool GodotRtMidiOut::get_auto_flush() const {
+    return auto_flush;
+}
+
+double GodotRtMidiOut::get_time() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Clock thread
+void GodotRtMidiOut::clock_send(const unsigned char *message, size_t size, void *user_data) {
+    GodotRtMidiOut *self = static_cast<GodotRtMidiOut *>(user_data);
+    std::lock_guard<std::mutex> lock(self->send_mutex);
+    self->midi_out->sendMessage(message, size);
+}
+
+Error GodotRtMidiOut::start_clock(double bpm) {
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+    ERR_FAIL_COND_V(clock_generator.is_running(), ERR_ALREADY_IN_USE);
+
+    if (!clock_generator.start_clock(bpm)) return ERR_CANT_CREATE;
+    return OK;
+}
+
+void GodotRtMidiOut::stop_clock() {
+    clock_generator.stop_clock();
+}
+
+bool GodotRtMidiOut::is_clock_running() const {
+    return clock_generator.is_running();
+}
+
+void GodotRtMidiOut::set_clock_bpm(double bpm) {
+    clock_generator.set_bpm(bpm);
+}
+
+double GodotRtMidiOut::get_clock_bpm() const {
+    return clock_generator.get_bpm();
+}
+
+void GodotRtMidiOut::clock_start() {
+    clock_generator.transport_start();
+}
+
+void GodotRtMidiOut::clock_stop() {
+    clock_generator.transport_stop();
+}
+
+void GodotRtMidiOut::clock_continue() {
+    clock_generator.transport_continue();
+}
+
+void GodotRtMidiOut::set_song_position(int sixteenths) {
+    clock_generator.set_song_position(sixteenths);
+}
+
+int64_t GodotRtMidiOut::get_song_position() const {
+    return clock_generator.get_song_position();
+}
+
+bool GodotRtMidiOut::is_clock_playing() const {
+    return clock_generator.is_playing();
+}
+
+Dictionary GodotRtMidiOut::get_clock_stats() const {
+    MidiClockGenerator::Stats stats = clock_generator.get_stats();
+    Dictionary result;
+    result["ticks"] = (int64_t)stats.ticks;
+    result["last_error"] = stats.last_error;
+    result["max_error"] = stats.max_error;
+    result["mean_error"] = stats.mean_error;
+    result["drift"] = stats.drift;
+    result["resyncs"] = (int64_t)stats.resyncs;
+    return result;
+}
+
+// Log and MIDI file playback threads
+void GodotRtMidiOut::log_send(const RtMidiEvent *events, unsigned int count, void *user_data) {
+    GodotRtMidiOut *self = static_cast<GodotRtMidiOut *>(user_data);
+    std::lock_guard<std::mutex> lock(self->send_mutex);
+    self->midi_out->sendEvents(events, count);
+}
+
+Error GodotRtMidiOut::play_log(const String &path, bool realtime) {
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+
+    String file_path = ProjectSettings::get_singleton()->globalize_path(path);
+    if (!log_player.start(file_path.utf8().get_data(), realtime)) {
+        UtilityFunctions::printerr("RtMidi Error: Could not open MIDI log '", path, "'");
+        return ERR_FILE_CANT_OPEN;
+    }
+    return OK;
+}
+
+void GodotRtMidiOut::stop_log() {
+    log_player.stop();
+}
+
+bool GodotRtMidiOut::is_playing_log() const {
+    return log_player.is_playing();
+}
+
+int64_t GodotRtMidiOut::get_log_position() const {
+    return (int64_t)log_player.get_position();
+}
+
+int64_t GodotRtMidiOut::get_log_length() const {
+    return (int64_t)log_player.get_length();
+}
+
+Error GodotRtMidiOut::open_file(const String &path) {
+    String file_path = ProjectSettings::get_singleton()->globalize_path(path);
+    if (!file_player.open(file_path.utf8().get_data())) {
+        UtilityFunctions::printerr("RtMidi Error: Could not read MIDI file '", path, "'");
+        return ERR_FILE_CORRUPT;
+    }
+    return OK;
+}
+
+void GodotRtMidiOut::close_file() {
+    file_player.close();
+}
+
+Error GodotRtMidiOut::play_file() {
+    if (!is_port_open()) return ERR_UNCONFIGURED;
+    ERR_FAIL_COND_V(!file_player.is_open(), ERR_UNCONFIGURED);
+
+    file_player.play();
+    return OK;
+}
+
+void GodotRtMidiOut::pause_file() {
+    file_player.pause();
+}
+
+void GodotRtMidiOut::stop_file() {
+    file_player.pause();
+    file_player.seek(0);
+}
+
+Error GodotRtMidiOut::seek_file(double position) {
+    ERR_FAIL_COND_V(!file_player.is_open(), ERR_UNCONFIGURED);
+
+    file_player.seek((uint64_t)(std::max(position, 0.0) * 1000000000.0));
+    return OK;
+}
+
+bool GodotRtMidiOut::is_playing_file() const {
+    return file_player.is_playing();
+}
+
+double GodotRtMidiOut::get_file_position() const {
+    return file_player.get_position() / 1000000000.0;
+}
+
+double GodotRtMidiOut::get_file_length() const {
+    return file_player.get_length() / 1000000000.0;
+}
+
+void GodotRtMidiOut::set_file_clock(bool enabled) {
+    file_player.set_send_clock(enabled);
+}
+
+bool GodotRtMidiOut::get_file_clock() const {
+    return file_player.get_send_clock();
+}
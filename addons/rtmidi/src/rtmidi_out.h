@@ -0,0 +1,141 @@
+#ifndef GODOT_RTMIDI_OUT_H
+#define GODOT_RTMIDI_OUT_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/packed_string_array.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/packed_int32_array.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <RtMidi.h>
+#include "midi_clock_generator.h"
+#include "midi_file.h"
+#include "midi_log.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace godot {
+
+// MIDI output with per-frame batching. Messages are queued on the main
+// thread and handed to the backend in one sendEvents() call by flush(),
+// which with auto-flush runs once at the end of the frame. ALSA writes
+// the whole batch with one drain and schedules messages stamped with a
+// future time on a sequencer queue. The optional clock generator, log
+// player and MIDI file player send from their own threads; send_mutex
+// serializes them with flush().
+class GodotRtMidiOut : public RefCounted {
+    GDCLASS(GodotRtMidiOut, RefCounted)
+
+private:
+    // A queued message: size bytes at offset in pending_bytes
+    struct PendingMessage {
+        uint64_t time_ns;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    RtMidiOut *midi_out = nullptr;
+    bool port_open = false;
+    bool auto_flush = true;
+    bool flush_pending = false;
+
+    std::vector<unsigned char> pending_bytes;
+    std::vector<PendingMessage> pending;
+    // Reused by flush() so flushing doesn't allocate per frame
+    std::vector<RtMidiEvent> flush_events;
+
+    std::mutex send_mutex;
+    MidiClockGenerator clock_generator{ &GodotRtMidiOut::clock_send, this };
+    MidiLogPlayer log_player{ &GodotRtMidiOut::log_send, this };
+    MidiFilePlayer file_player{ &GodotRtMidiOut::log_send, this };
+
+    void create_output(RtMidi::Api api);
+    void destroy_output();
+    void queue_message(const unsigned char *data, size_t size, double at_time);
+    static void clock_send(const unsigned char *message, size_t size, void *user_data);
+    // Log and MIDI file playback threads
+    static void log_send(const RtMidiEvent *events, unsigned int count, void *user_data);
+
+protected:
+    static void _bind_methods();
+
+public:
+    GodotRtMidiOut();
+    ~GodotRtMidiOut();
+
+    // Device management
+    PackedStringArray get_port_names();
+    int get_port_count();
+    Dictionary get_ports();
+    Error open_port(int port_number);
+    Error open_port_address(int client, int port);
+    Error open_virtual_port(const String &name);
+    void close_port();
+    bool is_port_open() const;
+    Error set_api(const String &name);
+    String get_api() const;
+
+    // Sending. at_time is in seconds on the get_time() clock; negative
+    // sends with the next flush, a future time is delivered then where
+    // the backend can schedule it.
+    Error send_message(const PackedByteArray &message, double at_time = -1.0);
+    Error send_note_on(int channel, int note, int velocity, double at_time = -1.0);
+    Error send_note_off(int channel, int note, int velocity = 0, double at_time = -1.0);
+    Error send_control_change(int channel, int control, int value, double at_time = -1.0);
+
+    // Batching
+    void flush();
+    int get_pending_count() const;
+    void set_auto_flush(bool enabled);
+    bool get_auto_flush() const;
+
+    // Clock master: 24 PPQ from a dedicated thread while the port is open.
+    // Transport messages go out with the next tick.
+    Error start_clock(double bpm = 120.0);
+    void stop_clock();
+    bool is_clock_running() const;
+    void set_clock_bpm(double bpm);
+    double get_clock_bpm() const;
+    void clock_start();
+    void clock_stop();
+    void clock_continue();
+    void set_song_position(int sixteenths);
+    int64_t get_song_position() const;
+    bool is_clock_playing() const;
+    Dictionary get_clock_stats() const;
+
+    // Replay a log written by GodotRtMidiIn::start_recording(), with the
+    // original spacing or as fast as possible. Either way the event times
+    // keep the original spacing, which the loopback API ("dummy") hands
+    // to its inputs as arrival times.
+    Error play_log(const String &path, bool realtime = true);
+    void stop_log();
+    bool is_playing_log() const;
+    int64_t get_log_position() const;
+    int64_t get_log_length() const;
+
+    // Standard MIDI file (type 0/1) playback with the original timing. Sent
+    // to the loopback API, it reaches a GodotRtMidiIn as the same stream a
+    // device would produce, clock included. Times are in seconds.
+    Error open_file(const String &path);
+    void close_file();
+    Error play_file();
+    void pause_file();
+    // Pause and rewind
+    void stop_file();
+    Error seek_file(double position);
+    bool is_playing_file() const;
+    double get_file_position() const;
+    double get_file_length() const;
+    // Send MIDI clock and transport from the file's tempo map
+    void set_file_clock(bool enabled);
+    bool get_file_clock() const;
+
+    // Same clock as GodotRtMidiIn::get_time()
+    double get_time() const;
+};
+
+}
+
+#endif // GODOT_RTMIDI_OUT_H
@@ -0,0 +1,63 @@
+#include "rtmidi_subscriber.h"
+#include <godot_cpp/core/class_db.hpp>
+
+using namespace godot;
+
+void GodotRtMidiSubscriber::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("has_message"), &GodotRtMidiSubscriber::has_message);
+    ClassDB::bind_method(D_METHOD("poll_message"), &GodotRtMidiSubscriber::poll_message);
+    ClassDB::bind_method(D_METHOD("drain_messages"), &GodotRtMidiSubscriber::drain_messages);
+    ClassDB::bind_method(D_METHOD("get_dropped_count"), &GodotRtMidiSubscriber::get_dropped_count);
+    ClassDB::bind_method(D_METHOD("skip_pending"), &GodotRtMidiSubscriber::skip_pending);
+}
+
+void GodotRtMidiSubscriber::attach(const std::shared_ptr<GodotRtMidiIn::Broadcast> &p_ring) {
+    ring = p_ring;
+    cursor = ring ? ring->published() : 0;
+    dropped = 0;
+}
+
+bool GodotRtMidiSubscriber::has_message() const {
+    return ring && cursor < ring->published();
+}
+
+Dictionary GodotRtMidiSubscriber::poll_message() {
+    GodotRtMidiIn::MidiMessage msg;
+    if (!ring || !ring->read(cursor, msg, dropped)) {
+        return Dictionary();
+    }
+    return GodotRtMidiIn::message_to_dictionary(msg);
+}
+
+Dictionary GodotRtMidiSubscriber::drain_messages() {
+    drain_buffer.clear();
+
+    GodotRtMidiIn::MidiMessage msg;
+    while (ring && ring->read(cursor, msg, dropped)) {
+        drain_buffer.push_back(msg);
+    }
+
+    // The ring keeps arrival order; hand the messages out lane by lane like
+    // GodotRtMidiIn does, so a CC backlog can't delay clock handling
+    lane_buffer.clear();
+    for (int lane = 0; lane < GodotRtMidiIn::LANE_COUNT; lane++) {
+        for (const GodotRtMidiIn::MidiMessage &m : drain_buffer) {
+            if (GodotRtMidiIn::message_lane(m) == lane) {
+                lane_buffer.push_back(m);
+            }
+        }
+    }
+    drain_buffer.swap(lane_buffer);
+
+    return GodotRtMidiIn::messages_to_dictionary(drain_buffer);
+}
+
+int64_t GodotRtMidiSubscriber::get_dropped_count() const {
+    return (int64_t)dropped;
+}
+
+void GodotRtMidiSubscriber::skip_pending() {
+    if (ring) {
+        cursor = ring->published();
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef GODOT_RTMIDI_SUBSCRIBER_H
+#define GODOT_RTMIDI_SUBSCRIBER_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include "rtmidi_in.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace godot {
+
+// One reader of the hub's broadcast ring. Holds only a cursor, so any
+// number of scenes can listen to the same devices without extra threads or
+// copies on the MIDI thread. Created by GodotRtMidiHub::subscribe().
+class GodotRtMidiSubscriber : public RefCounted {
+    GDCLASS(GodotRtMidiSubscriber, RefCounted)
+
+private:
+    std::shared_ptr<GodotRtMidiIn::Broadcast> ring;
+    uint64_t cursor = 0;
+    uint64_t dropped = 0;
+
+    // Reused by drain_messages() so draining doesn't allocate per frame
+    std::vector<GodotRtMidiIn::MidiMessage> drain_buffer;
+    std::vector<GodotRtMidiIn::MidiMessage> lane_buffer;
+
+protected:
+    static void _bind_methods();
+
+public:
+    // Start reading at the next message published to p_ring
+    void attach(const std::shared_ptr<GodotRtMidiIn::Broadcast> &p_ring);
+
+    // Same layouts as GodotRtMidiIn
+    bool has_message() const;
+    Dictionary poll_message();
+    Dictionary drain_messages();
+
+    // Messages overwritten before this subscriber read them
+    int64_t get_dropped_count() const;
+    // Discard everything pending, e.g. after a scene was paused
+    void skip_pending();
+};
+
+}
+
+#endif // GODOT_RTMIDI_SUBSCRIBER_H
@@ -0,0 +1,146 @@
+#include "rtmidi_time_map.h"
+#include <godot_cpp/classes/audio_server.hpp>
+#include <godot_cpp/classes/time.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/error_macros.hpp>
+#include <chrono>
+
+using namespace godot;
+
+void GodotRtMidiTimeMap::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_input", "input"), &GodotRtMidiTimeMap::set_input);
+    ClassDB::bind_method(D_METHOD("get_input"), &GodotRtMidiTimeMap::get_input);
+
+    // Sampling
+    ClassDB::bind_method(D_METHOD("update", "audio_position"), &GodotRtMidiTimeMap::update, DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("reset"), &GodotRtMidiTimeMap::reset);
+    ClassDB::bind_method(D_METHOD("set_window", "samples"), &GodotRtMidiTimeMap::set_window);
+    ClassDB::bind_method(D_METHOD("get_window"), &GodotRtMidiTimeMap::get_window);
+
+    // Conversion
+    ClassDB::bind_method(D_METHOD("convert", "time", "from", "to"), &GodotRtMidiTimeMap::convert);
+    ClassDB::bind_method(D_METHOD("to_engine_time", "timestamp"), &GodotRtMidiTimeMap::to_engine_time);
+    ClassDB::bind_method(D_METHOD("to_audio_position", "timestamp"), &GodotRtMidiTimeMap::to_audio_position);
+    ClassDB::bind_method(D_METHOD("get_domain_time", "domain"), &GodotRtMidiTimeMap::get_domain_time);
+    ClassDB::bind_method(D_METHOD("set_latency", "domain", "seconds"), &GodotRtMidiTimeMap::set_latency);
+    ClassDB::bind_method(D_METHOD("get_latency", "domain"), &GodotRtMidiTimeMap::get_latency);
+    ClassDB::bind_method(D_METHOD("get_fit", "domain"), &GodotRtMidiTimeMap::get_fit);
+
+    BIND_ENUM_CONSTANT(DOMAIN_MONOTONIC);
+    BIND_ENUM_CONSTANT(DOMAIN_DRIVER);
+    BIND_ENUM_CONSTANT(DOMAIN_ENGINE);
+    BIND_ENUM_CONSTANT(DOMAIN_AUDIO);
+}
+
+// Same clock as GodotRtMidiIn::get_time()
+double GodotRtMidiTimeMap::now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void GodotRtMidiTimeMap::set_input(const Ref<GodotRtMidiIn> &p_input) {
+    input = p_input;
+    fits[DOMAIN_DRIVER].reset();
+}
+
+Ref<GodotRtMidiIn> GodotRtMidiTimeMap::get_input() const {
+    return input;
+}
+
+// The clock was read somewhere between before and after; the midpoint is
+// its reference time
+void GodotRtMidiTimeMap::add_sample(Domain domain, double before, double time, double after) {
+    if (after - before > MAX_READ_TIME) {
+        return;
+    }
+    fits[domain].add_sample((before + after) * 0.5, time, MAX_JUMP);
+}
+
+void GodotRtMidiTimeMap::update(double audio_position) {
+    double before = now();
+    double engine_time = Time::get_singleton()->get_ticks_usec() / 1000000.0;
+    double after = now();
+    add_sample(DOMAIN_ENGINE, before, engine_time, after);
+
+    if (input.is_valid() && input->is_port_open()) {
+        before = now();
+        double driver_time = input->get_driver_time();
+        after = now();
+        add_sample(DOMAIN_DRIVER, before, driver_time, after);
+    }
+
+    AudioServer *audio = AudioServer::get_singleton();
+    output_latency = audio->get_output_latency();
+    if (audio_position >= 0.0) {
+        // The position advances once per mix; what has played since is
+        // the time since that mix
+        before = now();
+        double audio_time = audio_position + audio->get_time_since_last_mix();
+        after = now();
+        add_sample(DOMAIN_AUDIO, before, audio_time, after);
+    }
+}
+
+void GodotRtMidiTimeMap::reset() {
+    for (MidiTimeFit &fit : fits) {
+        fit.reset();
+    }
+}
+
+void GodotRtMidiTimeMap::set_window(int samples) {
+    for (MidiTimeFit &fit : fits) {
+        fit.set_window(samples);
+    }
+}
+
+int GodotRtMidiTimeMap::get_window() const {
+    return fits[DOMAIN_MONOTONIC].get_window();
+}
+
+double GodotRtMidiTimeMap::get_effective_latency(Domain domain) const {
+    return latencies[domain] + (domain == DOMAIN_AUDIO ? output_latency : 0.0);
+}
+
+double GodotRtMidiTimeMap::convert(double time, Domain from, Domain to) const {
+    ERR_FAIL_INDEX_V(from, DOMAIN_COUNT, time);
+    ERR_FAIL_INDEX_V(to, DOMAIN_COUNT, time);
+
+    double perceived = fits[from].to_reference(time) + get_effective_latency(from);
+    return fits[to].to_time(perceived - get_effective_latency(to));
+}
+
+double GodotRtMidiTimeMap::to_engine_time(double timestamp) const {
+    return convert(timestamp, DOMAIN_DRIVER, DOMAIN_ENGINE);
+}
+
+double GodotRtMidiTimeMap::to_audio_position(double timestamp) const {
+    return convert(timestamp, DOMAIN_DRIVER, DOMAIN_AUDIO);
+}
+
+double GodotRtMidiTimeMap::get_domain_time(Domain domain) const {
+    ERR_FAIL_INDEX_V(domain, DOMAIN_COUNT, 0.0);
+    return fits[domain].to_time(now());
+}
+
+void GodotRtMidiTimeMap::set_latency(Domain domain, double seconds) {
+    ERR_FAIL_INDEX(domain, DOMAIN_COUNT);
+    latencies[domain] = seconds;
+}
+
+double GodotRtMidiTimeMap::get_latency(Domain domain) const {
+    ERR_FAIL_INDEX_V(domain, DOMAIN_COUNT, 0.0);
+    return latencies[domain];
+}
+
+Dictionary GodotRtMidiTimeMap::get_fit(Domain domain) const {
+    Dictionary result;
+    ERR_FAIL_INDEX_V(domain, DOMAIN_COUNT, result);
+
+    const MidiTimeFit &fit = fits[domain];
+    double reference = now();
+    result["rate"] = fit.get_rate();
+    result["drift_ppm"] = (fit.get_rate() - 1.0) * 1000000.0;
+    result["offset"] = fit.to_time(reference) - reference;
+    result["residual"] = fit.get_residual();
+    result["samples"] = fit.get_sample_count();
+    return result;
+}
@@ -0,0 +1,89 @@
+#ifndef GODOT_RTMIDI_TIME_MAP_H
+#define GODOT_RTMIDI_TIME_MAP_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include "midi_time_fit.h"
+#include "rtmidi_in.h"
+
+namespace godot {
+
+// Correlates the clocks a MIDI event can be measured on. update(), called
+// once per frame, reads each clock together with the monotonic reference
+// (get_time()) and keeps a linear fit per clock over recent samples, so
+// offset and drift are tracked as they change. convert() then moves a time
+// from one clock to another, compensating each clock's latency: an event
+// at time t on clock A is perceived at t + latency(A), and the time on
+// clock B perceived at that moment is what convert() returns.
+class GodotRtMidiTimeMap : public RefCounted {
+    GDCLASS(GodotRtMidiTimeMap, RefCounted)
+
+public:
+    enum Domain {
+        DOMAIN_MONOTONIC,  // get_time(): the reference clock
+        DOMAIN_DRIVER,     // Message timestamps (the ALSA queue clock)
+        DOMAIN_ENGINE,     // Time.get_ticks_usec() in seconds
+        DOMAIN_AUDIO,      // Playback position of the audio being mixed
+        DOMAIN_COUNT,
+    };
+
+private:
+    // A reading that took longer than this was preempted and is skipped
+    static constexpr double MAX_READ_TIME = 0.0005;
+    // A sample this far off the fit is a clock jump, not drift
+    static constexpr double MAX_JUMP = 0.05;
+
+    Ref<GodotRtMidiIn> input;
+    MidiTimeFit fits[DOMAIN_COUNT];  // DOMAIN_MONOTONIC's stays the identity
+    double latencies[DOMAIN_COUNT] = {};
+    double output_latency = 0.0;     // AudioServer's, refreshed by update()
+
+    static double now();
+    void add_sample(Domain domain, double before, double time, double after);
+    double get_effective_latency(Domain domain) const;
+
+protected:
+    static void _bind_methods();
+
+public:
+    // Source of DOMAIN_DRIVER samples. Without one, driver time is taken to
+    // be monotonic.
+    void set_input(const Ref<GodotRtMidiIn> &p_input);
+    Ref<GodotRtMidiIn> get_input() const;
+
+    // Sample every clock (call from _process). audio_position is the
+    // playback position of the stream being heard, e.g.
+    // AudioStreamPlayer.get_playback_position(); negative skips the audio
+    // clock. AudioServer.get_time_since_last_mix() is added here.
+    void update(double audio_position = -1.0);
+    void reset();
+    // Samples per fit: longer windows average out more jitter but follow
+    // drift changes more slowly
+    void set_window(int samples);
+    int get_window() const;
+
+    double convert(double time, Domain from, Domain to) const;
+    // Message timestamp to Time.get_ticks_usec() seconds and to audio
+    // position, the two timelines the visualizer renders against
+    double to_engine_time(double timestamp) const;
+    double to_audio_position(double timestamp) const;
+    // Now, estimated on a clock
+    double get_domain_time(Domain domain) const;
+
+    // Extra latency of a clock, seconds: display latency for
+    // DOMAIN_ENGINE, input latency for DOMAIN_DRIVER. DOMAIN_AUDIO also
+    // includes AudioServer.get_output_latency().
+    void set_latency(Domain domain, double seconds);
+    double get_latency(Domain domain) const;
+
+    // {"rate", "drift_ppm", "offset", "residual", "samples"}; offset is the
+    // clock's time minus get_time() now
+    Dictionary get_fit(Domain domain) const;
+};
+
+}
+
+VARIANT_ENUM_CAST(GodotRtMidiTimeMap::Domain);
+
+#endif // GODOT_RTMIDI_TIME_MAP_H
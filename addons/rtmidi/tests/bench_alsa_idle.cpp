@@ -0,0 +1,72 @@
+// Idle cost and wake-up latency of the ALSA sequencer input.
+//
+// An input is opened on a virtual port and left idle while getrusage()
+// measures the CPU time and context switches the process spends with
+// nothing arriving. An output then connects to that port and sends one
+// message at a time with a gap between them, so the input thread is asleep
+// in poll() before each one. For every message it reports how long the
+// kernel took to stamp it (send -> timestamp) and how long until the batch
+// callback ran (send -> callback).
+//
+//   bench_alsa_idle [idle seconds = 5] [messages = 1000] [gap ms = 5]
+
+#include <RtMidi.h>
+#include "midi_clock_generator.h"
+#include "test_util.h"
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+using godot::MidiClockGenerator;
+
+namespace {
+
+double cpu_seconds(const rusage &p_usage) {
+    return p_usage.ru_utime.tv_sec + p_usage.ru_utime.tv_usec / 1e6 +
+            p_usage.ru_stime.tv_sec + p_usage.ru_stime.tv_usec / 1e6;
+}
+
+}
+
+int main(int argc, char **argv) {
+    double idle_seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    int messages = argc > 2 ? atoi(argv[2]) : 1000;
+    double gap_ms = argc > 3 ? atof(argv[3]) : 5.0;
+
+    try {
+        LatencyProbe probe;
+        RtMidiIn in(RtMidi::LINUX_ALSA, "bench_alsa_idle");
+        in.setBatchCallback(LatencyProbe::on_batch, &probe);
+        in.openVirtualPort("bench in");
+
+        rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        uint64_t idle_start = MidiClockGenerator::now_ns();
+        std::this_thread::sleep_for(std::chrono::duration<double>(idle_seconds));
+        double elapsed = (MidiClockGenerator::now_ns() - idle_start) / 1e9;
+        getrusage(RUSAGE_SELF, &after);
+
+        printf("idle for %.1f s: %.3f%% of a CPU, %ld voluntary and %ld involuntary context switches\n",
+                elapsed, 100.0 * (cpu_seconds(after) - cpu_seconds(before)) / elapsed,
+                after.ru_nvcsw - before.ru_nvcsw, after.ru_nivcsw - before.ru_nivcsw);
+
+        RtMidiOut out(RtMidi::LINUX_ALSA, "bench_alsa_idle");
+        int port = find_port(out, "bench in");
+        if (port < 0) {
+            fprintf(stderr, "virtual port not found\n");
+            return 1;
+        }
+        out.openPort(unsigned(port));
+
+        probe.run(out, messages, gap_ms);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d messages, %.1f ms apart", messages, gap_ms);
+        probe.print(label);
+    } catch (const RtMidiError &e) {
+        e.printMessage();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Sequencer against raw MIDI input latency over the same loop.
+//
+// Single messages are sent after a gap (as in bench_alsa_idle) to an
+// output port that loops back into an input port. The input is opened
+// through the ALSA sequencer ("alsa"), raw MIDI ("rawmidi") or each in
+// turn ("both"), and the latency from send to driver timestamp and to the
+// batch callback is reported per backend. Loops that work:
+//
+// - A MIDI cable from an interface's output to its input. Both backends
+//   read the same wire, so only the input path differs.
+// - snd-virmidi, without hardware. Sequencer events sent to a VirMIDI port
+//   are read from its raw MIDI device, and raw MIDI writes come out of its
+//   sequencer port, so each input backend needs the output on the other.
+//
+//   bench_backend_latency <output api> <output port> <input api | both> <input port>
+//                         [messages = 500] [gap ms = 5]
+//
+// Ports are matched by a substring of their name.
+
+#include <RtMidi.h>
+#include "test_util.h"
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+bool measure(RtMidi::Api p_out_api, const std::string &p_out_port, RtMidi::Api p_in_api,
+        const std::string &p_in_port, int p_messages, double p_gap_ms) {
+    std::string label = "input " + RtMidi::getApiName(p_in_api) + ", output " + RtMidi::getApiName(p_out_api);
+    try {
+        LatencyProbe probe;
+        RtMidiIn in(p_in_api, "bench_backend_latency");
+        in.setBatchCallback(LatencyProbe::on_batch, &probe);
+        int in_port = find_port(in, p_in_port);
+        if (in_port < 0) {
+            printf("%s: no input port matching '%s'\n", label.c_str(), p_in_port.c_str());
+            return false;
+        }
+        in.openPort(unsigned(in_port));
+
+        RtMidiOut out(p_out_api, "bench_backend_latency");
+        int out_port = find_port(out, p_out_port);
+        if (out_port < 0) {
+            printf("%s: no output port matching '%s'\n", label.c_str(), p_out_port.c_str());
+            return false;
+        }
+        out.openPort(unsigned(out_port));
+
+        probe.run(out, p_messages, p_gap_ms);
+        label += " (" + in.getPortName(unsigned(in_port)) + ")";
+        probe.print(label.c_str());
+        return true;
+    } catch (const RtMidiError &e) {
+        printf("%s: %s\n", label.c_str(), e.getMessage().c_str());
+        return false;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <output api> <output port> <input api | both> <input port> [messages] [gap ms]\n", argv[0]);
+        return 1;
+    }
+    RtMidi::Api out_api = RtMidi::getCompiledApiByName(argv[1]);
+    std::string out_port = argv[2];
+    std::string in_api_name = argv[3];
+    std::string in_port = argv[4];
+    int messages = argc > 5 ? atoi(argv[5]) : 500;
+    double gap_ms = argc > 6 ? atof(argv[6]) : 5.0;
+
+    std::vector<RtMidi::Api> in_apis;
+    if (in_api_name == "both") {
+        in_apis = { RtMidi::LINUX_ALSA, RtMidi::LINUX_RAWMIDI };
+    } else {
+        in_apis = { RtMidi::getCompiledApiByName(in_api_name) };
+    }
+    for (RtMidi::Api api : in_apis) {
+        if (api == RtMidi::UNSPECIFIED || out_api == RtMidi::UNSPECIFIED) {
+            fprintf(stderr, "API not compiled in\n");
+            return 1;
+        }
+    }
+
+    printf("%d messages, %.1f ms apart\n", messages, gap_ms);
+    bool ok = true;
+    for (RtMidi::Api api : in_apis) {
+        ok = measure(out_api, out_port, api, in_port, messages, gap_ms) && ok;
+    }
+    return ok ? 0 : 1;
+}
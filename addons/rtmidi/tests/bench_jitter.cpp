@@ -0,0 +1,198 @@
+// MIDI clock timing under CPU contention, with and without realtime
+// scheduling.
+//
+// MidiClockGenerator sends clock through an RtMidiOut to an RtMidiIn while
+// N threads spin on every CPU. Each tick's arrival in the input callback
+// is compared with an ideal grid at the clock's period, centered on the
+// median offset, and the error percentiles are reported twice: once with
+// default scheduling, once with the MIDI threads on SCHED_FIFO and pinned
+// to one CPU (RtMidiIn::setThreadOptions() for the input thread, as
+// GodotRtMidiIn.set_thread_priority()/set_thread_affinity() do; the same
+// settings for the clock thread). Realtime scheduling needs CAP_SYS_NICE
+// or an rtprio limit; refusals are reported.
+//
+// On the loopback API ("dummy", the default) delivery happens on the clock
+// thread, so this measures its wake-ups alone. With "alsa" the ticks go
+// through a sequencer virtual port and the input thread's wake-ups add up.
+//
+//   bench_jitter [api = dummy] [busy threads = CPU count] [seconds = 5]
+//                [bpm = 300] [priority = 70] [cpu = last]
+
+#include <RtMidi.h>
+#include "midi_clock_generator.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using godot::MidiClockGenerator;
+
+namespace {
+
+struct Run {
+    RtMidiOut *out = nullptr;
+    bool realtime = false;
+    int priority = 0;
+    int cpu = 0;
+
+    // Clock thread scheduling, applied from its first send
+    bool clock_thread_raised = false;
+    bool clock_priority_ok = false;
+    bool clock_affinity_ok = false;
+
+    std::vector<uint64_t> arrivals;
+    std::atomic<size_t> arrival_count{ 0 };
+};
+
+void send_clock(const unsigned char *p_message, size_t p_size, void *p_user_data) {
+    Run *run = static_cast<Run *>(p_user_data);
+    if (run->realtime && !run->clock_thread_raised) {
+        run->clock_thread_raised = true;
+        sched_param param = {};
+        param.sched_priority = run->priority;
+        run->clock_priority_ok = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(run->cpu, &cpus);
+        run->clock_affinity_ok = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+    }
+    run->out->sendMessage(p_message, p_size);
+}
+
+void on_batch(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data) {
+    Run *run = static_cast<Run *>(p_user_data);
+    uint64_t now = MidiClockGenerator::now_ns();
+    for (unsigned int i = 0; i < p_count; i++) {
+        if (p_events[i].size != 1 || p_events[i].bytes[0] != 0xF8) continue;
+        size_t index = run->arrival_count.load(std::memory_order_relaxed);
+        if (index < run->arrivals.size()) {
+            run->arrivals[index] = now;
+            run->arrival_count.store(index + 1, std::memory_order_release);
+        }
+    }
+}
+
+// Distance of each arrival from the ideal grid, with the grid placed at
+// the median offset so a late first tick doesn't skew everything
+std::vector<int64_t> grid_errors(const std::vector<uint64_t> &p_arrivals, size_t p_count, double p_period_ns) {
+    std::vector<int64_t> offsets;
+    for (size_t i = 0; i < p_count; i++) {
+        offsets.push_back(int64_t(p_arrivals[i] - p_arrivals[0]) - int64_t(i * p_period_ns));
+    }
+    std::vector<int64_t> sorted = offsets;
+    std::sort(sorted.begin(), sorted.end());
+    int64_t median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+
+    std::vector<int64_t> errors;
+    for (int64_t offset : offsets) {
+        errors.push_back(std::abs(offset - median));
+    }
+    return errors;
+}
+
+void spin(std::atomic<bool> *p_stop) {
+    volatile uint64_t counter = 0;
+    while (!p_stop->load(std::memory_order_relaxed)) {
+        counter = counter + 1;
+    }
+}
+
+bool measure(RtMidi::Api p_api, bool p_realtime, int p_threads, double p_seconds, double p_bpm,
+        int p_priority, int p_cpu) {
+    Run run;
+    run.realtime = p_realtime;
+    run.priority = p_priority;
+    run.cpu = p_cpu;
+    double period_ns = 60e9 / (p_bpm * MidiClockGenerator::TICKS_PER_BEAT);
+    run.arrivals.resize(size_t(p_seconds * 1e9 / period_ns) + 64);
+
+    try {
+        RtMidiIn in(p_api, "bench_jitter");
+        in.ignoreTypes(true, false, true);
+        in.setBatchCallback(on_batch, &run);
+        if (p_realtime) {
+            RtMidiThreadOptions options;
+            options.policy = RtMidiThreadOptions::FIFO;
+            options.priority = p_priority;
+            options.cpus = 1ull << p_cpu;
+            in.setThreadOptions(options);
+        }
+        in.openVirtualPort("bench in");
+
+        RtMidiOut out(p_api, "bench_jitter");
+        int port = find_port(out, "bench in");
+        if (port < 0) {
+            fprintf(stderr, "virtual port not found\n");
+            return false;
+        }
+        out.openPort(unsigned(port));
+        run.out = &out;
+
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> busy;
+        for (int i = 0; i < p_threads; i++) {
+            busy.emplace_back(spin, &stop);
+        }
+
+        MidiClockGenerator generator(send_clock, &run);
+        generator.start_clock(p_bpm);
+        std::this_thread::sleep_for(std::chrono::duration<double>(p_seconds));
+        generator.stop_clock();
+
+        stop.store(true);
+        for (std::thread &thread : busy) {
+            thread.join();
+        }
+
+        size_t count = run.arrival_count.load(std::memory_order_acquire);
+        std::string label = p_realtime ? "realtime" : "normal";
+        if (p_realtime) {
+            unsigned int status = in.getThreadStatus();
+            bool input_thread = p_api != RtMidi::RTMIDI_DUMMY;
+            label += " (clock thread: priority ";
+            label += run.clock_priority_ok ? "ok" : "refused";
+            label += run.clock_affinity_ok ? ", affinity ok" : ", affinity refused";
+            if (input_thread) {
+                label += "; input thread: priority ";
+                label += (status & RtMidiThreadOptions::PRIORITY_APPLIED) ? "ok" : "refused";
+                label += (status & RtMidiThreadOptions::AFFINITY_APPLIED) ? ", affinity ok" : ", affinity refused";
+            }
+            label += ")";
+        }
+        printf("%s\n", label.c_str());
+        print_percentiles("  tick error", grid_errors(run.arrivals, count, period_ns));
+    } catch (const RtMidiError &e) {
+        e.printMessage();
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+    int cpu_count = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::string api_name = argc > 1 ? argv[1] : "dummy";
+    int threads = argc > 2 ? atoi(argv[2]) : cpu_count;
+    double seconds = argc > 3 ? atof(argv[3]) : 5.0;
+    double bpm = argc > 4 ? atof(argv[4]) : 300.0;
+    int priority = argc > 5 ? atoi(argv[5]) : 70;
+    int cpu = argc > 6 ? atoi(argv[6]) : cpu_count - 1;
+
+    RtMidi::Api api = RtMidi::getCompiledApiByName(api_name);
+    if (api == RtMidi::UNSPECIFIED) {
+        fprintf(stderr, "API '%s' is not compiled in\n", api_name.c_str());
+        return 1;
+    }
+
+    printf("%s, %d busy threads on %d CPUs, %.0f BPM for %.1f s\n",
+            RtMidi::getApiName(api).c_str(), threads, cpu_count, bpm, seconds);
+    bool ok = measure(api, false, threads, seconds, bpm, priority, cpu);
+    ok = measure(api, true, threads, seconds, bpm, priority, cpu) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+// Encode/decode throughput from RtMidiOut::sendEvents() to RtMidiIn.
+//
+// Each group of the full message set (channel voice messages on all 16
+// channels, system common, realtime, SysEx of several sizes, and all of
+// them interleaved) is sent in batches to an input's virtual port for a
+// fixed time, and the input checks every message arrives intact and in
+// order. On the loopback API ("dummy", the default) this measures RtMidi's
+// batching and dispatch; with "alsa" the sequencer encodes and decodes
+// every message too.
+//
+//   bench_throughput [api = dummy] [seconds per group = 1]
+
+#include <RtMidi.h>
+#include "midi_clock_generator.h"
+#include "test_util.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using godot::MidiClockGenerator;
+
+namespace {
+
+typedef std::vector<unsigned char> Message;
+
+const unsigned int BATCH = 64;
+const uint64_t WINDOW = 512;  // Messages in flight before the sender waits
+
+// Receiver side; the expected group only changes while nothing is in flight
+const std::vector<Message> *expected = nullptr;
+uint64_t next_index = 0;
+std::atomic<uint64_t> received{ 0 };
+std::atomic<uint64_t> mismatches{ 0 };
+
+void on_batch(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data) {
+    for (unsigned int i = 0; i < p_count; i++) {
+        const Message &message = (*expected)[next_index++ % expected->size()];
+        if (p_events[i].size != message.size() || memcmp(p_events[i].data(), message.data(), message.size()) != 0) {
+            mismatches.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    received.fetch_add(p_count, std::memory_order_release);
+}
+
+std::vector<Message> voice_messages() {
+    std::vector<Message> messages;
+    for (unsigned char channel = 0; channel < 16; channel++) {
+        messages.push_back({ (unsigned char)(0x90 | channel), 60, 100 });
+        messages.push_back({ (unsigned char)(0x80 | channel), 60, 64 });
+        messages.push_back({ (unsigned char)(0xA0 | channel), 60, 30 });
+        messages.push_back({ (unsigned char)(0xB0 | channel), 7, 90 });
+        messages.push_back({ (unsigned char)(0xC0 | channel), 5 });
+        messages.push_back({ (unsigned char)(0xD0 | channel), 40 });
+        messages.push_back({ (unsigned char)(0xE0 | channel), 0x11, 0x40 });
+    }
+    return messages;
+}
+
+std::vector<Message> common_messages() {
+    return {
+        { 0xF1, 0x21 },
+        { 0xF2, 0x10, 0x02 },
+        { 0xF3, 3 },
+        { 0xF6 },
+    };
+}
+
+std::vector<Message> realtime_messages() {
+    return {
+        { 0xFA },
+        { 0xF8 },
+        { 0xFB },
+        { 0xF8 },
+        { 0xFC },
+        { 0xFE },
+    };
+}
+
+std::vector<Message> sysex_messages() {
+    std::vector<Message> messages;
+    for (size_t size : { 6, 64, 256 }) {
+        Message message(size, 0);
+        message.front() = 0xF0;
+        for (size_t i = 1; i + 1 < size; i++) {
+            message[i] = (unsigned char)(i & 0x7F);
+        }
+        message.back() = 0xF7;
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+std::vector<RtMidiEvent> to_events(const std::vector<Message> &p_messages) {
+    std::vector<RtMidiEvent> events;
+    for (const Message &message : p_messages) {
+        RtMidiEvent event = {};
+        event.size = (unsigned int)message.size();
+        if (event.size <= sizeof(event.bytes)) {
+            memcpy(event.bytes, message.data(), message.size());
+        } else {
+            event.sysex = message.data();
+        }
+        events.push_back(event);
+    }
+    return events;
+}
+
+bool wait_for(uint64_t p_count) {
+    uint64_t timeout = MidiClockGenerator::now_ns() + 2000000000;
+    while (received.load(std::memory_order_acquire) < p_count) {
+        if (MidiClockGenerator::now_ns() > timeout) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void run_group(RtMidiOut &p_out, const char *p_name, const std::vector<Message> &p_messages, double p_seconds) {
+    // About BATCH messages per call, whole copies of the group so every
+    // call starts it over
+    std::vector<Message> cycle;
+    size_t copies = std::max<size_t>(1, BATCH / p_messages.size());
+    for (size_t i = 0; i < copies; i++) {
+        cycle.insert(cycle.end(), p_messages.begin(), p_messages.end());
+    }
+    std::vector<RtMidiEvent> events = to_events(cycle);
+
+    size_t cycle_bytes = 0;
+    for (const Message &message : cycle) {
+        cycle_bytes += message.size();
+    }
+
+    expected = &cycle;
+    next_index = 0;
+    received.store(0);
+    mismatches.store(0);
+
+    uint64_t sent = 0;
+    uint64_t start = MidiClockGenerator::now_ns();
+    uint64_t end = start + uint64_t(p_seconds * 1e9);
+    bool stalled = false;
+    while (MidiClockGenerator::now_ns() < end) {
+        p_out.sendEvents(events.data(), (unsigned int)cycle.size());
+        sent += cycle.size();
+        if (sent > WINDOW && !wait_for(sent - WINDOW)) {
+            stalled = true;
+            break;
+        }
+    }
+    stalled = !wait_for(sent) || stalled;
+    double elapsed = (MidiClockGenerator::now_ns() - start) / 1e9;
+
+    uint64_t arrived = received.load();
+    printf("%-10s %12.0f msg/s %10.2f MB/s  %llu sent, %llu lost, %llu mismatched%s\n",
+            p_name, arrived / elapsed, arrived / cycle.size() * cycle_bytes / elapsed / 1e6,
+            (unsigned long long)sent, (unsigned long long)(sent - arrived),
+            (unsigned long long)mismatches.load(), stalled ? " (stalled)" : "");
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::string api_name = argc > 1 ? argv[1] : "dummy";
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+
+    RtMidi::Api api = RtMidi::getCompiledApiByName(api_name);
+    if (api == RtMidi::UNSPECIFIED) {
+        fprintf(stderr, "API '%s' is not compiled in\n", api_name.c_str());
+        return 1;
+    }
+
+    try {
+        RtMidiIn in(api, "bench_throughput");
+        in.ignoreTypes(false, false, false);
+        in.setBatchCallback(on_batch, nullptr);
+        in.openVirtualPort("bench in");
+
+        RtMidiOut out(api, "bench_throughput");
+        int port = find_port(out, "bench in");
+        if (port < 0) {
+            fprintf(stderr, "virtual port not found\n");
+            return 1;
+        }
+        out.openPort(unsigned(port));
+
+        std::vector<Message> voice = voice_messages();
+        std::vector<Message> common = common_messages();
+        std::vector<Message> realtime = realtime_messages();
+        std::vector<Message> sysex = sysex_messages();
+        std::vector<Message> mixed;
+        for (const std::vector<Message> *group : { &voice, &common, &realtime, &sysex }) {
+            mixed.insert(mixed.end(), group->begin(), group->end());
+        }
+
+        printf("%s, about %u messages per sendEvents() call\n", RtMidi::getApiName(api).c_str(), BATCH);
+        run_group(out, "voice", voice, seconds);
+        run_group(out, "common", common, seconds);
+        run_group(out, "realtime", realtime, seconds);
+        run_group(out, "sysex", sysex, seconds);
+        run_group(out, "mixed", mixed, seconds);
+    } catch (const RtMidiError &e) {
+        e.printMessage();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+#ifndef GODOT_RTMIDI_TEST_GODOT_STUB_HPP
+#define GODOT_RTMIDI_TEST_GODOT_STUB_HPP
+
+// Just enough of godot-cpp to build GodotRtMidiIn outside the engine, for
+// the programs in tests/. Values (String, packed arrays, Dictionary,
+// Variant) behave; class registration and signals do nothing. Only what
+// the wrapper sources use is here.
+
+#include <any>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace godot {
+
+enum Error {
+    OK,
+    FAILED,
+    ERR_UNAVAILABLE,
+    ERR_UNCONFIGURED,
+    ERR_UNAUTHORIZED,
+    ERR_CANT_OPEN,
+    ERR_CANT_CREATE,
+    ERR_INVALID_PARAMETER,
+    ERR_ALREADY_IN_USE,
+    ERR_DOES_NOT_EXIST,
+};
+
+class CharString {
+    std::string data;
+
+public:
+    CharString(const std::string &p_data) : data(p_data) {}
+    const char *get_data() const { return data.c_str(); }
+    int length() const { return int(data.size()); }
+};
+
+class String {
+    std::string data;
+
+public:
+    String() {}
+    String(const char *p_data) : data(p_data) {}
+    CharString utf8() const { return CharString(data); }
+    bool is_empty() const { return data.empty(); }
+    bool operator==(const String &p_other) const { return data == p_other.data; }
+    bool operator!=(const String &p_other) const { return data != p_other.data; }
+    bool operator<(const String &p_other) const { return data < p_other.data; }
+    String operator+(const String &p_other) const { return String((data + p_other.data).c_str()); }
+};
+
+class StringName : public String {
+public:
+    StringName() {}
+    StringName(const char *p_data) : String(p_data) {}
+};
+
+template <class T>
+class PackedArray {
+    std::vector<T> data;
+
+public:
+    int64_t size() const { return int64_t(data.size()); }
+    bool is_empty() const { return data.empty(); }
+    Error resize(int64_t p_size) {
+        data.resize(size_t(p_size));
+        return OK;
+    }
+    bool push_back(const T &p_value) {
+        data.push_back(p_value);
+        return true;
+    }
+    void append(const T &p_value) { data.push_back(p_value); }
+    void set(int64_t p_index, const T &p_value) { data[size_t(p_index)] = p_value; }
+    void fill(const T &p_value) { std::fill(data.begin(), data.end(), p_value); }
+    void clear() { data.clear(); }
+    T *ptrw() { return data.data(); }
+    const T *ptr() const { return data.data(); }
+    const T &operator[](int64_t p_index) const { return data[size_t(p_index)]; }
+};
+
+typedef PackedArray<uint8_t> PackedByteArray;
+typedef PackedArray<int32_t> PackedInt32Array;
+typedef PackedArray<int64_t> PackedInt64Array;
+typedef PackedArray<float> PackedFloat32Array;
+typedef PackedArray<double> PackedFloat64Array;
+typedef PackedArray<String> PackedStringArray;
+
+// Holds any value; reads convert between arithmetic types, anything else
+// must be read back as the type it was stored as
+class Variant {
+    std::any value;
+
+    template <class T, class S>
+    static bool read(const std::any &p_value, T &r_result) {
+        if (const S *stored = std::any_cast<S>(&p_value)) {
+            r_result = T(*stored);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    enum Type {
+        NIL,
+        BOOL,
+        INT,
+        FLOAT,
+        STRING,
+    };
+
+    Variant() {}
+    Variant(const char *p_value) : value(String(p_value)) {}
+    template <class T>
+    Variant(const T &p_value) : value(p_value) {}
+
+    template <class T>
+    operator T() const {
+        T result{};
+        if constexpr (std::is_arithmetic_v<T>) {
+            read<T, bool>(value, result) || read<T, uint8_t>(value, result) ||
+                    read<T, uint16_t>(value, result) || read<T, int32_t>(value, result) ||
+                    read<T, uint32_t>(value, result) || read<T, int64_t>(value, result) ||
+                    read<T, uint64_t>(value, result) || read<T, float>(value, result) ||
+                    read<T, double>(value, result);
+        } else {
+            read<T, T>(value, result);
+        }
+        return result;
+    }
+
+    bool is_nil() const { return !value.has_value(); }
+};
+
+class Dictionary {
+    std::map<String, Variant> entries;
+
+public:
+    Variant &operator[](const String &p_key) { return entries[p_key]; }
+    Variant operator[](const String &p_key) const {
+        auto it = entries.find(p_key);
+        return it == entries.end() ? Variant() : it->second;
+    }
+    bool has(const String &p_key) const { return entries.count(p_key) > 0; }
+    bool is_empty() const { return entries.empty(); }
+    int64_t size() const { return int64_t(entries.size()); }
+};
+
+// Registration: accepted and ignored
+
+struct MethodDefinition {};
+
+template <class... A>
+MethodDefinition D_METHOD(A...) {
+    return {};
+}
+
+struct PropertyInfo {
+    template <class... A>
+    PropertyInfo(A...) {}
+};
+
+struct MethodInfo {
+    template <class... A>
+    MethodInfo(A...) {}
+};
+
+class Object {
+public:
+    virtual ~Object() {}
+    template <class... A>
+    Error emit_signal(const StringName &, A...) { return OK; }
+    template <class... A>
+    Variant call_deferred(const StringName &, A...) { return Variant(); }
+};
+
+class RefCounted : public Object {};
+
+class ClassDB {
+public:
+    template <class M, class... D>
+    static void bind_method(MethodDefinition, M, D...) {}
+    static void add_signal(const MethodInfo &) {}
+    static void bind_integer_constant(const char *, int64_t) {}
+};
+
+class ProjectSettings : public Object {
+public:
+    static ProjectSettings *get_singleton() {
+        static ProjectSettings singleton;
+        return &singleton;
+    }
+    String globalize_path(const String &p_path) const { return p_path; }
+};
+
+// Printing goes to stderr
+
+inline void print_value(const String &p_value) { fputs(p_value.utf8().get_data(), stderr); }
+inline void print_value(const char *p_value) { fputs(p_value, stderr); }
+inline void print_value(int64_t p_value) { fprintf(stderr, "%lld", (long long)p_value); }
+inline void print_value(double p_value) { fprintf(stderr, "%g", p_value); }
+
+class UtilityFunctions {
+public:
+    template <class... A>
+    static void print(const A &...p_args) {
+        (print_value(p_args), ...);
+        fputc('\n', stderr);
+    }
+    template <class... A>
+    static void printerr(const A &...p_args) {
+        print(p_args...);
+    }
+};
+
+}
+
+#define DEFVAL(m_value) (m_value)
+#define GDCLASS(m_class, m_inherits) \
+private:                              \
+    friend class ::godot::ClassDB;    \
+                                      \
+public:                               \
+    typedef m_inherits parent_type;   \
+                                      \
+private:
+#define BIND_ENUM_CONSTANT(m_constant) ::godot::ClassDB::bind_integer_constant(#m_constant, m_constant)
+#define VARIANT_ENUM_CAST(m_enum)
+#define ADD_SIGNAL(m_info) ::godot::ClassDB::add_signal(m_info)
+
+#define ERR_FAIL_COND(m_cond) \
+    if (m_cond) {             \
+        fprintf(stderr, "%s:%d: condition \"%s\" is true\n", __FILE__, __LINE__, #m_cond); \
+        return;               \
+    }
+#define ERR_FAIL_COND_V(m_cond, m_retval) \
+    if (m_cond) {                         \
+        fprintf(stderr, "%s:%d: condition \"%s\" is true\n", __FILE__, __LINE__, #m_cond); \
+        return m_retval;                  \
+    }
+#define ERR_FAIL_INDEX(m_index, m_size) ERR_FAIL_COND((m_index) < 0 || (m_index) >= (m_size))
+#define ERR_FAIL_INDEX_V(m_index, m_size, m_retval) ERR_FAIL_COND_V((m_index) < 0 || (m_index) >= (m_size), m_retval)
+
+#endif // GODOT_RTMIDI_TEST_GODOT_STUB_HPP
@@ -0,0 +1,2 @@
+#pragma once
+#include <godot_cpp/godot_stub.hpp>
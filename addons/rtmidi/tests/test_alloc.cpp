@@ -0,0 +1,189 @@
+// Steady-state input must not touch the heap.
+//
+// Every allocation in the process is counted by replacing operator new
+// and, on glibc, malloc. Batches covering every message kind the input
+// path decodes are pushed through the loopback API into GodotRtMidiIn
+// (midi_batch_callback -> process_event -> commit_staged, on this thread)
+// and drained in between. After a warm-up, sending must not allocate.
+
+#include <RtMidi.h>
+#include "rtmidi_in.h"
+#include "test_util.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using godot::GodotRtMidiIn;
+
+namespace {
+
+std::atomic<bool> counting{ false };
+std::atomic<uint64_t> allocations{ 0 };
+
+void count_allocation() {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t p_size);
+void *__libc_calloc(size_t p_count, size_t p_size);
+void *__libc_realloc(void *p_pointer, size_t p_size);
+
+void *malloc(size_t p_size) {
+    count_allocation();
+    return __libc_malloc(p_size);
+}
+
+void *calloc(size_t p_count, size_t p_size) {
+    count_allocation();
+    return __libc_calloc(p_count, p_size);
+}
+
+void *realloc(void *p_pointer, size_t p_size) {
+    count_allocation();
+    return __libc_realloc(p_pointer, p_size);
+}
+}
+#endif
+
+namespace {
+
+// Out of line, so GCC can't see new paired with free at inlined call
+// sites and warn about mismatched allocation functions
+__attribute__((noinline)) void *counted_malloc(size_t p_size) {
+    count_allocation();
+    void *pointer = std::malloc(p_size ? p_size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+__attribute__((noinline)) void counted_free(void *p_pointer) {
+    std::free(p_pointer);
+}
+
+}
+
+void *operator new(size_t p_size) {
+    return counted_malloc(p_size);
+}
+
+void *operator new[](size_t p_size) {
+    return counted_malloc(p_size);
+}
+
+void operator delete(void *p_pointer) noexcept {
+    counted_free(p_pointer);
+}
+
+void operator delete[](void *p_pointer) noexcept {
+    counted_free(p_pointer);
+}
+
+void operator delete(void *p_pointer, size_t) noexcept {
+    counted_free(p_pointer);
+}
+
+void operator delete[](void *p_pointer, size_t) noexcept {
+    counted_free(p_pointer);
+}
+
+namespace {
+
+const unsigned char SYSEX[] = { 0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7 };
+
+// One batch: notes, 14-bit CC pairs, an NRPN and an RPN sequence, pitch
+// bend, pressure, program change, clock, transport and SysEx
+std::vector<RtMidiEvent> make_batch(uint64_t p_time_ns, int p_round) {
+    std::vector<std::vector<unsigned char>> messages = {
+        { 0xFA },
+        { 0x90, 60, 100 },
+        { 0xB0, 1, (unsigned char)(p_round % 128) },
+        { 0xB0, 33, 5 },
+        { 0xB1, 99, 1 }, { 0xB1, 98, 2 }, { 0xB1, 6, 64 }, { 0xB1, 38, 3 },
+        { 0xB2, 101, 0 }, { 0xB2, 100, 0 }, { 0xB2, 6, 12 },
+        { 0xE0, 0, (unsigned char)(p_round % 128) },
+        { 0xD0, 50 },
+        { 0xA0, 60, 20 },
+        { 0xC0, 7 },
+        { 0xF8 },
+        { 0x80, 60, 0 },
+        { 0xF2, 8, 0 },
+        { 0xFC },
+    };
+
+    std::vector<RtMidiEvent> events;
+    for (const std::vector<unsigned char> &message : messages) {
+        RtMidiEvent event = {};
+        event.timeNs = p_time_ns + events.size() * 1000;
+        event.size = (unsigned int)message.size();
+        std::copy(message.begin(), message.end(), event.bytes);
+        events.push_back(event);
+    }
+    RtMidiEvent sysex = {};
+    sysex.timeNs = p_time_ns + events.size() * 1000;
+    sysex.sysex = SYSEX;
+    sysex.size = sizeof(SYSEX);
+    events.push_back(sysex);
+    return events;
+}
+
+}
+
+int main() {
+    const int WARMUP_ROUNDS = 100;
+    const int ROUNDS = 10000;
+
+    RtMidiOut out(RtMidi::RTMIDI_DUMMY, "test_alloc");
+    out.openVirtualPort("test_alloc out");
+
+    GodotRtMidiIn *in = new GodotRtMidiIn();
+    if (in->set_api("dummy") != godot::OK || in->open_port(0) != godot::OK) {
+        fprintf(stderr, "FAIL: could not open the loopback port\n");
+        return 1;
+    }
+    in->ignore_types(false, false, false);
+    in->set_cc14_pairing(1, true);
+
+    // Built up front: the batches themselves are not under test
+    std::vector<std::vector<RtMidiEvent>> batches;
+    for (int i = 0; i < WARMUP_ROUNDS + ROUNDS; i++) {
+        batches.push_back(make_batch(1000000000ull + uint64_t(i) * 1000000, i));
+    }
+
+    int64_t received = 0;
+    uint64_t events = 0;
+    for (int i = 0; i < WARMUP_ROUNDS + ROUNDS; i++) {
+        counting.store(i >= WARMUP_ROUNDS);
+        out.sendEvents(batches[i].data(), (unsigned int)batches[i].size());
+        counting.store(false);
+        if (i >= WARMUP_ROUNDS) {
+            events += batches[i].size();
+        }
+
+        godot::Dictionary drained = in->drain_messages();
+        received += int64_t(drained["count"]);
+    }
+
+    in->close_port();
+    delete in;
+
+    printf("%llu events after warm-up, %llu allocations, %lld messages drained\n",
+            (unsigned long long)events, (unsigned long long)allocations.load(), (long long)received);
+    if (received == 0) {
+        printf("FAIL: no messages reached the queue\n");
+        return 1;
+    }
+    if (allocations.load() != 0) {
+        printf("FAIL: steady-state input allocated\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
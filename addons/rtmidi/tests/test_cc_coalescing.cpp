@@ -0,0 +1,154 @@
+// Per-frame CC coalescing in GodotRtMidiIn.
+//
+// With set_cc_coalescing(true), a CC whose (channel, controller) still has
+// an unread entry in the controller lane updates that entry: a drain sees
+// the latest value and time of each controller, in the order of its first
+// unread change, and get_coalesced_count() counts the merged messages. An
+// entry the ring dropped on overflow must not swallow later values. The
+// hub's broadcast input refuses coalescing.
+
+#include "rtmidi_in.h"
+#include "test_util.h"
+
+using godot::GodotRtMidiIn;
+
+namespace {
+
+const uint64_t SECOND = 1000000000;
+
+struct Drained {
+    int status;
+    int data1;
+    int data2;
+    double timestamp;
+};
+
+std::vector<Drained> drain(GodotRtMidiIn &p_in) {
+    godot::Dictionary drained = p_in.drain_messages();
+    int64_t count = drained["count"];
+    godot::PackedByteArray bytes = drained["bytes"];
+    godot::PackedFloat64Array timestamps = drained["timestamps"];
+
+    std::vector<Drained> messages;
+    for (int64_t i = 0; i < count; i++) {
+        messages.push_back({ bytes[i * 3], bytes[i * 3 + 1], bytes[i * 3 + 2], timestamps[i] });
+    }
+    return messages;
+}
+
+bool is_cc(const Drained &p_message, int p_channel, int p_controller, int p_value) {
+    return p_message.status == (0xB0 | p_channel) && p_message.data1 == p_controller && p_message.data2 == p_value;
+}
+
+GodotRtMidiIn *open_input(int p_controller_capacity) {
+    GodotRtMidiIn *in = new GodotRtMidiIn();
+    CHECK(in->set_api("dummy") == godot::OK);
+    if (p_controller_capacity > 0) {
+        CHECK(in->set_lane_capacity(GodotRtMidiIn::LANE_CONTROLLERS, p_controller_capacity) == godot::OK);
+    }
+    CHECK(in->set_cc_coalescing(true) == godot::OK);
+    CHECK(in->open_port(0) == godot::OK);
+    return in;
+}
+
+}
+
+int main() {
+    RtMidiOut out(RtMidi::RTMIDI_DUMMY, "test_cc_coalescing");
+    out.openVirtualPort("test_cc_coalescing out");
+
+    GodotRtMidiIn *in = open_input(0);
+    CHECK(in->get_cc_coalescing());
+    CHECK(in->set_cc_coalescing(false) == godot::ERR_ALREADY_IN_USE);
+
+    // Three batches before the main thread drains
+    send_batch(out, {
+        { 1 * SECOND, { 0xB0, 70, 10 } },
+        { 1 * SECOND + 1000, { 0xB0, 71, 5 } },
+        { 1 * SECOND + 2000, { 0xB1, 70, 20 } },
+    });
+    send_batch(out, {
+        { 2 * SECOND, { 0xB0, 70, 30 } },
+        { 2 * SECOND + 1000, { 0x90, 60, 100 } },
+        { 2 * SECOND + 2000, { 0xB0, 70, 40 } },
+    });
+    send_batch(out, { { 3 * SECOND, { 0xB0, 71, 6 } } });
+
+    // The note lane comes first, then one entry per controller with its
+    // latest value and time
+    std::vector<Drained> drained = drain(*in);
+    CHECK(drained.size() == 4);
+    if (drained.size() == 4) {
+        CHECK(drained[0].status == 0x90);
+        CHECK(is_cc(drained[1], 0, 70, 40));
+        CHECK(drained[1].timestamp == (2 * SECOND + 2000) / 1e9);
+        CHECK(is_cc(drained[2], 0, 71, 6));
+        CHECK(drained[2].timestamp == 3.0);
+        CHECK(is_cc(drained[3], 1, 70, 20));
+    }
+    CHECK(in->get_coalesced_count() == 3);
+    CHECK(in->get_cc(0, 70) > 0.3f);  // The state table still sees every value
+
+    // Once read, the next change queues a new entry
+    send_batch(out, { { 4 * SECOND, { 0xB0, 70, 50 } } });
+    drained = drain(*in);
+    CHECK(drained.size() == 1 && is_cc(drained[0], 0, 70, 50));
+    CHECK(in->get_coalesced_count() == 3);
+
+    // Queue depth follows the number of controllers, not the message rate
+    for (int round = 0; round < 100; round++) {
+        std::vector<TestMessage> batch;
+        for (int controller = 64; controller < 96; controller++) {
+            batch.push_back({ 5 * SECOND + uint64_t(round), { 0xB2, (unsigned char)controller, (unsigned char)round } });
+        }
+        send_batch(out, batch);
+    }
+    drained = drain(*in);
+    CHECK(drained.size() == 32);
+    for (size_t i = 0; i < drained.size(); i++) {
+        CHECK(is_cc(drained[i], 2, 64 + int(i), 99));
+    }
+    CHECK(in->get_coalesced_count() == 3 + 32 * 99);
+    CHECK(in->get_dropped_count() == 0);
+
+    in->close_port();
+    delete in;
+
+    // A four-entry lane under OVERFLOW_DROP_OLDEST
+    in = open_input(4);
+    send_batch(out, {
+        { 6 * SECOND, { 0xB0, 80, 1 } },
+        { 6 * SECOND, { 0xB0, 81, 1 } },
+        { 6 * SECOND, { 0xB0, 82, 1 } },
+        { 6 * SECOND, { 0xB0, 83, 1 } },
+        { 6 * SECOND, { 0xB0, 84, 1 } },
+        { 6 * SECOND, { 0xB0, 85, 1 } },
+    });
+    // Overwrites the entry for 82; the next 82 must queue again rather
+    // than merge into the dropped one
+    send_batch(out, { { 7 * SECOND, { 0xB0, 86, 2 } } });
+    send_batch(out, { { 8 * SECOND, { 0xB0, 82, 3 } } });
+    drained = drain(*in);
+    CHECK(drained.size() == 4);
+    if (drained.size() == 4) {
+        CHECK(is_cc(drained[0], 0, 84, 1));
+        CHECK(is_cc(drained[1], 0, 85, 1));
+        CHECK(is_cc(drained[2], 0, 86, 2));
+        CHECK(is_cc(drained[3], 0, 82, 3));
+    }
+    CHECK(in->get_coalesced_count() == 0);
+
+    in->close_port();
+    delete in;
+
+    // The hub's shared input has no controller lane to coalesce in
+    in = new GodotRtMidiIn();
+    in->set_broadcast(std::make_shared<GodotRtMidiIn::Broadcast>(64));
+    CHECK(in->set_cc_coalescing(true) == godot::ERR_UNAVAILABLE);
+    CHECK(!in->get_cc_coalescing());
+    CHECK(in->set_lane_capacity(GodotRtMidiIn::LANE_CONTROLLERS, 16) == godot::ERR_UNAVAILABLE);
+    delete in;
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
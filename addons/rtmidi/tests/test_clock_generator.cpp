@@ -0,0 +1,174 @@
+// MidiClockGenerator timing, transport and stopping.
+//
+// A send that blocks for several periods must not be followed by a burst
+// of catch-up ticks: the clock re-anchors, sends one tick at once and
+// keeps a full period between the ones after it. A tempo change keeps the
+// grid continuous, the next tick one new period after the last. Transport
+// and song position go out just before the tick they were queued for.
+// stop_clock() must return without waiting out the current tick, which is
+// 125 ms at the slowest tempo.
+
+#include "midi_clock_generator.h"
+#include "test_util.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using godot::MidiClockGenerator;
+
+namespace {
+
+const uint64_t MS = 1000000;
+
+struct Recorder {
+    std::vector<uint64_t> ticks;
+    std::atomic<size_t> count{ 0 };
+    size_t stall_at = SIZE_MAX;  // Tick whose send blocks
+    uint64_t stall_ns = 0;
+};
+
+void record(const unsigned char *p_message, size_t p_size, void *p_user_data) {
+    Recorder *recorder = static_cast<Recorder *>(p_user_data);
+    if (p_size != 1 || p_message[0] != 0xF8) return;
+    size_t index = recorder->count.load(std::memory_order_relaxed);
+    if (index < recorder->ticks.size()) {
+        recorder->ticks[index] = MidiClockGenerator::now_ns();
+        recorder->count.store(index + 1, std::memory_order_release);
+    }
+    if (index == recorder->stall_at) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(recorder->stall_ns));
+    }
+}
+
+typedef std::vector<unsigned char> Bytes;
+
+const Bytes CLOCK = { 0xF8 };
+
+// Every message in order, with a command issued from the clock thread
+// right after a given tick so it lands before the next one
+struct Sequence {
+    MidiClockGenerator *generator = nullptr;
+    std::vector<Bytes> messages;
+    std::vector<uint64_t> tick_times;
+    std::atomic<size_t> ticks{ 0 };
+    size_t limit = 0;
+};
+
+const size_t TEMPO_TICK = 8;
+const size_t RESUME_TICK = 40;
+const size_t STOP_TICK = 44;
+const size_t START_TICK = 48;
+const size_t SEQUENCE_TICKS = 56;
+const double NEW_BPM = 120.0;
+
+void sequence(const unsigned char *p_message, size_t p_size, void *p_user_data) {
+    Sequence *sequence = static_cast<Sequence *>(p_user_data);
+    size_t tick = sequence->ticks.load(std::memory_order_relaxed);
+    if (tick >= sequence->limit) return;
+    sequence->messages.emplace_back(p_message, p_message + p_size);
+    if (p_size != 1 || p_message[0] != 0xF8) return;
+
+    sequence->tick_times[tick] = MidiClockGenerator::now_ns();
+    if (tick == TEMPO_TICK) {
+        sequence->generator->set_bpm(NEW_BPM);
+    } else if (tick == RESUME_TICK) {
+        sequence->generator->set_song_position(9);
+        sequence->generator->transport_continue();
+    } else if (tick == STOP_TICK) {
+        sequence->generator->transport_stop();
+    } else if (tick == START_TICK) {
+        sequence->generator->transport_start();
+    }
+    sequence->ticks.store(tick + 1, std::memory_order_release);
+}
+
+// Index of the first message p_bytes, or -1
+int find(const std::vector<Bytes> &p_messages, const Bytes &p_bytes) {
+    for (size_t i = 0; i < p_messages.size(); i++) {
+        if (p_messages[i] == p_bytes) return int(i);
+    }
+    return -1;
+}
+
+}
+
+int main() {
+    // 300 BPM: one tick every 8.33 ms. Tick 10's send blocks for 50 ms,
+    // six periods.
+    Recorder recorder;
+    recorder.ticks.resize(1000);
+    recorder.stall_at = 10;
+    recorder.stall_ns = 50 * MS;
+    double period = 60e9 / (300.0 * MidiClockGenerator::TICKS_PER_BEAT);
+
+    MidiClockGenerator generator(record, &recorder);
+    generator.start_clock(300.0);
+    while (recorder.count.load(std::memory_order_acquire) < 20) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    generator.stop_clock();
+
+    // No burst after the stall: one late tick, then the period again. A
+    // burst would squeeze the five missed ticks into the next few gaps.
+    CHECK(recorder.ticks[11] - recorder.ticks[10] >= 50 * MS);
+    CHECK(recorder.ticks[19] - recorder.ticks[11] > uint64_t(6 * period));
+    CHECK(generator.get_stats().resyncs >= 1);
+
+    // From 300 to 120 BPM after tick 8: the new period counts from tick 8,
+    // and the ticks after it stay on that grid rather than drifting
+    Sequence order;
+    order.tick_times.resize(SEQUENCE_TICKS);
+    order.limit = SEQUENCE_TICKS;
+    MidiClockGenerator order_generator(sequence, &order);
+    order.generator = &order_generator;
+    order_generator.start_clock(300.0);
+    while (order.ticks.load(std::memory_order_acquire) < SEQUENCE_TICKS) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    order_generator.stop_clock();
+
+    double new_period = 60e9 / (NEW_BPM * MidiClockGenerator::TICKS_PER_BEAT);
+    const std::vector<uint64_t> &times = order.tick_times;
+    CHECK(std::abs(double(times[TEMPO_TICK + 1] - times[TEMPO_TICK]) - new_period) < 4 * MS);
+    CHECK(std::abs(double(times[TEMPO_TICK + 24] - times[TEMPO_TICK]) - 24 * new_period) < 4 * MS);
+
+    // Song position, then Continue, then the tick they were queued for;
+    // Start and Stop likewise each come right before a tick
+    const std::vector<Bytes> &messages = order.messages;
+    int resume = find(messages, { 0xF2, 9, 0 });
+    CHECK(resume >= 0);
+    if (resume >= 0 && size_t(resume) + 2 < messages.size()) {
+        CHECK(messages[resume + 1] == Bytes{ 0xFB });
+        CHECK(messages[resume + 2] == CLOCK);
+        // Queued right after tick RESUME_TICK, the last tick before it
+        CHECK(size_t(std::count(messages.begin(), messages.begin() + resume, CLOCK)) == RESUME_TICK + 1);
+    }
+    int stop = find(messages, { 0xFC });
+    int start = find(messages, { 0xFA });
+    CHECK(stop > resume && start > stop);
+    if (stop >= 0 && start >= 0) {
+        CHECK(messages[stop + 1] == CLOCK);
+        CHECK(messages[start + 1] == CLOCK);
+    }
+
+    // Stopping at the slowest tempo returns well inside one tick
+    Recorder slow;
+    slow.ticks.resize(16);
+    MidiClockGenerator slow_generator(record, &slow);
+    slow_generator.start_clock(MidiClockGenerator::MIN_BPM);
+    while (slow.count.load(std::memory_order_acquire) < 2) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t stop_start = MidiClockGenerator::now_ns();
+    slow_generator.stop_clock();
+    uint64_t stop_time = MidiClockGenerator::now_ns() - stop_start;
+    CHECK(stop_time < 20 * MS);
+    CHECK(!slow_generator.is_running());
+
+    // And it starts again after a stop
+    CHECK(slow_generator.start_clock(MidiClockGenerator::MAX_BPM));
+    slow_generator.stop_clock();
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
@@ -0,0 +1,66 @@
+// Priority lanes in GodotRtMidiIn.
+//
+// Only system realtime messages (0xF8-0xFF) go to LANE_REALTIME. A stream
+// of MTC quarter frames, song position and SysEx lands in LANE_SYSTEM, so
+// when it overflows its lane the clock ticks sent with it are all kept and
+// drained first.
+
+#include "rtmidi_in.h"
+#include "test_util.h"
+
+using godot::GodotRtMidiIn;
+
+namespace {
+
+const uint64_t SECOND = 1000000000;
+const int CAPACITY = 8;
+
+}
+
+int main() {
+    RtMidiOut out(RtMidi::RTMIDI_DUMMY, "test_message_lanes");
+    out.openVirtualPort("test_message_lanes out");
+
+    GodotRtMidiIn *in = new GodotRtMidiIn();
+    CHECK(in->set_api("dummy") == godot::OK);
+    in->ignore_types(false, false, false);
+    CHECK(in->set_lane_capacity(GodotRtMidiIn::LANE_REALTIME, CAPACITY) == godot::OK);
+    CHECK(in->set_lane_capacity(GodotRtMidiIn::LANE_SYSTEM, CAPACITY) == godot::OK);
+    CHECK(in->open_port(0) == godot::OK);
+
+    // Two quarter frames per clock, a song position and a SysEx dump: 26
+    // system messages and 8 clocks, each lane holding 8
+    std::vector<TestMessage> batch;
+    batch.push_back({ 1 * SECOND, { 0xF2, 0, 0 } });
+    for (int i = 0; i < CAPACITY; i++) {
+        uint64_t time = 1 * SECOND + uint64_t(i) * 1000;
+        batch.push_back({ time, { 0xF1, (unsigned char)(i << 4) } });
+        batch.push_back({ time, { 0xF8 } });
+        batch.push_back({ time, { 0xF1, (unsigned char)((i << 4) | 1) } });
+    }
+    for (int i = 0; i < 9; i++) {
+        batch.push_back({ 2 * SECOND, { 0xF0, 0x7E, 0x7F, (unsigned char)i, 0xF7 } });
+    }
+    send_batch(out, batch);
+
+    godot::Dictionary drained = in->drain_messages();
+    int64_t count = drained["count"];
+    godot::PackedByteArray bytes = drained["bytes"];
+    CHECK(count == 2 * CAPACITY);
+    int clocks = 0;
+    for (int64_t i = 0; i < count && i < CAPACITY; i++) {
+        clocks += bytes[i * 3] == 0xF8;
+    }
+    CHECK(clocks == CAPACITY);
+    for (int64_t i = CAPACITY; i < count; i++) {
+        CHECK(bytes[i * 3] == 0xF0);  // Oldest system messages dropped first
+    }
+    CHECK(in->get_lane_dropped_count(GodotRtMidiIn::LANE_REALTIME) == 0);
+    CHECK(in->get_lane_dropped_count(GodotRtMidiIn::LANE_SYSTEM) == 1 + 2 * CAPACITY + 9 - CAPACITY);
+
+    in->close_port();
+    delete in;
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
@@ -0,0 +1,84 @@
+// MidiClock tempo and position tracking.
+//
+// Clock ticks with timing noise must lock to the sent tempo with the
+// noise filtered out, follow a tempo jump, and count beats from Start;
+// Stop holds the position, Continue resumes it.
+
+#include "midi_clock.h"
+#include "test_util.h"
+#include <cmath>
+
+using godot::MidiClock;
+
+namespace {
+
+// Deterministic noise in [-p_amplitude, p_amplitude]
+double noise(uint32_t &r_seed, double p_amplitude) {
+    r_seed = r_seed * 1664525u + 1013904223u;
+    return ((r_seed >> 8) / double(1 << 24) * 2.0 - 1.0) * p_amplitude;
+}
+
+double period_of(double p_bpm) {
+    return 60.0 / (p_bpm * MidiClock::TICKS_PER_BEAT);
+}
+
+}
+
+int main() {
+    MidiClock clock;
+    uint32_t seed = 1;
+    CHECK(clock.get_bpm() == 0.0);
+    CHECK(!clock.get_state().playing);
+
+    // 120 BPM with 0.5 ms of jitter, playing from Start
+    double time = 1000.0;
+    CHECK(clock.process(0xFA, time));
+    CHECK(!clock.process(0xF2, time));  // Song position isn't a realtime message
+    for (int i = 0; i < 4 * MidiClock::TICKS_PER_BEAT; i++) {
+        time += period_of(120.0);
+        clock.process(0xF8, time + noise(seed, 0.0005));
+    }
+    MidiClock::State state = clock.get_state();
+    CHECK(state.playing && state.locked);
+    CHECK(std::abs(clock.get_bpm() - 120.0) < 0.5);
+    CHECK(state.jitter < 0.0005);
+    CHECK(state.ref_tick == 4 * MidiClock::TICKS_PER_BEAT - 1);
+    // Between ticks the position interpolates, never more than a tick ahead
+    double beat = clock.get_beat_position(state.ref_time + state.period / 2);
+    CHECK(std::abs(beat - (state.ref_tick + 0.5) / MidiClock::TICKS_PER_BEAT) < 0.01);
+    CHECK(clock.get_beat_position(state.ref_time + 10.0) <= (state.ref_tick + 1.0) / MidiClock::TICKS_PER_BEAT);
+
+    // Stop holds the position while the tempo is still tracked
+    clock.process(0xFC, time);
+    for (int i = 0; i < MidiClock::TICKS_PER_BEAT; i++) {
+        time += period_of(120.0);
+        clock.process(0xF8, time);
+    }
+    CHECK(!clock.get_state().playing);
+    CHECK(clock.get_state().ref_tick == state.ref_tick);
+    clock.process(0xFB, time);
+    time += period_of(120.0);
+    clock.process(0xF8, time);
+    CHECK(clock.get_state().ref_tick == state.ref_tick + 1);
+
+    // A jump to 90 BPM re-acquires within a couple of beats
+    for (int i = 0; i < 2 * MidiClock::TICKS_PER_BEAT; i++) {
+        time += period_of(90.0);
+        clock.process(0xF8, time + noise(seed, 0.0005));
+    }
+    CHECK(clock.get_state().locked);
+    CHECK(std::abs(clock.get_bpm() - 90.0) < 0.5);
+
+    // A long gap is a new clock stream
+    time += 5.0;
+    clock.process(0xF8, time);
+    CHECK(clock.get_bpm() == 0.0);
+    CHECK(!clock.get_state().locked);
+
+    clock.reset();
+    CHECK(clock.get_state().ref_tick == -1);
+    CHECK(clock.get_beat_position(time) == 0.0);
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
@@ -0,0 +1,217 @@
+// Standard MIDI File parsing and playback.
+//
+// A two-track file with a tempo change is written to /tmp. MidiFile must
+// place events on the tempo map and seek to them; MidiFilePlayer must send
+// them at those times, with MIDI clock on the same map. Playing from a
+// position must send a Song Position Pointer that the following clocks
+// agree with, and stopping must release held notes.
+
+#include "midi_file.h"
+#include "test_util.h"
+#include <unistd.h>
+#include <cstdlib>
+#include <mutex>
+
+using godot::MidiClockGenerator;
+using godot::MidiFile;
+using godot::MidiFilePlayer;
+
+namespace {
+
+const uint64_t MS = 1000000;
+const uint64_t SECOND = 1000000000;
+const int PPQ = 96;
+
+typedef std::vector<unsigned char> Bytes;
+
+void append_be(Bytes &r_bytes, uint32_t p_value, int p_size) {
+    for (int i = p_size - 1; i >= 0; i--) {
+        r_bytes.push_back((unsigned char)(p_value >> (i * 8)));
+    }
+}
+
+void append_vlq(Bytes &r_bytes, uint32_t p_value) {
+    Bytes groups;
+    do {
+        groups.insert(groups.begin(), (unsigned char)(p_value & 0x7F));
+        p_value >>= 7;
+    } while (p_value);
+    for (size_t i = 0; i + 1 < groups.size(); i++) {
+        groups[i] |= 0x80;
+    }
+    r_bytes.insert(r_bytes.end(), groups.begin(), groups.end());
+}
+
+void append_track(Bytes &r_file, const Bytes &p_events) {
+    r_file.insert(r_file.end(), { 'M', 'T', 'r', 'k' });
+    append_be(r_file, uint32_t(p_events.size()), 4);
+    r_file.insert(r_file.end(), p_events.begin(), p_events.end());
+}
+
+void append_tempo(Bytes &r_track, uint32_t p_delta, uint32_t p_us_per_quarter) {
+    append_vlq(r_track, p_delta);
+    r_track.insert(r_track.end(), { 0xFF, 0x51, 0x03 });
+    append_be(r_track, p_us_per_quarter, 3);
+}
+
+void append_event(Bytes &r_track, uint32_t p_delta, const Bytes &p_message) {
+    append_vlq(r_track, p_delta);
+    r_track.insert(r_track.end(), p_message.begin(), p_message.end());
+}
+
+// 600 BPM (100 ms a beat) for four beats, then 1200 BPM. Notes at ticks
+// 0-96, 384 (400 ms) and 480 (450 ms); the last is never released.
+bool write_file(const std::string &p_path) {
+    Bytes tempo_track;
+    append_tempo(tempo_track, 0, 100000);
+    append_tempo(tempo_track, 4 * PPQ, 50000);
+    append_event(tempo_track, 0, { 0xFF, 0x2F, 0x00 });
+
+    Bytes note_track;
+    append_event(note_track, 0, { 0x90, 60, 100 });
+    append_event(note_track, 96, { 0x80, 60, 0 });
+    append_event(note_track, 288, { 0x90, 62, 100 });
+    append_event(note_track, 96, { 0x90, 64, 100 });
+    append_event(note_track, 48, { 0xFF, 0x2F, 0x00 });
+
+    Bytes file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1, 0, 2 };
+    append_be(file, PPQ, 2);
+    append_track(file, tempo_track);
+    append_track(file, note_track);
+
+    FILE *out = fopen(p_path.c_str(), "wb");
+    if (!out) return false;
+    bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+    return fclose(out) == 0 && written;
+}
+
+struct Sent {
+    uint64_t time_ns;
+    Bytes bytes;
+};
+
+struct Collector {
+    std::mutex mutex;
+    std::vector<Sent> sent;
+};
+
+void collect(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data) {
+    Collector *collector = static_cast<Collector *>(p_user_data);
+    std::lock_guard<std::mutex> lock(collector->mutex);
+    for (unsigned int i = 0; i < p_count; i++) {
+        const unsigned char *data = p_events[i].data();
+        collector->sent.push_back({ p_events[i].timeNs, Bytes(data, data + p_events[i].size) });
+    }
+}
+
+void wait_until_done(MidiFilePlayer &p_player) {
+    uint64_t timeout = MidiClockGenerator::now_ns() + 5 * SECOND;
+    while (p_player.is_playing() && MidiClockGenerator::now_ns() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(!p_player.is_playing());
+}
+
+int find(const std::vector<Sent> &p_sent, const Bytes &p_bytes) {
+    for (size_t i = 0; i < p_sent.size(); i++) {
+        if (p_sent[i].bytes == p_bytes) return int(i);
+    }
+    return -1;
+}
+
+bool near(uint64_t p_a, uint64_t p_b) {
+    return (p_a > p_b ? p_a - p_b : p_b - p_a) < 1000;
+}
+
+}
+
+int main() {
+    std::string path = "/tmp/test_midi_file_" + std::to_string(getpid()) + ".mid";
+    if (!write_file(path)) {
+        printf("FAIL: could not write %s\n", path.c_str());
+        return 1;
+    }
+
+    // Tempo map and seeking
+    MidiFile file;
+    CHECK(file.open(path));
+    CHECK(file.get_track_count() == 2);
+    CHECK(file.get_ppq() == PPQ);
+    CHECK(near(file.tick_to_ns(4 * PPQ), 400 * MS));
+    CHECK(near(file.tick_to_ns(5 * PPQ), 450 * MS));
+    CHECK(near(file.get_length_ns(), 475 * MS));
+    CHECK(std::abs(file.ns_to_tick(425 * MS) - 4.5 * PPQ) < 0.01);
+
+    MidiFile::Cursor cursor = file.seek(1, 420 * MS);
+    MidiFile::Event event;
+    CHECK(file.read_event(1, cursor, event));
+    CHECK(event.tick == 5 * PPQ && event.status == 0x90 && event.data[0] == 64);
+    file.close();
+
+    // Whole file: events on the tempo map, 24 clocks a beat, Stop at the end
+    Collector collector;
+    MidiFilePlayer player(collect, &collector);
+    CHECK(player.open(path));
+    CHECK(player.play());
+    wait_until_done(player);
+
+    std::vector<Sent> sent = collector.sent;
+    CHECK(!sent.empty() && sent.front().bytes == Bytes{ 0xFA });
+    int first = find(sent, { 0x90, 60, 100 });
+    int second = find(sent, { 0x90, 62, 100 });
+    int third = find(sent, { 0x90, 64, 100 });
+    CHECK(first >= 0 && second >= 0 && third >= 0);
+    if (first >= 0 && second >= 0 && third >= 0) {
+        CHECK(near(sent[second].time_ns - sent[first].time_ns, 400 * MS));
+        CHECK(near(sent[third].time_ns - sent[first].time_ns, 450 * MS));
+        int clocks = 0;
+        for (int i = first; i < second; i++) {
+            clocks += sent[i].bytes == Bytes{ 0xF8 };
+        }
+        CHECK(clocks == 4 * 24);
+    }
+    CHECK(find(sent, { 0x80, 64, 0 }) > third);
+    CHECK(!sent.empty() && sent.back().bytes == Bytes{ 0xFC });
+
+    // From 230 ms (2.3 beats): resumes at sixteenth 9 (2.25 beats, 225 ms),
+    // with the first clock there and clock 96 just before the note at beat 4
+    collector.sent.clear();
+    CHECK(player.seek(230 * MS));
+    CHECK(player.play());
+    wait_until_done(player);
+
+    sent = collector.sent;
+    CHECK(sent.size() > 3);
+    if (sent.size() > 3) {
+        CHECK((sent[0].bytes == Bytes{ 0xF2, 9, 0 }));
+        CHECK(sent[1].bytes == Bytes{ 0xFB });
+        CHECK(sent[2].bytes == Bytes{ 0xF8 });
+        CHECK(sent[2].time_ns == sent[0].time_ns);
+    }
+    second = find(sent, { 0x90, 62, 100 });
+    CHECK(second >= 0);
+    if (second >= 0 && sent.size() > 3) {
+        CHECK(near(sent[second].time_ns - sent[0].time_ns, 175 * MS));
+        int clocks = 0;
+        for (int i = 0; i < second; i++) {
+            clocks += sent[i].bytes == Bytes{ 0xF8 };
+        }
+        CHECK(9 * MidiClockGenerator::TICKS_PER_STEP + clocks - 1 == 4 * 24);
+    }
+
+    // Without clock the position is kept as is
+    player.set_send_clock(false);
+    collector.sent.clear();
+    CHECK(player.seek(230 * MS));
+    CHECK(player.play());
+    wait_until_done(player);
+    sent = collector.sent;
+    CHECK(find(sent, { 0xF2, 9, 0 }) < 0 && find(sent, { 0xF8 }) < 0);
+    CHECK((!sent.empty() && sent.front().bytes == Bytes{ 0x90, 62, 100 }));
+
+    player.close();
+    unlink(path.c_str());
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
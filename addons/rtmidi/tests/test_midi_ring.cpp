@@ -0,0 +1,78 @@
+// MidiRing batch consumption.
+//
+// pop_batch() must hand out the oldest entries in order, at most as many
+// as asked for. Against a producer that keeps overwriting, every batch it
+// returns must still be a run of consecutive entries that were never
+// overwritten while being copied. Like test_midi_state, the race part
+// needs the two threads on separate CPUs to catch a regression.
+
+#include "midi_ring.h"
+#include "test_util.h"
+
+using godot::MidiRing;
+
+namespace {
+
+const uint64_t PUSHES = 2000000;
+const int BATCH = 16;
+
+}
+
+int main() {
+    MidiRing<uint64_t> ring(8);
+    uint64_t values[BATCH];
+    CHECK(ring.pop_batch(values, BATCH) == 0);
+
+    // In order, limited by p_max and by what is pending
+    for (uint64_t i = 0; i < 6; i++) {
+        ring.push(i);
+    }
+    CHECK(ring.pop_batch(values, 4) == 4);
+    CHECK(values[0] == 0 && values[3] == 3);
+    CHECK(ring.pop_batch(values, BATCH) == 2);
+    CHECK(values[0] == 4 && values[1] == 5);
+    CHECK(ring.empty());
+
+    // After an overwrite only the newest entries are left
+    uint64_t batch[10] = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    CHECK(ring.push_batch_overwrite(batch, 10) == 2);
+    CHECK(ring.pop_batch(values, BATCH) == 8);
+    CHECK(values[0] == 12 && values[7] == 19);
+
+    // A producer overwriting a small ring as fast as it can
+    ring.reset(64);
+    std::atomic<bool> done{ false };
+    std::thread producer([&]() {
+        uint64_t pushed[BATCH];
+        for (uint64_t next = 1; next <= PUSHES; next += BATCH) {
+            for (int i = 0; i < BATCH; i++) {
+                pushed[i] = next + uint64_t(i);
+            }
+            ring.push_batch_overwrite(pushed, BATCH);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t last = 0;
+    int broken = 0;
+    auto consume = [&]() {
+        size_t count = ring.pop_batch(values, BATCH);
+        for (size_t i = 0; i < count; i++) {
+            broken += values[i] <= last || (i > 0 && values[i] != values[i - 1] + 1);
+            last = values[i];
+        }
+    };
+    while (!done.load(std::memory_order_acquire)) {
+        consume();
+    }
+    producer.join();
+    while (!ring.empty()) {
+        consume();
+    }
+
+    CHECK(broken == 0);
+    CHECK(last == PUSHES);  // A multiple of BATCH
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
@@ -0,0 +1,94 @@
+// MidiState values and change tracking.
+//
+// Values, notes and NRPN/RPN parameters must read back as written. A
+// reader that polls the way MidiController._emit_changed_ccs() does (read
+// get_sequence(), collect get_changed_ccs() since the last one, keep the
+// sequence as the next cursor) must never miss a CC's last change while
+// the MIDI thread keeps writing. The race is timing-dependent, so this
+// part catches a regression reliably only with the two threads on
+// separate CPUs.
+
+#include "midi_state.h"
+#include "test_util.h"
+
+using godot::MidiState;
+
+namespace {
+
+const int WRITES = 2000000;
+const int CONTROLS = 4;  // At the start of the table, so the reader scans them soonest
+
+}
+
+int main() {
+    MidiState *state = new MidiState();
+
+    // Read back
+    CHECK(state->get_sequence() == 0);
+    state->set_cc(2, 7, MidiState::scale7(100));
+    CHECK(state->get_cc(2, 7) == MidiState::scale7(100));
+    CHECK(state->get_cc_sequence(2, 7) == 1);
+    CHECK(state->get_sequence() == 1);
+    state->set_note(3, 60, 127);
+    CHECK(state->get_note(3, 60) == MidiState::MAX_VALUE);
+    state->clear_notes();
+    CHECK(state->get_note(3, 60) == 0);
+    CHECK(state->get_param(false, 0, 1000) == -1);
+    state->set_param(false, 0, 1000, 12345);
+    state->set_param(true, 0, 1000, 42);
+    CHECK(state->get_param(false, 0, 1000) == 12345);
+    CHECK(state->get_param(true, 0, 1000) == 42);
+    CHECK(state->get_sequence() == 4);
+
+    int32_t slots[MidiState::SLOTS];
+    CHECK(state->get_changed_ccs(0, slots, MidiState::SLOTS) == 1 && slots[0] == 2 * 128 + 7);
+    CHECK(state->get_changed_ccs(state->get_sequence(), slots, MidiState::SLOTS) == 0);
+
+    // Polling against a writer: every slot's last reported value must be
+    // its final one once the writer stops and the reader polls once more
+    delete state;
+    state = new MidiState();
+    std::atomic<bool> done{ false };
+    std::thread writer([&]() {
+        for (int i = 1; i <= WRITES; i++) {
+            state->set_cc(0, i % CONTROLS, uint32_t(i) & MidiState::MAX_VALUE);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    // A slot written at or before the cursor must have been reported with
+    // that write; checked before each poll, since a later write to the
+    // same control would hide the miss from the final comparison
+    uint32_t reported[CONTROLS] = {};
+    uint64_t reported_seq[CONTROLS] = {};
+    uint64_t cursor = 0;
+    int missed = 0;
+    auto poll = [&]() {
+        for (int control = 0; control < CONTROLS; control++) {
+            uint64_t written = state->get_cc_sequence(0, control);
+            missed += written <= cursor && written > reported_seq[control];
+        }
+        uint64_t seq = state->get_sequence();
+        if (seq == cursor) return;
+        int count = state->get_changed_ccs(cursor, slots, MidiState::SLOTS);
+        cursor = seq;
+        for (int i = 0; i < count; i++) {
+            reported_seq[slots[i]] = state->get_cc_sequence(0, slots[i]);
+            reported[slots[i]] = state->get_cc(0, slots[i]);
+        }
+    };
+    while (!done.load(std::memory_order_acquire)) {
+        poll();
+    }
+    writer.join();
+    poll();
+
+    CHECK(missed == 0);
+    for (int control = 0; control < CONTROLS; control++) {
+        CHECK(reported[control] == state->get_cc(0, control));
+    }
+    delete state;
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
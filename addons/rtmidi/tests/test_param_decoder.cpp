@@ -0,0 +1,113 @@
+// A held MSB waits for its LSB only until the end of the driver batch.
+//
+// Data Entry and paired CC MSBs sent without an LSB must come out when
+// their batch ends, stamped with the MSB's own arrival time; an LSB in the
+// same batch merges with it, and one in a later batch refines the value.
+
+#include "rtmidi_in.h"
+#include "test_util.h"
+
+using godot::GodotRtMidiIn;
+
+namespace {
+
+const uint64_t SECOND = 1000000000;
+
+struct Merged {
+    int kind;
+    int param;
+    int value;
+    double timestamp;
+};
+
+std::vector<Merged> drain_merged(GodotRtMidiIn &p_in) {
+    godot::Dictionary drained = p_in.drain_messages();
+    int64_t count = drained["count"];
+    godot::PackedByteArray kinds = drained["kinds"];
+    godot::PackedInt32Array params = drained["params"];
+    godot::PackedInt32Array values = drained["values"];
+    godot::PackedFloat64Array timestamps = drained["timestamps"];
+
+    std::vector<Merged> merged;
+    for (int64_t i = 0; i < count; i++) {
+        if (kinds[i] != GodotRtMidiIn::MESSAGE_MIDI) {
+            merged.push_back({ kinds[i], params[i], values[i], timestamps[i] });
+        }
+    }
+    return merged;
+}
+
+}
+
+int main() {
+    RtMidiOut out(RtMidi::RTMIDI_DUMMY, "test_param_decoder");
+    out.openVirtualPort("test_param_decoder out");
+
+    GodotRtMidiIn *in = new GodotRtMidiIn();
+    if (in->set_api("dummy") != godot::OK || in->open_port(0) != godot::OK) {
+        printf("FAIL: could not open the loopback port\n");
+        return 1;
+    }
+    in->set_cc14_pairing(1, true);
+    CHECK(in->get_data_entry_waits_for_lsb());
+
+    // RPN 0 (pitch bend range) set with Data Entry MSB only
+    send_batch(out, {
+        { 1 * SECOND, { 0xB0, 101, 0 } },
+        { 1 * SECOND + 1000, { 0xB0, 100, 0 } },
+        { 1 * SECOND + 2000, { 0xB0, 6, 12 } },
+    });
+    std::vector<Merged> merged = drain_merged(*in);
+    CHECK(merged.size() == 1);
+    if (merged.size() == 1) {
+        CHECK(merged[0].kind == GodotRtMidiIn::MESSAGE_RPN);
+        CHECK(merged[0].param == 0);
+        CHECK(merged[0].value == 12 << 7);
+        CHECK(merged[0].timestamp == (1 * SECOND + 2000) / 1e9);
+    }
+    CHECK(in->get_rpn(0, 0) > 0.0f);
+
+    // Nothing is left to come out with a later message
+    send_batch(out, { { 2 * SECOND, { 0x90, 60, 100 } } });
+    CHECK(drain_merged(*in).empty());
+
+    // MSB and LSB in one batch: one event, timed by the LSB
+    send_batch(out, {
+        { 3 * SECOND, { 0xB0, 6, 12 } },
+        { 3 * SECOND + 1000, { 0xB0, 38, 5 } },
+    });
+    merged = drain_merged(*in);
+    CHECK(merged.size() == 1);
+    if (merged.size() == 1) {
+        CHECK(merged[0].value == (12 << 7 | 5));
+        CHECK(merged[0].timestamp == (3 * SECOND + 1000) / 1e9);
+    }
+
+    // LSB in the next batch: the MSB alone, then the refined value
+    send_batch(out, { { 4 * SECOND, { 0xB0, 6, 13 } } });
+    send_batch(out, { { 4 * SECOND + 1000, { 0xB0, 38, 7 } } });
+    merged = drain_merged(*in);
+    CHECK(merged.size() == 2);
+    if (merged.size() == 2) {
+        CHECK(merged[0].value == 13 << 7);
+        CHECK(merged[0].timestamp == 4.0);
+        CHECK(merged[1].value == (13 << 7 | 7));
+    }
+
+    // Paired CC MSB alone on another channel
+    send_batch(out, { { 5 * SECOND, { 0xB3, 1, 100 } } });
+    merged = drain_merged(*in);
+    CHECK(merged.size() == 1);
+    if (merged.size() == 1) {
+        CHECK(merged[0].kind == GodotRtMidiIn::MESSAGE_CC14);
+        CHECK(merged[0].param == 1);
+        CHECK(merged[0].value == 100 << 7);
+        CHECK(merged[0].timestamp == 5.0);
+    }
+
+    in->close_port();
+    delete in;
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
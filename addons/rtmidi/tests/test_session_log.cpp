@@ -0,0 +1,167 @@
+// Session log recording and playback.
+//
+// GodotRtMidiIn records what the loopback delivers, SysEx included, into a
+// log trimmed to what was written; MidiLogPlayer reads it back with the
+// original bytes and spacing, both as fast as possible and in
+// realtime. Events that no longer fit are counted as dropped, whole.
+
+#include "midi_log.h"
+#include "rtmidi_in.h"
+#include "test_util.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <mutex>
+
+using godot::GodotRtMidiIn;
+using godot::MidiClockGenerator;
+using godot::MidiLogFile;
+using godot::MidiLogHeader;
+using godot::MidiLogPlayer;
+using godot::MidiLogRecord;
+
+namespace {
+
+const uint64_t MS = 1000000;
+const uint64_t SECOND = 1000000000;
+
+struct Played {
+    uint64_t time_ns;
+    uint64_t arrival_ns;
+    std::vector<unsigned char> bytes;
+};
+
+struct Collector {
+    std::mutex mutex;
+    std::vector<Played> events;
+};
+
+void collect(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data) {
+    Collector *collector = static_cast<Collector *>(p_user_data);
+    uint64_t now = MidiClockGenerator::now_ns();
+    std::lock_guard<std::mutex> lock(collector->mutex);
+    for (unsigned int i = 0; i < p_count; i++) {
+        const unsigned char *data = p_events[i].data();
+        collector->events.push_back({ p_events[i].timeNs, now, std::vector<unsigned char>(data, data + p_events[i].size) });
+    }
+}
+
+std::vector<Played> play(const std::string &p_path, bool p_realtime) {
+    Collector collector;
+    MidiLogPlayer player(collect, &collector);
+    CHECK(player.start(p_path, p_realtime));
+    uint64_t timeout = MidiClockGenerator::now_ns() + 5 * SECOND;
+    while (player.is_playing() && MidiClockGenerator::now_ns() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(!player.is_playing());
+    CHECK(player.get_position() == player.get_length());
+    player.stop();
+    return collector.events;
+}
+
+size_t file_size(const std::string &p_path) {
+    struct stat st;
+    return stat(p_path.c_str(), &st) == 0 ? size_t(st.st_size) : 0;
+}
+
+}
+
+int main() {
+    std::string path = "/tmp/test_session_log_" + std::to_string(getpid()) + ".gdmidi";
+
+    RtMidiOut out(RtMidi::RTMIDI_DUMMY, "test_session_log");
+    out.openVirtualPort("test_session_log out");
+
+    GodotRtMidiIn *in = new GodotRtMidiIn();
+    CHECK(in->set_api("dummy") == godot::OK);
+    in->ignore_types(false, false, false);
+    CHECK(in->open_port(0) == godot::OK);
+
+    std::vector<unsigned char> sysex(20);
+    sysex.front() = 0xF0;
+    for (size_t i = 1; i + 1 < sysex.size(); i++) {
+        sysex[i] = (unsigned char)i;
+    }
+    sysex.back() = 0xF7;
+    std::vector<TestMessage> sent = {
+        { 1 * SECOND, { 0x90, 60, 100 } },
+        { 1 * SECOND + 500000, { 0xB0, 7, 90 } },
+        { 1 * SECOND + 1 * MS, { 0xF8 } },
+        { 1 * SECOND + 2 * MS, sysex },
+        { 1 * SECOND + 300 * MS, { 0x80, 60, 0 } },
+    };
+
+    // A note on, a CC, a clock and 20 bytes of SysEx over four records
+    CHECK(in->start_recording(godot::String(path.c_str()), 64) == godot::OK);
+    CHECK(in->is_recording());
+    send_batch(out, { sent[0], sent[1], sent[2] });
+    send_batch(out, { sent[3] });
+    send_batch(out, { sent[4] });
+    in->stop_recording();
+    CHECK(!in->is_recording());
+    CHECK(in->get_recorded_count() == 8);
+    CHECK(in->get_recording_dropped_count() == 0);
+
+    // Nothing recorded after stopping
+    send_batch(out, { { 2 * SECOND, { 0x90, 61, 100 } } });
+    CHECK(in->get_recorded_count() == 8);
+
+    // Header and trimmed size
+    CHECK(file_size(path) == sizeof(MidiLogHeader) + 8 * sizeof(MidiLogRecord));
+    MidiLogFile file;
+    CHECK(file.open_read(path));
+    if (file.is_open()) {
+        const MidiLogHeader *header = reinterpret_cast<const MidiLogHeader *>(file.get_data());
+        CHECK(memcmp(header->magic, "GDMIDLOG", 8) == 0);
+        CHECK(header->count == 8);
+        CHECK(header->capacity == 64);
+        const MidiLogRecord *records = reinterpret_cast<const MidiLogRecord *>(file.get_data() + sizeof(MidiLogHeader));
+        CHECK(records[3].flags & MidiLogRecord::FLAG_CONTINUES);
+        CHECK(!(records[6].flags & MidiLogRecord::FLAG_CONTINUES));
+        CHECK(records[7].time_ns == 1 * SECOND + 300 * MS);
+    }
+    file.close();
+
+    // As fast as possible: same bytes, same spacing, ending about now
+    std::vector<Played> played = play(path, false);
+    CHECK(played.size() == sent.size());
+    if (played.size() == sent.size()) {
+        for (size_t i = 0; i < sent.size(); i++) {
+            CHECK(played[i].bytes == sent[i].bytes);
+            CHECK(played[i].time_ns - played[0].time_ns == sent[i].time_ns - sent[0].time_ns);
+        }
+        CHECK(played.back().arrival_ns - played.front().arrival_ns < 100 * MS);
+    }
+
+    // Realtime: the last event goes out 300 ms after the first
+    played = play(path, true);
+    CHECK(played.size() == sent.size());
+    if (played.size() == sent.size()) {
+        uint64_t span = played.back().arrival_ns - played.front().arrival_ns;
+        CHECK(span >= 299 * MS && span < 400 * MS);
+        CHECK(played.back().time_ns - played.front().time_ns == 300 * MS);
+    }
+
+    // Full: the SysEx needs four records and only two are left, so it is
+    // dropped whole and the note off after it still fits
+    CHECK(in->start_recording(godot::String(path.c_str()), 5) == godot::OK);
+    send_batch(out, { sent[0], sent[1], sent[2] });
+    send_batch(out, { sent[3] });
+    send_batch(out, { sent[4] });
+    in->stop_recording();
+    CHECK(in->get_recorded_count() == 4);
+    CHECK(in->get_recording_dropped_count() == 1);
+    played = play(path, false);
+    CHECK(played.size() == 4);
+    if (played.size() == 4) {
+        CHECK(played[3].bytes == sent[4].bytes);
+    }
+
+    in->close_port();
+    delete in;
+    unlink(path.c_str());
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
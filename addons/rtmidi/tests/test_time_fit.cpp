@@ -0,0 +1,94 @@
+// Clock regression used by GodotRtMidiTimeMap.
+//
+// MidiTimeFit must recover offset and drift between two clocks at large
+// absolute times, hold a 100 ppm drift through 1 ms quantization (Godot's
+// millisecond ticks), start over when a clock jumps, follow a window of
+// recent samples, and convert both ways consistently.
+
+#include "midi_time_fit.h"
+#include "test_util.h"
+#include <cmath>
+
+using godot::MidiTimeFit;
+
+namespace {
+
+const double BOOT = 86400.0 * 30;  // A month of uptime, in seconds
+const double FRAME = 1.0 / 60.0;
+
+}
+
+int main() {
+    MidiTimeFit fit;
+
+    // No samples: the identity
+    CHECK(fit.get_sample_count() == 0);
+    CHECK(fit.to_time(BOOT) == BOOT);
+    CHECK(fit.get_rate() == 1.0);
+
+    // Exact samples: offset and rate to well under a microsecond, even
+    // with a month's worth of seconds in every value
+    for (int i = 0; i < 120; i++) {
+        double reference = BOOT + i * FRAME;
+        fit.add_sample(reference, 12.5 + (reference - BOOT) * 1.0001, 0.05);
+    }
+    CHECK(fit.get_sample_count() == 120);
+    CHECK(std::abs(fit.get_rate() - 1.0001) < 1e-9);
+    CHECK(std::abs(fit.to_time(BOOT + 10.0) - (12.5 + 10.001)) < 1e-6);
+    CHECK(fit.get_residual() < 1e-6);
+
+    // Both directions agree
+    double time = fit.to_time(BOOT + 3.3);
+    CHECK(std::abs(fit.to_reference(time) - (BOOT + 3.3)) < 1e-9);
+
+    // 100 ppm fast, read at 1 ms resolution over a full window of frames:
+    // the drift still shows, and the fit is better than the quantization
+    fit.set_window(MidiTimeFit::MAX_WINDOW);
+    CHECK(fit.get_sample_count() == 0);
+    double last_reference = 0.0;
+    for (int i = 0; i < MidiTimeFit::MAX_WINDOW; i++) {
+        last_reference = BOOT + i * FRAME;
+        double ticks = std::floor((last_reference - BOOT) * 1.0001 * 1000.0) / 1000.0;
+        fit.add_sample(last_reference, ticks, 0.05);
+    }
+    CHECK(std::abs(fit.get_rate() - 1.0001) < 30e-6);
+    CHECK(fit.get_residual() < 0.0005);
+    // Floor quantization reads half a millisecond early on average
+    double truth = (last_reference - BOOT) * 1.0001 - 0.0005;
+    CHECK(std::abs(fit.to_time(last_reference) - truth) < 0.0002);
+
+    // A jump past the limit starts over from the new sample
+    double jumped = fit.to_time(last_reference + FRAME) + 0.2;
+    fit.add_sample(last_reference + FRAME, jumped, 0.05);
+    CHECK(fit.get_sample_count() == 1);
+    CHECK(fit.to_time(last_reference + FRAME) == jumped);
+    CHECK(fit.get_rate() == 1.0);
+
+    // The window slides: after a window of samples at a new rate, the old
+    // one is forgotten
+    fit.set_window(60);
+    CHECK(fit.get_window() == 60);
+    for (int i = 0; i < 60; i++) {
+        fit.add_sample(BOOT + i * FRAME, i * FRAME, 0.05);
+    }
+    for (int i = 60; i < 120; i++) {
+        fit.add_sample(BOOT + i * FRAME, 1.0 + (i - 60) * FRAME * 0.9995, 0.05);
+    }
+    CHECK(std::abs(fit.get_rate() - 0.9995) < 1e-9);
+
+    // Samples too close together to show a rate keep the clocks in step
+    fit.reset();
+    fit.add_sample(BOOT, 5.0, 0.05);
+    fit.add_sample(BOOT, 5.0, 0.05);
+    CHECK(fit.get_rate() == 1.0);
+    CHECK(fit.to_time(BOOT + 1.0) == 6.0);
+
+    // The window is clamped to what the fit can hold
+    fit.set_window(1);
+    CHECK(fit.get_window() == 2);
+    fit.set_window(100000);
+    CHECK(fit.get_window() == MidiTimeFit::MAX_WINDOW);
+
+    printf(test_failures() ? "FAIL\n" : "PASS\n");
+    return test_failures() > 0;
+}
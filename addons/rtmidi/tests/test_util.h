@@ -0,0 +1,127 @@
+#ifndef GODOT_RTMIDI_TEST_UTIL_H
+#define GODOT_RTMIDI_TEST_UTIL_H
+
+#include <RtMidi.h>
+#include "midi_clock_generator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Failed checks are printed and counted; tests return test_failures() > 0
+inline int &test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(m_cond)                                                          \
+    do {                                                                       \
+        if (!(m_cond)) {                                                       \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #m_cond); \
+            test_failures()++;                                                 \
+        }                                                                      \
+    } while (0)
+
+struct TestMessage {
+    uint64_t time_ns;
+    std::vector<unsigned char> bytes;
+};
+
+// Sends p_messages as one batch; on the loopback API the inputs receive it
+// on this thread, stamped with each message's time
+inline void send_batch(RtMidiOut &p_out, const std::vector<TestMessage> &p_messages) {
+    std::vector<RtMidiEvent> events;
+    for (const TestMessage &message : p_messages) {
+        RtMidiEvent event = {};
+        event.timeNs = message.time_ns;
+        event.size = (unsigned int)message.bytes.size();
+        if (event.size <= sizeof(event.bytes)) {
+            std::copy(message.bytes.begin(), message.bytes.end(), event.bytes);
+        } else {
+            event.sysex = message.bytes.data();
+        }
+        events.push_back(event);
+    }
+    p_out.sendEvents(events.data(), (unsigned int)events.size());
+}
+
+// Index of the first port whose name contains p_name, or -1
+inline int find_port(RtMidi &p_midi, const std::string &p_name) {
+    for (unsigned int i = 0; i < p_midi.getPortCount(); i++) {
+        if (p_midi.getPortName(i).find(p_name) != std::string::npos) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+// Prints the median, 90th and 99th percentile and maximum of p_values
+// (nanoseconds) in microseconds, on one line
+inline void print_percentiles(const char *p_label, std::vector<int64_t> p_values) {
+    if (p_values.empty()) {
+        printf("%-28s no samples\n", p_label);
+        return;
+    }
+    std::sort(p_values.begin(), p_values.end());
+    size_t n = p_values.size();
+    auto at = [&](double q) {
+        return p_values[std::min(n - 1, size_t(q * n))] / 1000.0;
+    };
+    printf("%-28s p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f us  (%zu samples)\n",
+            p_label, at(0.5), at(0.9), at(0.99), p_values[n - 1] / 1000.0, n);
+}
+
+// Send-to-receive latency of single messages. Each one is sent after a
+// gap, so the input thread is asleep when it arrives, and the next waits
+// until it has been received. Pass on_batch to setBatchCallback() with the
+// probe as user data.
+struct LatencyProbe {
+    std::atomic<int> received{ 0 };
+    std::atomic<uint64_t> callback_ns{ 0 };
+    std::atomic<uint64_t> stamp_ns{ 0 };
+
+    std::vector<int64_t> to_stamp;     // Send -> driver timestamp
+    std::vector<int64_t> to_callback;  // Send -> batch callback
+    int lost = 0;
+
+    static void on_batch(const RtMidiEvent *p_events, unsigned int p_count, void *p_user_data) {
+        LatencyProbe *probe = static_cast<LatencyProbe *>(p_user_data);
+        probe->callback_ns.store(godot::MidiClockGenerator::now_ns(), std::memory_order_relaxed);
+        probe->stamp_ns.store(p_events[0].timeNs, std::memory_order_relaxed);
+        probe->received.fetch_add(int(p_count), std::memory_order_release);
+    }
+
+    void run(RtMidiOut &p_out, int p_messages, double p_gap_ms) {
+        for (int i = 0; i < p_messages; i++) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(p_gap_ms));
+
+            unsigned char message[3] = { 0x90, 60, (unsigned char)(1 + i % 127) };
+            int expected = received.load(std::memory_order_acquire) + 1;
+            uint64_t sent = godot::MidiClockGenerator::now_ns();
+            p_out.sendMessage(message, sizeof(message));
+
+            uint64_t timeout = sent + 1000000000;
+            while (received.load(std::memory_order_acquire) < expected && godot::MidiClockGenerator::now_ns() < timeout) {
+                std::this_thread::yield();
+            }
+            if (received.load(std::memory_order_acquire) < expected) {
+                lost++;
+                continue;
+            }
+            to_stamp.push_back(int64_t(stamp_ns.load(std::memory_order_relaxed) - sent));
+            to_callback.push_back(int64_t(callback_ns.load(std::memory_order_relaxed) - sent));
+        }
+    }
+
+    void print(const char *p_label) const {
+        printf("%s: %d lost\n", p_label, lost);
+        print_percentiles("  send -> timestamp", to_stamp);
+        print_percentiles("  send -> callback", to_callback);
+    }
+};
+
+#endif // GODOT_RTMIDI_TEST_UTIL_H